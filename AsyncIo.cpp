@@ -0,0 +1,397 @@
+// AsyncIo.cpp
+//*******************************
+// AsyncIo.cpp
+//
+// The io_uring backend maps the submission and completion rings itself
+// (no liburing). Submitters serialize on one mutex to fill an SQE and call
+// io_uring_enter; a single completion thread waits in io_uring_enter for
+// CQEs and runs each request's callback. Threads other than the completion
+// thread wait while the ring already holds sq_entries operations; the
+// completion thread never waits (it is the one that makes room), and
+// IORING_FEAT_NODROP keeps the kernel from dropping a CQE if continuations
+// push the count past the CQ size. Shutdown drains, then posts a NOP with
+// user_data 0 that tells the completion thread to exit.
+//
+// The pool backend runs each operation as one ThreadPool task. A delay
+// is an IORING_OP_TIMEOUT in the ring, and a sleeping task in the pool.
+//
+// Rev 1.1 - 2025-08-25 - delay()
+// Rev 1.0 - 2025-08-20 - Initial version
+//*******************************
+
+#include "AsyncIo.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#ifndef FERRY_NO_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+namespace AsyncIo {
+
+    namespace {
+        enum class Op { Read, Write, Fsync, Delay };
+
+        struct Request {
+            Op op;
+            std::shared_ptr<File> file; // Null for a delay
+            struct iovec buffer;
+            long long offset;          // Microseconds for a delay
+            long long done = 0;        // Bytes transferred so far (short reads)
+            Completion callback;
+        };
+
+        std::atomic<Backend> active{ Backend::None };
+        std::atomic<size_t> pending{ 0 };
+        std::mutex drainLock;
+        std::condition_variable drained;
+
+        // Blocking execution, used by the pool and before init().
+        long long perform(Request& request) {
+            if (request.op == Op::Delay) {
+                std::this_thread::sleep_for(std::chrono::microseconds(request.offset));
+                return 0;
+            }
+            int fd = request.file->fd();
+            if (request.op == Op::Fsync) return ::fsync(fd) == 0 ? 0 : -errno;
+            char* base = static_cast<char*>(request.buffer.iov_base);
+            size_t bytes = request.buffer.iov_len;
+            size_t total = 0;
+            while (total < bytes) {
+                ssize_t got;
+                if (request.op == Op::Read) {
+                    got = ::pread(fd, base + total, bytes - total, static_cast<off_t>(request.offset + total));
+                } else if (request.offset < 0) {
+                    got = ::write(fd, base + total, bytes - total);
+                } else {
+                    got = ::pwrite(fd, base + total, bytes - total, static_cast<off_t>(request.offset + total));
+                }
+                if (got < 0 && errno == EINTR) continue;
+                if (got < 0) return -errno;
+                if (got == 0) break;
+                total += static_cast<size_t>(got);
+            }
+            return static_cast<long long>(total);
+        }
+
+        // Runs the callback and retires the request.
+        void finish(Request* request, long long result) {
+            Completion callback = std::move(request->callback);
+            delete request;
+            if (callback) callback(result);
+            if (pending.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> guard(drainLock);
+                drained.notify_all();
+            }
+        }
+
+        // --- ThreadPool backend ---
+        std::unique_ptr<ThreadPool> pool;
+
+#ifndef FERRY_NO_IO_URING
+        // --- io_uring backend ---
+        const unsigned RING_ENTRIES = 256;
+
+        // The timeout of a delay's SQE. The kernel copies it when it
+        // consumes the SQE, inside submitToRing(), so it can be local there.
+        struct __kernel_timespec delayTimeout(long long micros) {
+            struct __kernel_timespec timeout = {};
+            timeout.tv_sec = micros / 1000000;
+            timeout.tv_nsec = (micros % 1000000) * 1000;
+            return timeout;
+        }
+
+        struct Ring {
+            int fd = -1;
+            unsigned entries = 0;
+            void* rings = nullptr;     // SQ and CQ rings share one mapping
+            size_t ringBytes = 0;
+            io_uring_sqe* sqes = nullptr;
+            size_t sqeBytes = 0;
+            unsigned* sqTail = nullptr;
+            unsigned* sqMask = nullptr;
+            unsigned* sqArray = nullptr;
+            unsigned* cqHead = nullptr;
+            unsigned* cqTail = nullptr;
+            unsigned* cqMask = nullptr;
+            io_uring_cqe* cqes = nullptr;
+        };
+
+        Ring ring;
+        std::thread completionThread;
+        std::mutex submitLock;
+        std::condition_variable roomInRing;
+        unsigned inRing = 0;           // Submitted, CQE not yet reaped
+        thread_local bool onCompletionThread = false;
+
+        int enter(unsigned toSubmit, unsigned minComplete, unsigned flags) {
+            return static_cast<int>(::syscall(__NR_io_uring_enter, ring.fd, toSubmit, minComplete, flags,
+                                              nullptr, 0));
+        }
+
+        void closeRing() {
+            if (ring.sqes) ::munmap(ring.sqes, ring.sqeBytes);
+            if (ring.rings) ::munmap(ring.rings, ring.ringBytes);
+            if (ring.fd >= 0) ::close(ring.fd);
+            ring = Ring();
+        }
+
+        bool openRing() {
+            io_uring_params params;
+            memset(&params, 0, sizeof(params));
+            ring.fd = static_cast<int>(::syscall(__NR_io_uring_setup, RING_ENTRIES, &params));
+            if (ring.fd < 0) return false;
+            // Needed: one mapping for both rings, no dropped CQEs, and
+            // offset -1 meaning "current position" for appends (5.6+).
+            const unsigned required = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_RW_CUR_POS;
+            if ((params.features & required) != required) {
+                closeRing();
+                return false;
+            }
+            ring.entries = params.sq_entries;
+            ring.ringBytes = std::max<size_t>(params.sq_off.array + params.sq_entries * sizeof(unsigned),
+                                              params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+            void* rings = ::mmap(nullptr, ring.ringBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                 ring.fd, IORING_OFF_SQ_RING);
+            if (rings == MAP_FAILED) {
+                closeRing();
+                return false;
+            }
+            ring.rings = rings;
+            ring.sqeBytes = params.sq_entries * sizeof(io_uring_sqe);
+            void* sqes = ::mmap(nullptr, ring.sqeBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                ring.fd, IORING_OFF_SQES);
+            if (sqes == MAP_FAILED) {
+                closeRing();
+                return false;
+            }
+            ring.sqes = static_cast<io_uring_sqe*>(sqes);
+
+            char* base = static_cast<char*>(rings);
+            ring.sqTail = reinterpret_cast<unsigned*>(base + params.sq_off.tail);
+            ring.sqMask = reinterpret_cast<unsigned*>(base + params.sq_off.ring_mask);
+            ring.sqArray = reinterpret_cast<unsigned*>(base + params.sq_off.array);
+            ring.cqHead = reinterpret_cast<unsigned*>(base + params.cq_off.head);
+            ring.cqTail = reinterpret_cast<unsigned*>(base + params.cq_off.tail);
+            ring.cqMask = reinterpret_cast<unsigned*>(base + params.cq_off.ring_mask);
+            ring.cqes = reinterpret_cast<io_uring_cqe*>(base + params.cq_off.cqes);
+            return true;
+        }
+
+        // Queues one SQE and hands it to the kernel. A null `request`
+        // posts the shutdown NOP.
+        void submitToRing(Request* request) {
+            std::unique_lock<std::mutex> guard(submitLock);
+            if (!onCompletionThread) {
+                roomInRing.wait(guard, [] { return inRing < ring.entries; });
+            }
+            inRing++;
+            struct __kernel_timespec timeout = {};
+            if (request != nullptr && request->op == Op::Delay) timeout = delayTimeout(request->offset);
+            unsigned tail = *ring.sqTail;
+            unsigned index = tail & *ring.sqMask;
+            io_uring_sqe& sqe = ring.sqes[index];
+            memset(&sqe, 0, sizeof(sqe));
+            if (request == nullptr) {
+                sqe.opcode = IORING_OP_NOP;
+            } else if (request->op == Op::Delay) {
+                sqe.opcode = IORING_OP_TIMEOUT;
+                sqe.fd = -1;
+                sqe.user_data = reinterpret_cast<uint64_t>(request);
+                sqe.addr = reinterpret_cast<uint64_t>(&timeout);
+                sqe.len = 1;
+                sqe.off = 0; // Complete on the timeout alone, not on a CQE count
+            } else {
+                sqe.fd = request->file->fd();
+                sqe.user_data = reinterpret_cast<uint64_t>(request);
+                if (request->op == Op::Fsync) {
+                    sqe.opcode = IORING_OP_FSYNC;
+                } else {
+                    sqe.opcode = request->op == Op::Read ? IORING_OP_READV : IORING_OP_WRITEV;
+                    sqe.addr = reinterpret_cast<uint64_t>(&request->buffer);
+                    sqe.len = 1;
+                    sqe.off = request->offset < 0 ? static_cast<uint64_t>(-1)
+                                                   : static_cast<uint64_t>(request->offset + request->done);
+                }
+            }
+            ring.sqArray[index] = index;
+            __atomic_store_n(ring.sqTail, tail + 1, __ATOMIC_RELEASE);
+            // Without SQPOLL the kernel consumes the SQE inside this call,
+            // so the SQ never holds more than the one just queued.
+            while (enter(1, 0, 0) < 0) {
+                if (errno != EINTR && errno != EAGAIN && errno != EBUSY) break;
+                std::this_thread::yield();
+            }
+        }
+
+        void completionLoop() {
+            onCompletionThread = true;
+            while (true) {
+                unsigned head = *ring.cqHead;
+                if (head == __atomic_load_n(ring.cqTail, __ATOMIC_ACQUIRE)) {
+                    if (enter(0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) return;
+                    continue;
+                }
+                io_uring_cqe cqe = ring.cqes[head & *ring.cqMask];
+                __atomic_store_n(ring.cqHead, head + 1, __ATOMIC_RELEASE);
+                {
+                    std::lock_guard<std::mutex> guard(submitLock);
+                    inRing--;
+                }
+                roomInRing.notify_one();
+                if (cqe.user_data == 0) return; // Shutdown NOP
+
+                Request* request = reinterpret_cast<Request*>(cqe.user_data);
+                long long result = cqe.res;
+                if (request->op == Op::Delay) {
+                    finish(request, 0); // -ETIME is the timeout expiring
+                    continue;
+                }
+                // A short transfer is continued from where it stopped, as
+                // the blocking loop in perform() would.
+                if (request->op != Op::Fsync && result > 0 &&
+                    static_cast<size_t>(result) < request->buffer.iov_len) {
+                    request->done += result;
+                    request->buffer.iov_base = static_cast<char*>(request->buffer.iov_base) + result;
+                    request->buffer.iov_len -= static_cast<size_t>(result);
+                    submitToRing(request);
+                    continue;
+                }
+                if (result >= 0) result += request->done;
+                finish(request, result);
+            }
+        }
+#endif
+
+        void submit(Request* request) {
+            pending++;
+            switch (active.load()) {
+#ifndef FERRY_NO_IO_URING
+            case Backend::IoUring:
+                submitToRing(request);
+                break;
+#endif
+            case Backend::ThreadPool:
+                pool->submit([request] { finish(request, perform(*request)); });
+                break;
+            default:
+                finish(request, perform(*request));
+                break;
+            }
+        }
+
+        Request* makeRequest(Op op, std::shared_ptr<File> file, void* buffer, size_t bytes, long long offset,
+                             Completion done) {
+            Request* request = new Request;
+            request->op = op;
+            request->file = std::move(file);
+            request->buffer.iov_base = buffer;
+            request->buffer.iov_len = bytes;
+            request->offset = offset;
+            request->callback = std::move(done);
+            return request;
+        }
+    }
+
+    // --- File ---
+    std::shared_ptr<File> File::open(const char* path, int flags) {
+        int descriptor = ::open(path, flags | O_CLOEXEC, 0644);
+        if (descriptor < 0) return nullptr;
+        return std::shared_ptr<File>(new File(descriptor));
+    }
+
+    File::~File() {
+        ::close(descriptor);
+    }
+
+    long long File::size() const {
+        struct stat info;
+        if (::fstat(descriptor, &info) != 0) return 0;
+        return static_cast<long long>(info.st_size);
+    }
+
+    // --- Backend control ---
+    Backend init(Backend preferred, size_t threads) {
+        if (active.load() != Backend::None) return active.load();
+#ifndef FERRY_NO_IO_URING
+        if (preferred == Backend::IoUring && openRing()) {
+            completionThread = std::thread(completionLoop);
+            active = Backend::IoUring;
+            return Backend::IoUring;
+        }
+#endif
+        if (preferred == Backend::None) return Backend::None;
+        pool = std::make_unique<ThreadPool>(threads);
+        active = Backend::ThreadPool;
+        return Backend::ThreadPool;
+    }
+
+    void shutdown() {
+        Backend current = active.load();
+        if (current == Backend::None) return;
+        drain();
+#ifndef FERRY_NO_IO_URING
+        if (current == Backend::IoUring) {
+            submitToRing(nullptr);
+            completionThread.join();
+            closeRing();
+            inRing = 0;
+        }
+#endif
+        pool.reset();
+        active = Backend::None;
+    }
+
+    Backend backend() {
+        return active.load();
+    }
+
+    const char* backendName(Backend backend) {
+        switch (backend) {
+        case Backend::IoUring:    return "io_uring";
+        case Backend::ThreadPool: return "thread pool";
+        default:                  return "synchronous";
+        }
+    }
+
+    // --- Operations ---
+    void read(std::shared_ptr<File> file, void* buffer, size_t bytes, long long offset, Completion done) {
+        submit(makeRequest(Op::Read, std::move(file), buffer, bytes, offset, std::move(done)));
+    }
+
+    void write(std::shared_ptr<File> file, const void* buffer, size_t bytes, long long offset, Completion done) {
+        // Never written through; the kernel only reads from it.
+        submit(makeRequest(Op::Write, std::move(file), const_cast<void*>(buffer), bytes, offset < 0 ? -1 : offset,
+                           std::move(done)));
+    }
+
+    void fsync(std::shared_ptr<File> file, Completion done) {
+        submit(makeRequest(Op::Fsync, std::move(file), nullptr, 0, 0, std::move(done)));
+    }
+
+    void delay(long long micros, Completion done) {
+        submit(makeRequest(Op::Delay, nullptr, nullptr, 0, std::max(micros, 0LL), std::move(done)));
+    }
+
+    size_t inFlight() {
+        return pending.load();
+    }
+
+    void drain() {
+        std::unique_lock<std::mutex> guard(drainLock);
+        drained.wait(guard, [] { return pending.load() == 0; });
+    }
+}
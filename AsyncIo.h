@@ -0,0 +1,102 @@
+// AsyncIo.h
+//******************************************************************
+// DEFINITION MODULE: AsyncIo
+//
+// PURPOSE:          Asynchronous positioned file I/O for the storage
+//                   layer. An operation is submitted with a completion
+//                   callback and the submitting thread carries on; the
+//                   callback runs once the kernel has finished it, and
+//                   may submit the next step (a continuation), so a few
+//                   threads can keep many reads, writes and fsyncs in
+//                   flight instead of each blocking on its own disk wait.
+//
+//                   Two backends:
+//                     IoUring     - one io_uring instance, driven with the
+//                                   raw system calls, and one completion
+//                                   thread that runs every callback.
+//                     ThreadPool  - a pool of workers doing blocking
+//                                   pread/pwrite/fsync; used when io_uring
+//                                   is not requested, not compiled in
+//                                   (FERRY_NO_IO_URING) or refused by the
+//                                   kernel (old kernel, seccomp policy).
+//                   Before init() (and after shutdown()) operations run
+//                   synchronously on the calling thread, so callers never
+//                   need to know whether a backend is running.
+//
+//                   Callbacks must not block waiting for other AsyncIo
+//                   operations: with io_uring they all share one thread.
+//                   Something that has to wait (a busy file lock) polls
+//                   with delay() instead.
+//
+// (* Revision History:
+//   Rev. 1.1 - 2025/08/25 - Added delay()
+//   Rev. 1.0 - 2025/08/20 - Initial version
+// *)
+//******************************************************************
+#ifndef ASYNC_IO_H
+#define ASYNC_IO_H
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+namespace AsyncIo {
+
+    enum class Backend { None, IoUring, ThreadPool };
+
+    // Bytes transferred (0 for fsync), or -errno on failure.
+    using Completion = std::function<void(long long result)>;
+
+    // An open descriptor shared by the operations using it; closed when
+    // the last reference (typically held by a pending callback) goes.
+    class File {
+    public:
+        // Null if the file could not be opened. `flags` as for open(2).
+        static std::shared_ptr<File> open(const char* path, int flags);
+        ~File();
+        File(const File&) = delete;
+        File& operator=(const File&) = delete;
+
+        int fd() const { return descriptor; }
+        // Current size in bytes (fstat), 0 on error.
+        long long size() const;
+
+    private:
+        explicit File(int descriptor) : descriptor(descriptor) {}
+        int descriptor;
+    };
+
+    //-----------
+    // Starts a backend: `preferred` if it can run, else ThreadPool.
+    // `threads` sizes the ThreadPool backend. Returns the backend started.
+    Backend init(Backend preferred = Backend::IoUring, size_t threads = 4);
+    //-----------
+    // Waits for every operation (and continuation) in flight, then stops.
+    void shutdown();
+    //-----------
+    Backend backend();
+    //-----------
+    const char* backendName(Backend backend);
+    //-----------
+    // Reads `bytes` at `offset` into `buffer`. Short reads are retried,
+    // so less than `bytes` means end of file.
+    void read(std::shared_ptr<File> file, void* buffer, size_t bytes, long long offset, Completion done);
+    //-----------
+    // Writes `bytes` at `offset`; an `offset` of -1 appends (the file must
+    // be opened with O_APPEND). `buffer` must stay valid until `done`.
+    void write(std::shared_ptr<File> file, const void* buffer, size_t bytes, long long offset, Completion done);
+    //-----------
+    void fsync(std::shared_ptr<File> file, Completion done);
+    //-----------
+    // Calls `done(0)` once at least `micros` microseconds have passed.
+    // With io_uring no thread waits meanwhile.
+    void delay(long long micros, Completion done);
+    //-----------
+    // Operations submitted whose callbacks have not finished.
+    size_t inFlight();
+    //-----------
+    // Blocks until inFlight() is 0. Must not be called from a callback.
+    void drain();
+}
+
+#endif // ASYNC_IO_H
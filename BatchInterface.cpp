@@ -0,0 +1,424 @@
+// BatchInterface.cpp
+//******************************************************************
+// IMPLEMENTATION MODULE: BatchInterface
+//
+// PURPOSE: Implements the scripted command mode. Each command line is
+//          tokenized, validated with the same rules the interactive
+//          UserInterface applies, and dispatched to the Controller.
+//          Results are collected in a large output buffer so thousands
+//          of commands cost only a handful of writes to the output stream.
+//
+// Rev 1.12 - 2025/08/25 cancel checks the reservation is on the named sailing
+// Rev 1.11 - 2025/08/23 Report mode served from ReportReplica
+// Rev 1.10 - 2025/08/21 explain reports preallocations
+// Rev 1.9 - 2025/08/14 Added earliest command
+// Rev 1.8 - 2025/08/13 Added waitlist commands, cancel reports promotions
+// Rev 1.7 - 2025/08/12 reserve reports the assigned lane, added lanes command
+// Rev 1.6 - 2025/08/11 Added checkin-batch command
+// Rev 1.5 - 2025/08/09 Added vessel-capacity command
+// Rev 1.4 - 2025/08/08 Added top-capacity command
+// Rev 1.3 - 2025/08/07 Report active session to Metrics
+// Rev 1.2 - 2025/08/06 Added explain command
+// Rev 1.1 - 2025/08/05 Added metrics command
+// Rev 1.0 - 2025/08/02 Initial
+//******************************************************************
+
+#include "BatchInterface.h"
+#include "Controller.h"
+#include "IdDictionary.h"
+#include "Metrics.h"
+#include "ReportReplica.h"
+#include "Utility.h"
+#include <string>
+#include <vector>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+namespace BatchInterface {
+
+    namespace {
+        const size_t MAX_ID_LENGTH = 20;
+        const size_t FLUSH_THRESHOLD = 64 * 1024; // Bytes buffered before writing out
+
+        // Buffered writer for result lines. Fields are tab separated.
+        class ResultWriter {
+        public:
+            explicit ResultWriter(ostream& out) : out(out) {
+                buffer.reserve(FLUSH_THRESHOLD * 2);
+            }
+            ~ResultWriter() { flush(); }
+
+            void begin(const char* status, int lineNo, const string& command) {
+                buffer += status;
+                buffer += '\t';
+                buffer += to_string(lineNo);
+                buffer += '\t';
+                buffer += command;
+            }
+            ResultWriter& field(const string& value) {
+                buffer += '\t';
+                buffer += value;
+                return *this;
+            }
+            ResultWriter& field(double value) {
+                ostringstream ss;
+                ss << value;
+                return field(ss.str());
+            }
+            void end() {
+                buffer += '\n';
+                if (buffer.size() >= FLUSH_THRESHOLD) flush();
+            }
+            void flush() {
+                if (buffer.empty()) return;
+                out.write(buffer.data(), static_cast<streamsize>(buffer.size()));
+                out.flush();
+                buffer.clear();
+            }
+
+        private:
+            ostream& out;
+            string buffer;
+        };
+
+        // Splits a command line into tokens. Double quotes group words.
+        vector<string> tokenize(const string& line) {
+            vector<string> tokens;
+            string current;
+            bool inQuotes = false;
+            bool hasToken = false;
+            for (char c : line) {
+                if (c == '"') {
+                    inQuotes = !inQuotes;
+                    hasToken = true;
+                } else if (!inQuotes && (c == ' ' || c == '\t' || c == '\r')) {
+                    if (hasToken) {
+                        tokens.push_back(current);
+                        current.clear();
+                        hasToken = false;
+                    }
+                } else {
+                    current += c;
+                    hasToken = true;
+                }
+            }
+            if (hasToken) tokens.push_back(current);
+            return tokens;
+        }
+
+        // Thrown for any command that cannot be carried out; the message
+        // becomes the ERR line's payload.
+        struct CommandError : runtime_error {
+            using runtime_error::runtime_error;
+        };
+
+        void requireArgs(const vector<string>& args, size_t minCount, size_t maxCount) {
+            if (args.size() - 1 < minCount || args.size() - 1 > maxCount) {
+                throw CommandError("wrong number of arguments");
+            }
+        }
+
+        void requireId(const string& id, const char* what) {
+            if (id.empty() || id.length() > MAX_ID_LENGTH) {
+                throw CommandError(string(what) + " must be 1-20 characters");
+            }
+        }
+
+        double parseNumber(const string& input, double low, double high, const char* what) {
+            try {
+                size_t idx;
+                double value = stod(input, &idx);
+                if (idx == input.length() && value >= low && value <= high) return value;
+            } catch (...) {
+            }
+            ostringstream ss;
+            ss << what << " must be a number between " << low << " and " << high;
+            throw CommandError(ss.str());
+        }
+
+        void writeSailing(ResultWriter& writer, const char* status, int lineNo, const string& command,
+                          const Sailing::SailingEntity& s) {
+            writer.begin(status, lineNo, command);
+            writer.field(s.sailingID).field(s.vesselID).field(s.LRL).field(s.HRL);
+            writer.end();
+        }
+
+        void writeWaitlistEntry(ResultWriter& writer, int lineNo, const string& command,
+                                const Waitlist::WaitlistEntity& entry) {
+            writer.begin("OK", lineNo, command);
+            writer.field(entry.sailingID).field(entry.vehiclePlate)
+                  .field(entry.vehicleClass ? "oversize" : "regular")
+                  .field(to_string(entry.sequence)).field(to_string(entry.requestTime));
+            writer.end();
+        }
+
+        // Executes one tokenized command. Returns false if the script should stop.
+        bool execute(const vector<string>& args, int lineNo, ResultWriter& writer) {
+            const string& command = args[0];
+
+            if (command == "exit" || command == "quit") {
+                return false;
+            }
+            if (command == "explain") {
+                // Runs the wrapped command, then reports the file I/O it caused.
+                if (args.size() < 2) throw CommandError("wrong number of arguments");
+                Utility::IoStats before = Utility::ioStats();
+                bool keepGoing = execute(vector<string>(args.begin() + 1, args.end()), lineNo, writer);
+                Utility::IoStats delta = Utility::ioStats() - before;
+                for (size_t i = 0; i < Utility::ENTITY_COUNT; i++) {
+                    const Utility::IoCounters& c = delta.files[i];
+                    if (c.empty()) continue;
+                    writer.begin("ROW", lineNo, command);
+                    writer.field(Utility::entityFileName(i)).field(to_string(c.opens))
+                          .field(to_string(c.seeks)).field(to_string(c.recordsScanned))
+                          .field(to_string(c.bytesRead)).field(to_string(c.bytesWritten))
+                          .field(to_string(c.truncates)).field(to_string(c.fsyncs))
+                          .field(to_string(c.preallocations));
+                    writer.end();
+                }
+                return keepGoing;
+            }
+            if (command == "vessel-create") {
+                requireArgs(args, 3, 3);
+                requireId(args[1], "vessel ID");
+                double lcll = parseNumber(args[2], 1.0, 3600.0, "LCLL");
+                double hcll = parseNumber(args[3], 1.0, 3600.0, "HCLL");
+                if (Controller::checkVesselExists(args[1])) throw CommandError("vessel already exists");
+                Controller::createNewVessel(args[1], lcll, hcll);
+                writer.begin("OK", lineNo, command);
+                writer.field(args[1]).end();
+            } else if (command == "sailing-create") {
+                requireArgs(args, 2, 2);
+                requireId(args[2], "sailing ID");
+                if (!Controller::checkVesselExists(args[1])) throw CommandError("vessel does not exist");
+                if (Controller::checkSailingExists(args[2])) throw CommandError("sailing already exists");
+                Controller::createNewSailing(args[1], args[2]);
+                writer.begin("OK", lineNo, command);
+                writer.field(args[2]).end();
+            } else if (command == "sailing-delete") {
+                requireArgs(args, 1, 1);
+                if (!Controller::checkSailingExists(args[1])) throw CommandError("sailing does not exist");
+                Controller::deleteSailing(args[1]);
+                writer.begin("OK", lineNo, command);
+                writer.field(args[1]).end();
+            } else if (command == "vehicle-create") {
+                requireArgs(args, 4, 4);
+                requireId(args[1], "license plate");
+                double length = parseNumber(args[3], 0.1, 999.9, "length");
+                double height = parseNumber(args[4], 0.1, 9.9, "height");
+                if (Controller::checkVehicleExists(args[1])) throw CommandError("vehicle already exists");
+                Controller::createNewVehicle(args[1], args[2], length, height);
+                writer.begin("OK", lineNo, command);
+                writer.field(args[1]).end();
+            } else if (command == "reserve") {
+                if (args.size() != 3 && args.size() != 6) throw CommandError("wrong number of arguments");
+                requireId(args[2], "license plate");
+                if (!Controller::checkSailingExists(args[1])) throw CommandError("sailing does not exist");
+                if (Controller::checkReservationExists(args[2])) throw CommandError("vehicle already has a reservation");
+                if (!Controller::checkVehicleExists(args[2])) {
+                    if (args.size() != 6) throw CommandError("unknown vehicle, phone/length/height required");
+                    double length = parseNumber(args[4], 0.1, 999.9, "length");
+                    double height = parseNumber(args[5], 0.1, 9.9, "height");
+                    Controller::createNewVehicle(args[2], args[3], length, height);
+                }
+                if (!Controller::createNewReservation(args[1], args[2])) {
+                    throw CommandError("not enough space remaining");
+                }
+                auto reservation = Controller::getReservation(args[2]).value();
+                writer.begin("OK", lineNo, command);
+                writer.field(args[1]).field(args[2])
+                      .field(reservation.deck ? "high" : "low").field(to_string(reservation.lane)).end();
+            } else if (command == "cancel") {
+                requireArgs(args, 2, 2);
+                if (!Controller::checkSailingExists(args[1])) throw CommandError("sailing does not exist");
+                auto reservation = Controller::getReservation(args[2]);
+                if (!reservation) throw CommandError("no reservation for vehicle");
+                if (IdDictionary::name(reservation->sailingKey) != args[1]) {
+                    throw CommandError("no reservation for vehicle on sailing");
+                }
+                auto promoted = Controller::cancelReservation(args[1], args[2]);
+                for (const auto& plate : promoted) {
+                    writer.begin("ROW", lineNo, command);
+                    writer.field("promoted").field(plate).end();
+                }
+                writer.begin("OK", lineNo, command);
+                writer.field(args[1]).field(args[2]).end();
+            } else if (command == "waitlist") {
+                requireArgs(args, 2, 2);
+                if (!Controller::checkSailingExists(args[1])) throw CommandError("sailing does not exist");
+                if (!Controller::checkVehicleExists(args[2])) throw CommandError("vehicle does not exist");
+                if (Controller::checkReservationExists(args[2])) throw CommandError("vehicle already has a reservation");
+                if (!Controller::joinWaitlist(args[1], args[2])) throw CommandError("vehicle is already waitlisted");
+                writeWaitlistEntry(writer, lineNo, command, Controller::getWaitlistEntry(args[2]).value());
+            } else if (command == "waitlist-leave") {
+                requireArgs(args, 1, 1);
+                if (!Controller::leaveWaitlist(args[1])) throw CommandError("vehicle is not waitlisted");
+                writer.begin("OK", lineNo, command);
+                writer.field(args[1]).end();
+            } else if (command == "waitlist-status") {
+                requireArgs(args, 1, 1);
+                auto entry = Controller::getWaitlistEntry(args[1]);
+                if (!entry) throw CommandError("vehicle is not waitlisted");
+                writeWaitlistEntry(writer, lineNo, command, *entry);
+            } else if (command == "checkin") {
+                requireArgs(args, 1, 1);
+                if (!Controller::checkReservationExists(args[1])) throw CommandError("no reservation for vehicle");
+                Controller::checkInVehicle(args[1]);
+                writer.begin("OK", lineNo, command);
+                writer.field(args[1]).end();
+            } else if (command == "checkin-batch") {
+                if (args.size() < 2) throw CommandError("wrong number of arguments");
+                vector<string> plates(args.begin() + 1, args.end());
+                auto missing = Controller::checkInVehicles(plates);
+                for (const auto& plate : missing) {
+                    writer.begin("ROW", lineNo, command);
+                    writer.field("missing").field(plate).end();
+                }
+                writer.begin("OK", lineNo, command);
+                writer.field(to_string(plates.size() - missing.size())).field(to_string(missing.size())).end();
+            } else if (command == "lanes") {
+                requireArgs(args, 1, 1);
+                if (!Controller::checkSailingExists(args[1])) throw CommandError("sailing does not exist");
+                auto lanes = Controller::getLaneOccupancy(args[1]);
+                for (const auto& lane : lanes) {
+                    writer.begin("ROW", lineNo, command);
+                    writer.field(lane.deck == LaneAllocator::Deck::High ? "high" : "low")
+                          .field(to_string(lane.lane)).field(lane.capacity)
+                          .field(lane.used).field(to_string(lane.vehicles)).end();
+                }
+                writer.begin("OK", lineNo, command);
+                writer.field(to_string(lanes.size())).end();
+            } else if (command == "earliest") {
+                requireArgs(args, 3, 4);
+                double length = parseNumber(args[2], 0.1, 999.9, "length");
+                double height = parseNumber(args[3], 0.1, 9.9, "height");
+                auto sailing = Controller::findEarliestFittingSailing(args[1], length, height,
+                                                                      args.size() == 5 ? args[4] : "");
+                if (!sailing) throw CommandError("no sailing on route has room");
+                writeSailing(writer, "OK", lineNo, command, *sailing);
+            } else if (command == "query") {
+                requireArgs(args, 1, 1);
+                if (!Controller::checkSailingExists(args[1])) throw CommandError("sailing does not exist");
+                writeSailing(writer, "OK", lineNo, command, Controller::queryIndividualSailing(args[1]));
+            } else if (command == "report") {
+                requireArgs(args, 0, 1);
+                int offset = args.size() == 2 ? static_cast<int>(parseNumber(args[1], 0, 2147483647.0, "offset")) : 0;
+                auto sailings = Controller::getSailingReport(offset);
+                for (const auto& s : sailings) {
+                    writeSailing(writer, "ROW", lineNo, command, s);
+                }
+                writer.begin("OK", lineNo, command);
+                writer.field(to_string(sailings.size())).end();
+            } else if (command == "top-capacity") {
+                requireArgs(args, 2, 3);
+                CapacityIndex::Lane lane;
+                if (args[1] == "LRL" || args[1] == "lrl") lane = CapacityIndex::Lane::Low;
+                else if (args[1] == "HRL" || args[1] == "hrl") lane = CapacityIndex::Lane::High;
+                else throw CommandError("lane must be LRL or HRL");
+                int k = static_cast<int>(parseNumber(args[2], 1, 1000000, "k"));
+                auto sailings = Controller::getTopSailingsByCapacity(lane, k, args.size() == 4 ? args[3] : "");
+                for (const auto& s : sailings) {
+                    writeSailing(writer, "ROW", lineNo, command, s);
+                }
+                writer.begin("OK", lineNo, command);
+                writer.field(to_string(sailings.size())).end();
+            } else if (command == "vessel-capacity") {
+                requireArgs(args, 1, 1);
+                if (!Controller::checkVesselExists(args[1])) throw CommandError("vessel does not exist");
+                auto totals = Controller::getVesselCapacitySummary(args[1]);
+                writer.begin("OK", lineNo, command);
+                writer.field(args[1]).field(to_string(totals.sailings))
+                      .field(totals.remainingLRL).field(totals.bookedLRL())
+                      .field(totals.remainingHRL).field(totals.bookedHRL());
+                writer.end();
+            } else if (command == "metrics") {
+                requireArgs(args, 0, 0);
+                auto rows = Metrics::summaries();
+                for (const auto& row : rows) {
+                    writer.begin("ROW", lineNo, command);
+                    writer.field(Metrics::operationName(row.op)).field(to_string(row.count))
+                          .field(row.meanUs).field(row.p50Us).field(row.p99Us)
+                          .field(row.p999Us).field(row.maxUs);
+                    writer.end();
+                }
+                writer.begin("OK", lineNo, command);
+                writer.field(to_string(rows.size())).end();
+            } else {
+                throw CommandError("unknown command");
+            }
+            return true;
+        }
+
+        // Executes one tokenized command in report mode. Returns false if
+        // the script should stop.
+        bool executeReport(const vector<string>& args, int lineNo, ResultWriter& writer) {
+            const string& command = args[0];
+
+            if (command == "exit" || command == "quit") {
+                return false;
+            }
+            if (command == "query") {
+                requireArgs(args, 1, 1);
+                auto sailing = ReportReplica::queryIndividualSailing(args[1]);
+                if (!sailing) throw CommandError("sailing does not exist");
+                writeSailing(writer, "OK", lineNo, command, *sailing);
+            } else if (command == "report") {
+                requireArgs(args, 0, 1);
+                int offset = args.size() == 2 ? static_cast<int>(parseNumber(args[1], 0, 2147483647.0, "offset")) : 0;
+                auto sailings = ReportReplica::getSailingReport(offset);
+                for (const auto& s : sailings) {
+                    writeSailing(writer, "ROW", lineNo, command, s);
+                }
+                writer.begin("OK", lineNo, command);
+                writer.field(to_string(sailings.size())).end();
+            } else if (command == "replica") {
+                requireArgs(args, 0, 0);
+                ReportReplica::Stats stats = ReportReplica::stats();
+                writer.begin("OK", lineNo, command);
+                writer.field(to_string(stats.reads)).field(to_string(stats.retries))
+                      .field(to_string(stats.fallbacks)).field(to_string(stats.remaps)).end();
+            } else {
+                throw CommandError("not available in report mode");
+            }
+            return true;
+        }
+
+        template <typename Execute>
+        int runCommands(std::istream& in, ResultWriter& writer, Execute execute) {
+            int failures = 0;
+            int lineNo = 0;
+            string line;
+
+            while (getline(in, line)) {
+                lineNo++;
+                vector<string> args = tokenize(line);
+                if (args.empty() || args[0][0] == '#') continue;
+
+                try {
+                    if (!execute(args, lineNo, writer)) break;
+                } catch (const exception& e) {
+                    failures++;
+                    writer.begin("ERR", lineNo, args[0]);
+                    writer.field(e.what()).end();
+                }
+            }
+            writer.flush();
+            return failures;
+        }
+    }
+
+    int run(std::istream& in, std::ostream& out) {
+        ResultWriter writer(out);
+        Metrics::sessionStarted();
+        int failures = runCommands(in, writer, execute);
+        Metrics::sessionEnded();
+        return failures;
+    }
+
+    int runReports(std::istream& in, std::ostream& out) {
+        ResultWriter writer(out);
+        return runCommands(in, writer, executeReport);
+    }
+}
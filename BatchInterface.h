@@ -0,0 +1,102 @@
+// BatchInterface.h
+//******************************************************************
+// DEFINITION MODULE: BatchInterface
+//
+// PURPOSE:          Non-interactive counterpart of UserInterface. Reads
+//                   one command per line (from a file or stdin), maps each
+//                   command directly onto a Controller use case without any
+//                   prompts or confirmations, and writes one tab-separated,
+//                   machine-readable result line per command.
+//
+//                   Command reference (tokens are whitespace separated,
+//                   wrap IDs containing spaces in double quotes, lines
+//                   starting with '#' are ignored):
+//
+//                     vessel-create   <vesselID> <LCLL> <HCLL>
+//                     sailing-create  <vesselID> <sailingID>
+//                     sailing-delete  <sailingID>
+//                     vehicle-create  <plate> <phone> <length> <height>
+//                     reserve         <sailingID> <plate> [<phone> <length> <height>]
+//                                     (OK fields: sailing plate deck(low|high) lane)
+//                     cancel          <sailingID> <plate>
+//                                     (ROW "promoted" <plate> per waitlisted vehicle booked)
+//                     waitlist        <sailingID> <plate>
+//                     waitlist-leave  <plate>
+//                     waitlist-status <plate>
+//                                     (OK fields: sailing plate class(regular|oversize)
+//                                      sequence requestTime)
+//                     checkin         <plate>
+//                     checkin-batch   <plate> [plate...]
+//                                     (ROW "missing" <plate> per unknown plate,
+//                                      OK fields: checkedIn missing)
+//                     lanes           <sailingID>
+//                                     (ROW fields: deck lane capacity used vehicles)
+//                     earliest        <route> <length> <height> [fromSailingID]
+//                                     (OK fields: sailing vessel LRL HRL)
+//                     query           <sailingID>
+//                     report          [offset]
+//                     top-capacity    <LRL|HRL> <k> [vesselID]
+//                     vessel-capacity <vesselID>
+//                                     (OK fields: vessel sailings remainingLRL bookedLRL
+//                                      remainingHRL bookedHRL)
+//                     metrics         (latency summary per Controller operation,
+//                                      ROW fields: op count mean p50 p99 p999 max, in us)
+//                     explain         <command> [args...]
+//                                     (runs the command, then one ROW per data file:
+//                                      file opens seeks scanned bytesRead bytesWritten
+//                                      truncates fsyncs preallocations)
+//                     exit
+//
+//                   Report mode (runReports, ferry --report) accepts only
+//                   query, report, exit and
+//                     replica         (OK fields: reads retries fallbacks remaps)
+//                   and serves them from the ReportReplica.
+//
+//                   Result lines:
+//                     OK    <lineNo> <command> [fields...]
+//                     ERR   <lineNo> <command> <message>
+//                     ROW   <lineNo> <command> <fields...>   (multi-row results)
+//
+// (* Revision History:
+//   Rev. 1.10 - 2025/08/23 - Added report mode (runReports)
+//   Rev. 1.9 - 2025/08/21 - explain reports preallocations
+//   Rev. 1.8 - 2025/08/14 - Added earliest command
+//   Rev. 1.7 - 2025/08/13 - Added waitlist commands
+//   Rev. 1.6 - 2025/08/12 - reserve reports the assigned lane, added lanes command
+//   Rev. 1.5 - 2025/08/11 - Added checkin-batch command
+//   Rev. 1.4 - 2025/08/09 - Added vessel-capacity command
+//   Rev. 1.3 - 2025/08/08 - Added top-capacity command
+//   Rev. 1.2 - 2025/08/06 - Added explain command
+//   Rev. 1.1 - 2025/08/05 - Added metrics command
+//   Rev. 1.0 - 2025/08/02 - Initial version
+// *)
+//******************************************************************
+#ifndef BATCH_INTERFACE_H
+#define BATCH_INTERFACE_H
+
+#include <istream>
+#include <ostream>
+
+namespace BatchInterface {
+
+    //-----------
+    // Runs every command read from `in` and writes the results to `out`.
+    // Output is buffered internally and flushed in large blocks, so this
+    // is suitable for overnight bulk schedule changes.
+    // Returns the number of commands that failed (0 = all succeeded).
+    int run(
+        std::istream& in,   // in:  command stream, one command per line
+        std::ostream& out   // out: result stream
+    );
+    //-----------
+    // As run(), but for a reporting process: the read-only commands are
+    // answered from ReportReplica, which must be open, and any other
+    // command fails. Returns the number of commands that failed.
+    int runReports(
+        std::istream& in,   // in:  command stream, one command per line
+        std::ostream& out   // out: result stream
+    );
+
+}
+
+#endif // BATCH_INTERFACE_H
@@ -0,0 +1,73 @@
+// BloomFilter.cpp
+//*******************************
+// BloomFilter.cpp
+//
+// Double hashing (Kirsch-Mitzenmacher): probe i is h1 + i * h2 over a
+// power-of-two bit array, with h1 = FNV-1a and h2 a second 64-bit mix of
+// the same bytes.
+//
+// Rev 1.1 - 2025-08-16 - merge()
+// Rev 1.0 - 2025-08-15 - Initial version
+//*******************************
+
+#include "BloomFilter.h"
+#include <utility>
+
+namespace {
+    uint64_t fnv1a(std::string_view key) {
+        uint64_t hash = 14695981039346656037ULL;
+        for (unsigned char c : key) {
+            hash ^= c;
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    // splitmix64 finalizer, forced odd so every probe lands on a new bit.
+    uint64_t mix(uint64_t x) {
+        x += 0x9E3779B97F4A7C15ULL;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        return (x ^ (x >> 31)) | 1;
+    }
+}
+
+BloomFilter::BloomFilter(uint64_t expectedKeys) {
+    uint64_t bits = MIN_BITS;
+    while (bits < expectedKeys * BITS_PER_KEY) bits *= 2;
+    words.assign(bits / 64, 0);
+}
+
+BloomFilter::BloomFilter(std::vector<uint64_t> words, uint64_t insertions)
+    : words(std::move(words)), added(insertions) {}
+
+void BloomFilter::add(std::string_view key) {
+    if (words.empty()) return;
+    uint64_t mask = words.size() * 64 - 1;
+    uint64_t h1 = fnv1a(key);
+    uint64_t h2 = mix(h1);
+    for (uint32_t i = 0; i < HASH_COUNT; i++) {
+        uint64_t bit = (h1 + i * h2) & mask;
+        words[bit / 64] |= uint64_t(1) << (bit % 64);
+    }
+    added++;
+}
+
+bool BloomFilter::merge(const BloomFilter& other) {
+    if (other.words.size() != words.size()) return false;
+    for (size_t i = 0; i < words.size(); i++) words[i] |= other.words[i];
+    added += other.added;
+    return true;
+}
+
+bool BloomFilter::mightContain(std::string_view key) const {
+    if (words.empty()) return true;
+    uint64_t mask = words.size() * 64 - 1;
+    uint64_t h1 = fnv1a(key);
+    uint64_t h2 = mix(h1);
+    for (uint32_t i = 0; i < HASH_COUNT; i++) {
+        uint64_t bit = (h1 + i * h2) & mask;
+        if (!(words[bit / 64] & (uint64_t(1) << (bit % 64)))) return false;
+    }
+    return true;
+}
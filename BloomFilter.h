@@ -0,0 +1,63 @@
+// BloomFilter.h
+//******************************************************************
+// DEFINITION MODULE: BloomFilter
+//
+// PURPOSE:          Fixed-size Bloom filter over strings. Answers "might
+//                   this key have been added?" with no false negatives and
+//                   a false positive rate of about 1% while the number of
+//                   insertions stays within the capacity it was sized for.
+//                   Keys cannot be removed; owners rebuild the filter when
+//                   it has drifted too far from the data.
+//
+//                   The bit array is exposed so a filter can be saved to
+//                   and restored from a checkpoint verbatim.
+//
+// (* Revision History:
+//   Rev. 1.1 - 2025/08/16 - merge() for filters built in parallel
+//   Rev. 1.0 - 2025/08/15 - Initial version
+// *)
+//******************************************************************
+#ifndef BLOOM_FILTER_H
+#define BLOOM_FILTER_H
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+class BloomFilter {
+public:
+    // Bits per expected key and probes per key for ~1% false positives.
+    static const uint64_t BITS_PER_KEY = 10;
+    static const uint32_t HASH_COUNT = 7;
+    static const uint64_t MIN_BITS = 1 << 16;
+
+    BloomFilter() = default;
+    //-----------
+    // Sized for `expectedKeys` insertions (rounded up to a power of two bits).
+    explicit BloomFilter(uint64_t expectedKeys);
+    //-----------
+    // Restores a filter from its saved bit array.
+    BloomFilter(std::vector<uint64_t> words, uint64_t insertions);
+
+    //-----------
+    void add(std::string_view key);
+    //-----------
+    // False means the key was definitely never added.
+    bool mightContain(std::string_view key) const;
+    //-----------
+    // Adds every key of `other`, which must have been built with the same
+    // expectedKeys. Returns false (and changes nothing) if the sizes differ.
+    bool merge(const BloomFilter& other);
+
+    bool empty() const { return words.empty(); }
+    uint64_t insertions() const { return added; }
+    // Insertions the filter was sized for.
+    uint64_t capacity() const { return words.size() * 64 / BITS_PER_KEY; }
+    const std::vector<uint64_t>& bitWords() const { return words; }
+
+private:
+    std::vector<uint64_t> words;
+    uint64_t added = 0;
+};
+
+#endif // BLOOM_FILTER_H
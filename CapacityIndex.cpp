@@ -0,0 +1,254 @@
+// CapacityIndex.cpp
+//*******************************
+// CapacityIndex.cpp
+//
+// Ordered capacity index over sailings. Each sailing appears once in a
+// fleet-wide ordered set per lane pool and once in its vessel's ordered
+// set per lane pool, keyed on (remaining capacity desc, sailing ID asc).
+// A capacity change is an erase + insert in four sets: O(log n).
+// Per-vessel aggregates are plain running sums in a hash map: O(1).
+// Per-route segment trees are patched in place on capacity changes and
+// rebuilt lazily after the route's set of sailings changes.
+//
+// Rev 1.3 - 2025-08-19 - Load with one sequential read per file
+// Rev 1.2 - 2025-08-14 - Per-route earliest fitting sailing
+// Rev 1.1 - 2025-08-09 - Per-vessel capacity aggregates
+// Rev 1.0 - 2025-08-08 - Initial version
+//*******************************
+
+#include "CapacityIndex.h"
+#include "Utility.h"
+#include "Vessel.h"
+#include "CapacitySegmentTree.h"
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+
+namespace CapacityIndex {
+
+    namespace {
+        struct Entry {
+            double capacity;
+            std::string sailingID;
+
+            // Largest capacity first, then sailing ID for a stable order.
+            bool operator<(const Entry& other) const {
+                if (capacity != other.capacity) return capacity > other.capacity;
+                return sailingID < other.sailingID;
+            }
+        };
+
+        using OrderedSet = std::set<Entry>;
+
+        struct LaneSets {
+            OrderedSet low;
+            OrderedSet high;
+
+            OrderedSet& of(Lane lane) { return lane == Lane::Low ? low : high; }
+        };
+
+        // Current record of a sailing plus the full lane capacity it
+        // started with, so its booked share can be backed out on delete.
+        struct Tracked {
+            Sailing::SailingEntity record;
+            double capacityLRL;
+            double capacityHRL;
+        };
+
+        std::mutex indexLock;
+        std::unordered_map<std::string, Tracked> sailings; // sailingID -> tracked sailing
+        LaneSets fleet;
+        std::map<std::string, LaneSets> byVessel;
+        std::unordered_map<std::string, VesselAggregate> aggregates;
+
+        // Sailings of one route in sailing ID order, plus the tree over them.
+        struct Route {
+            std::set<std::string> sailingIDs;
+            std::vector<std::string> order;                     // Valid when !dirty
+            std::unordered_map<std::string, size_t> position;   // Valid when !dirty
+            CapacitySegmentTree tree;                           // Valid when !dirty
+            bool dirty = true;
+        };
+        std::unordered_map<std::string, Route> routes;
+
+        CapacitySegmentTree::Capacity capacityOf(const Sailing::SailingEntity& s) {
+            return { s.LRL, s.HRL };
+        }
+
+        void rebuildLocked(Route& route) {
+            route.order.assign(route.sailingIDs.begin(), route.sailingIDs.end());
+            route.position.clear();
+            std::vector<CapacitySegmentTree::Capacity> leaves;
+            leaves.reserve(route.order.size());
+            for (size_t i = 0; i < route.order.size(); i++) {
+                route.position[route.order[i]] = i;
+                leaves.push_back(capacityOf(sailings.at(route.order[i]).record));
+            }
+            route.tree.build(leaves);
+            route.dirty = false;
+        }
+
+        // Adds a sailing's current capacity to the ordered sets and to its
+        // vessel's remaining totals.
+        void linkLocked(const Sailing::SailingEntity& s) {
+            VesselAggregate& aggregate = aggregates[s.vesselID];
+            aggregate.remainingLRL += s.LRL;
+            aggregate.remainingHRL += s.HRL;
+            LaneSets& vessel = byVessel[s.vesselID];
+            fleet.low.insert({ s.LRL, s.sailingID });
+            fleet.high.insert({ s.HRL, s.sailingID });
+            vessel.low.insert({ s.LRL, s.sailingID });
+            vessel.high.insert({ s.HRL, s.sailingID });
+        }
+
+        // Exact inverse of linkLocked().
+        void unlinkLocked(const Sailing::SailingEntity& s) {
+            VesselAggregate& aggregate = aggregates[s.vesselID];
+            aggregate.remainingLRL -= s.LRL;
+            aggregate.remainingHRL -= s.HRL;
+            fleet.low.erase({ s.LRL, s.sailingID });
+            fleet.high.erase({ s.HRL, s.sailingID });
+            auto vessel = byVessel.find(s.vesselID);
+            if (vessel != byVessel.end()) {
+                vessel->second.low.erase({ s.LRL, s.sailingID });
+                vessel->second.high.erase({ s.HRL, s.sailingID });
+                if (vessel->second.low.empty()) byVessel.erase(vessel);
+            }
+        }
+
+        void addLocked(const Sailing::SailingEntity& s, double capacityLRL, double capacityHRL) {
+            if (sailings.count(s.sailingID)) return;
+            sailings.emplace(s.sailingID, Tracked{ s, capacityLRL, capacityHRL });
+            linkLocked(s);
+            Route& route = routes[routeOf(s.sailingID)];
+            route.sailingIDs.insert(s.sailingID);
+            route.dirty = true;
+            VesselAggregate& aggregate = aggregates[s.vesselID];
+            aggregate.sailings++;
+            aggregate.capacityLRL += capacityLRL;
+            aggregate.capacityHRL += capacityHRL;
+        }
+
+        void clearLocked() {
+            sailings.clear();
+            fleet = LaneSets();
+            byVessel.clear();
+            aggregates.clear();
+            routes.clear();
+        }
+    }
+
+    void load() {
+        std::lock_guard<std::mutex> guard(indexLock);
+        clearLocked();
+
+        std::unordered_map<std::string, Vessel::VesselEntity> vessels;
+        for (const auto& record : Utility::readAllRecords<Vessel::VesselEntity>()) {
+            vessels.emplace(record.vesselID, record);
+        }
+
+        for (const auto& record : Utility::readAllRecords<Sailing::SailingEntity>()) {
+            // A sailing whose vessel record is gone counts as unbooked.
+            auto vessel = vessels.find(record.vesselID);
+            bool known = vessel != vessels.end();
+            addLocked(record, known ? vessel->second.LCLL : record.LRL,
+                              known ? vessel->second.HCLL : record.HRL);
+        }
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> guard(indexLock);
+        clearLocked();
+    }
+
+    void onSailingCreated(const Sailing::SailingEntity& sailing) {
+        std::lock_guard<std::mutex> guard(indexLock);
+        addLocked(sailing, sailing.LRL, sailing.HRL);
+    }
+
+    void onSailingUpdated(const Sailing::SailingEntity& sailing) {
+        std::lock_guard<std::mutex> guard(indexLock);
+        auto existing = sailings.find(sailing.sailingID);
+        if (existing == sailings.end()) return;
+        unlinkLocked(existing->second.record);
+        existing->second.record = sailing;
+        linkLocked(sailing);
+
+        Route& route = routes[routeOf(sailing.sailingID)];
+        if (!route.dirty) route.tree.update(route.position.at(sailing.sailingID), capacityOf(sailing));
+    }
+
+    void onSailingDeleted(const std::string& sailingID) {
+        std::lock_guard<std::mutex> guard(indexLock);
+        auto existing = sailings.find(sailingID);
+        if (existing == sailings.end()) return;
+        Tracked removed = existing->second;
+        sailings.erase(existing);
+        unlinkLocked(removed.record);
+
+        VesselAggregate& aggregate = aggregates[removed.record.vesselID];
+        aggregate.capacityLRL -= removed.capacityLRL;
+        aggregate.capacityHRL -= removed.capacityHRL;
+        if (--aggregate.sailings == 0) aggregates.erase(removed.record.vesselID);
+
+        auto route = routes.find(routeOf(sailingID));
+        if (route != routes.end()) {
+            route->second.sailingIDs.erase(sailingID);
+            route->second.dirty = true;
+            if (route->second.sailingIDs.empty()) routes.erase(route);
+        }
+    }
+
+    std::vector<Sailing::SailingEntity> topK(Lane lane, size_t k, const std::string& vesselID) {
+        std::lock_guard<std::mutex> guard(indexLock);
+        std::vector<Sailing::SailingEntity> result;
+
+        const OrderedSet* set = &fleet.of(lane);
+        if (!vesselID.empty()) {
+            auto vessel = byVessel.find(vesselID);
+            if (vessel == byVessel.end()) return result;
+            set = &vessel->second.of(lane);
+        }
+
+        for (auto it = set->begin(); it != set->end() && result.size() < k; ++it) {
+            result.push_back(sailings.at(it->sailingID).record);
+        }
+        return result;
+    }
+
+    VesselAggregate vesselAggregate(const std::string& vesselID) {
+        std::lock_guard<std::mutex> guard(indexLock);
+        auto found = aggregates.find(vesselID);
+        return found != aggregates.end() ? found->second : VesselAggregate();
+    }
+
+    std::vector<std::pair<std::string, VesselAggregate>> allVesselAggregates() {
+        std::lock_guard<std::mutex> guard(indexLock);
+        std::vector<std::pair<std::string, VesselAggregate>> result(aggregates.begin(), aggregates.end());
+        std::sort(result.begin(), result.end(),
+                  [](const auto& a, const auto& b) { return a.first < b.first; });
+        return result;
+    }
+
+    std::string routeOf(const std::string& sailingID) {
+        return sailingID.substr(0, sailingID.find('-'));
+    }
+
+    std::optional<Sailing::SailingEntity> earliestFitting(const std::string& route, double length,
+                                                          bool highDeckOnly, const std::string& fromSailingID) {
+        std::lock_guard<std::mutex> guard(indexLock);
+        auto found = routes.find(route);
+        if (found == routes.end()) return {};
+        Route& r = found->second;
+        if (r.dirty) rebuildLocked(r);
+
+        size_t from = static_cast<size_t>(
+            std::lower_bound(r.order.begin(), r.order.end(), fromSailingID) - r.order.begin());
+        size_t index = r.tree.firstFit(from, length, highDeckOnly);
+        if (index == CapacitySegmentTree::NOT_FOUND) return {};
+        return sailings.at(r.order[index]).record;
+    }
+
+} // end namespace CapacityIndex
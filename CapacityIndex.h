@@ -0,0 +1,111 @@
+// CapacityIndex.h
+//******************************************************************
+// DEFINITION MODULE: CapacityIndex
+//
+// PURPOSE:          In-memory secondary index over sailings, ordered by
+//                   remaining lane capacity. The Sailing module keeps it
+//                   up to date on every create, delete and capacity change,
+//                   so "which sailings still have room" queries never
+//                   scan Sailings.dat.
+//
+//                   Also materializes per-vessel totals (remaining and
+//                   booked lane metres across all of a vessel's sailings),
+//                   updated in O(1) by the same hooks.
+//
+//                   Sailings are also grouped by route (the departure
+//                   terminal, i.e. the sailing ID up to the first '-',
+//                   e.g. "YVR" for "YVR-21-06") and kept in sailing ID
+//                   order, which is departure order for IDs of the form
+//                   TTT-DD-HH. Each route has a CapacitySegmentTree so the
+//                   earliest sailing with room for a vehicle is found in
+//                   O(log n).
+//
+// (* Revision History:
+//   Rev. 1.2 - 2025/08/14 - Earliest fitting sailing per route
+//   Rev. 1.1 - 2025/08/09 - Per-vessel capacity aggregates
+//   Rev. 1.0 - 2025/08/08 - Initial version: top-k by remaining LRL/HRL
+// *)
+//******************************************************************
+#ifndef CAPACITY_INDEX_H
+#define CAPACITY_INDEX_H
+
+#include <optional>
+#include <string>
+#include <vector>
+#include "Sailing.h"
+
+namespace CapacityIndex {
+
+    // Which lane pool a query is about.
+    enum class Lane {
+        Low,    // LRL - low ceiling lanes (regular vehicles)
+        High    // HRL - high ceiling lanes (oversize vehicles)
+    };
+
+    // Lane metre totals over every sailing of one vessel.
+    struct VesselAggregate {
+        int sailings = 0;
+        double capacityLRL = 0.0;   // Sum of the vessel's LCLL per sailing
+        double capacityHRL = 0.0;   // Sum of the vessel's HCLL per sailing
+        double remainingLRL = 0.0;
+        double remainingHRL = 0.0;
+
+        double bookedLRL() const { return capacityLRL - remainingLRL; }
+        double bookedHRL() const { return capacityHRL - remainingHRL; }
+    };
+
+    //-----------
+    // Rebuilds the index from Sailings.dat (and Vessels.dat for the lane
+    // capacities behind the booked totals). Called by Sailing::init().
+    void load();
+    //-----------
+    void clear();
+
+    // --- Maintenance hooks, called by the Sailing module only ---
+    //-----------
+    // `sailing` must be freshly created, i.e. LRL/HRL still equal the
+    // vessel's full LCLL/HCLL.
+    void onSailingCreated(const Sailing::SailingEntity& sailing);
+    //-----------
+    // `sailing` holds the new LRL/HRL; the previous values are taken
+    // from the index itself.
+    void onSailingUpdated(const Sailing::SailingEntity& sailing);
+    //-----------
+    void onSailingDeleted(const std::string& sailingID);
+
+    // --- Queries ---
+    //-----------
+    // Returns up to `k` sailings with the most remaining capacity in
+    // `lane`, largest first (ties broken by sailing ID). If `vesselID`
+    // is non-empty only that vessel's sailings are considered.
+    // Cost: O(log n + k).
+    std::vector<Sailing::SailingEntity> topK(
+        Lane lane,                      // in: lane pool to rank by
+        size_t k,                       // in: maximum number of results
+        const std::string& vesselID     // in: vessel filter, "" for all
+    );
+    //-----------
+    // Current totals for one vessel (all zero if it has no sailings). O(1).
+    VesselAggregate vesselAggregate(const std::string& vesselID);
+    //-----------
+    // Totals for every vessel that has at least one sailing, by vessel ID.
+    std::vector<std::pair<std::string, VesselAggregate>> allVesselAggregates();
+    //-----------
+    // Route a sailing belongs to: its ID up to the first '-'.
+    std::string routeOf(const std::string& sailingID);
+    //-----------
+    // The first sailing on `route`, in sailing ID order and starting at
+    // `fromSailingID` ("" = from the first), with at least `length` metres
+    // left in HRL, or in LRL or HRL unless `highDeckOnly`. Changes to a
+    // sailing's capacity cost O(log n); creating or deleting a sailing
+    // marks its route for an O(n) rebuild on the next query.
+    std::optional<Sailing::SailingEntity> earliestFitting(
+        const std::string& route,           // in
+        double length,                      // in: occupied length, buffer included
+        bool highDeckOnly,                  // in: oversize vehicle
+        const std::string& fromSailingID    // in: lower bound (inclusive), "" for none
+    );
+
+}
+
+#endif // CAPACITY_INDEX_H
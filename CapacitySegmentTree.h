@@ -0,0 +1,90 @@
+// CapacitySegmentTree.h
+//******************************************************************
+// DEFINITION MODULE: CapacitySegmentTree
+//
+// PURPOSE:          Max segment tree over an ordered list of sailings.
+//                   Every leaf holds a sailing's remaining LRL and HRL;
+//                   every inner node holds the largest LRL and the largest
+//                   HRL below it. That is enough to find the first
+//                   sailing at or after a given position that can take a
+//                   vehicle in O(log n): a subtree whose maximum is too
+//                   small is skipped whole.
+//
+//                   Not thread safe; the owner serializes access.
+//
+// (* Revision History:
+//   Rev. 1.0 - 2025/08/14 - Initial version
+// *)
+//******************************************************************
+#ifndef CAPACITY_SEGMENT_TREE_H
+#define CAPACITY_SEGMENT_TREE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+class CapacitySegmentTree {
+public:
+    struct Capacity {
+        double LRL = 0.0;
+        double HRL = 0.0;
+    };
+
+    static const size_t NOT_FOUND = static_cast<size_t>(-1);
+
+    // Replaces the whole tree. O(n).
+    void build(const std::vector<Capacity>& leaves) {
+        count = leaves.size();
+        width = 1;
+        while (width < count) width *= 2;
+        nodes.assign(2 * width, Capacity{ EMPTY, EMPTY });
+        for (size_t i = 0; i < count; i++) nodes[width + i] = leaves[i];
+        for (size_t node = width - 1; node >= 1; node--) pull(node);
+    }
+
+    // Changes one leaf. O(log n).
+    void update(size_t index, const Capacity& value) {
+        if (index >= count) return;
+        size_t node = width + index;
+        nodes[node] = value;
+        for (node /= 2; node >= 1; node /= 2) pull(node);
+    }
+
+    // First index >= `from` whose HRL (if `highOnly`) or LRL/HRL (if not)
+    // is at least `length`, or NOT_FOUND. O(log n).
+    size_t firstFit(size_t from, double length, bool highOnly) const {
+        if (from >= count) return NOT_FOUND;
+        return search(1, 0, width, from, length, highOnly);
+    }
+
+    size_t size() const { return count; }
+
+private:
+    // Padding leaves never satisfy a query.
+    static constexpr double EMPTY = -1.0;
+
+    void pull(size_t node) {
+        nodes[node].LRL = std::max(nodes[2 * node].LRL, nodes[2 * node + 1].LRL);
+        nodes[node].HRL = std::max(nodes[2 * node].HRL, nodes[2 * node + 1].HRL);
+    }
+
+    static bool fits(const Capacity& c, double length, bool highOnly) {
+        return c.HRL >= length || (!highOnly && c.LRL >= length);
+    }
+
+    // Leftmost leaf in [lo, hi) at or after `from` that fits.
+    size_t search(size_t node, size_t lo, size_t hi, size_t from, double length, bool highOnly) const {
+        if (hi <= from || !fits(nodes[node], length, highOnly)) return NOT_FOUND;
+        if (hi - lo == 1) return lo < count ? lo : NOT_FOUND;
+        size_t mid = (lo + hi) / 2;
+        size_t found = search(2 * node, lo, mid, from, length, highOnly);
+        if (found != NOT_FOUND) return found;
+        return search(2 * node + 1, mid, hi, from, length, highOnly);
+    }
+
+    std::vector<Capacity> nodes;
+    size_t count = 0;
+    size_t width = 1;
+};
+
+#endif // CAPACITY_SEGMENT_TREE_H
@@ -0,0 +1,315 @@
+// ChangeFeed.cpp
+//*******************************
+// ChangeFeed.cpp
+//
+// Changes.log layout (native byte order):
+//   LogHeader (64 bytes)
+//   Entry 1, Entry 2, ...           (96 bytes each)
+// Entry n is at sizeof(LogHeader) + (n - 1) * sizeof(Entry). Appenders in
+// every process take an exclusive lock on the log (Utility::lockRecords)
+// to find the end and write there, so the sequence is simply the slot. A
+// torn entry at the tail (crash mid-append) is overwritten by the next
+// append; readers never take an entry whose sequence is not the one its
+// slot implies.
+//
+// Rev 1.0 - 2025-08-24 - Initial version
+//*******************************
+
+#include "ChangeFeed.h"
+#include "Utility.h"
+#include "Vessel.h"
+#include "Sailing.h"
+#include "Vehicle.h"
+#include "Reservation.h"
+#include "Waitlist.h"
+#include "IdDictionary.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace ChangeFeed {
+
+    namespace {
+        const char* LOG_PATH = "Data/Changes.log";
+        const char MAGIC[8] = { 'F', 'E', 'R', 'R', 'Y', 'C', 'D', 'C' };
+        const uint32_t VERSION = 1;
+        // Entries read per Cursor::read while following.
+        const size_t FOLLOW_BATCH_ENTRIES = 1024;
+
+        struct LogHeader {
+            char magic[8];
+            uint32_t version;
+            uint32_t entrySize;        // sizeof(Entry)
+            char reserved[48];
+        };
+        static_assert(sizeof(LogHeader) == 64, "LogHeader is an on-disk layout");
+
+        const long long ENTRIES_OFFSET = sizeof(LogHeader);
+
+        // This process's appends; other processes are excluded by the
+        // file lock.
+        std::mutex appendLock;
+        int logFd = -1;
+
+        bool writeAll(int fd, const void* buffer, size_t bytes, long long offset) {
+            const char* data = static_cast<const char*>(buffer);
+            size_t total = 0;
+            while (total < bytes) {
+                ssize_t wrote = ::pwrite(fd, data + total, bytes - total, static_cast<off_t>(offset + total));
+                if (wrote < 0 && errno == EINTR) continue;
+                if (wrote <= 0) return false;
+                total += static_cast<size_t>(wrote);
+            }
+            return true;
+        }
+
+        // The Utility change sink.
+        void append(size_t entity, Utility::ChangeOp op, long long position, const void* record, size_t bytes) {
+            Entry entry;
+            memset(&entry, 0, sizeof(Entry));
+            entry.timeMicros = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+            entry.position = position;
+            entry.entity = static_cast<uint8_t>(entity);
+            entry.op = static_cast<uint8_t>(op);
+            entry.recordSize = static_cast<uint16_t>(std::min(bytes, MAX_RECORD_BYTES));
+            memcpy(entry.record, record, entry.recordSize);
+
+            std::lock_guard<std::mutex> guard(appendLock);
+            if (logFd < 0) return;
+            Utility::lockRecords(logFd, Utility::LockMode::Exclusive, -1, 1);
+            struct stat info;
+            bool appended = ::fstat(logFd, &info) == 0;
+            long long size = appended ? static_cast<long long>(info.st_size) : 0;
+            if (appended && size < ENTRIES_OFFSET) {
+                LogHeader header = {};
+                memcpy(header.magic, MAGIC, sizeof(MAGIC));
+                header.version = VERSION;
+                header.entrySize = sizeof(Entry);
+                appended = writeAll(logFd, &header, sizeof(LogHeader), 0);
+                size = ENTRIES_OFFSET;
+            }
+            if (appended) {
+                long long slot = (size - ENTRIES_OFFSET) / static_cast<long long>(sizeof(Entry));
+                entry.sequence = static_cast<uint64_t>(slot) + 1;
+                appended = writeAll(logFd, &entry, sizeof(Entry), ENTRIES_OFFSET + slot * static_cast<long long>(sizeof(Entry)));
+            }
+            Utility::unlockFile(logFd);
+            if (!appended) std::cerr << "ERROR: Could not append to " << LOG_PATH << std::endl;
+        }
+
+        std::string text(const char* field, size_t size) {
+            return std::string(field, strnlen(field, size));
+        }
+
+        template <typename T>
+        T recordOf(const Entry& entry) {
+            T record;
+            memset(&record, 0, sizeof(T));
+            memcpy(&record, entry.record, std::min<size_t>(sizeof(T), entry.recordSize));
+            return record;
+        }
+
+        const char* opName(uint8_t op) {
+            switch (static_cast<Utility::ChangeOp>(op)) {
+                case Utility::ChangeOp::Create: return "create";
+                case Utility::ChangeOp::Update: return "update";
+                case Utility::ChangeOp::Delete: return "delete";
+            }
+            return "?";
+        }
+    }
+
+    bool open() {
+        std::lock_guard<std::mutex> guard(appendLock);
+        if (logFd < 0) logFd = ::open(LOG_PATH, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (logFd < 0) {
+            std::cerr << "ERROR: Could not open " << LOG_PATH << std::endl;
+            return false;
+        }
+        Utility::setChangeSink(append);
+        return true;
+    }
+
+    void close() {
+        Utility::setChangeSink(nullptr);
+        std::lock_guard<std::mutex> guard(appendLock);
+        if (logFd >= 0) ::close(logFd);
+        logFd = -1;
+    }
+
+    // --- Cursor ---
+    Cursor::Cursor(uint64_t after) : after(after) {}
+
+    Cursor::~Cursor() {
+        if (fd >= 0) ::close(fd);
+    }
+
+    bool Cursor::openLog() {
+        if (fd >= 0) return true;
+        fd = ::open(LOG_PATH, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return false;
+        LogHeader header;
+        if (::pread(fd, &header, sizeof(LogHeader), 0) != static_cast<ssize_t>(sizeof(LogHeader)) ||
+            memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.entrySize != sizeof(Entry)) {
+            // Not written yet (or not a change log): try again next time.
+            ::close(fd);
+            fd = -1;
+            return false;
+        }
+        return true;
+    }
+
+    size_t Cursor::read(std::vector<Entry>& out, size_t max) {
+        struct stat info;
+        if (max == 0 || !openLog() || ::fstat(fd, &info) != 0) return 0;
+        long long size = static_cast<long long>(info.st_size);
+        uint64_t complete = size > ENTRIES_OFFSET ? static_cast<uint64_t>((size - ENTRIES_OFFSET) / sizeof(Entry)) : 0;
+        if (complete <= after) return 0;
+
+        size_t want = static_cast<size_t>(std::min<uint64_t>(max, complete - after));
+        size_t first = out.size();
+        out.resize(first + want);
+        char* buffer = reinterpret_cast<char*>(&out[first]);
+        long long offset = ENTRIES_OFFSET + static_cast<long long>(after * sizeof(Entry));
+        size_t got = 0;
+        while (got < want * sizeof(Entry)) {
+            ssize_t read = ::pread(fd, buffer + got, want * sizeof(Entry) - got, static_cast<off_t>(offset + got));
+            if (read < 0 && errno == EINTR) continue;
+            if (read <= 0) break;
+            got += static_cast<size_t>(read);
+        }
+        // Stop at an entry still being written.
+        size_t valid = 0;
+        while (valid < got / sizeof(Entry) && out[first + valid].sequence == after + valid + 1) valid++;
+        out.resize(first + valid);
+        after += valid;
+        return valid;
+    }
+
+    std::string describe(const Entry& entry) {
+        std::ostringstream line;
+        line << entry.sequence << '\t' << entry.timeMicros << '\t' << Utility::entityFileName(entry.entity)
+             << '\t' << opName(entry.op) << '\t' << entry.position;
+        switch (entry.entity) {
+            case Utility::entityIndex<Vessel::VesselEntity>(): {
+                auto r = recordOf<Vessel::VesselEntity>(entry);
+                line << '\t' << text(r.vesselID, sizeof(r.vesselID)) << '\t' << r.LCLL << '\t' << r.HCLL;
+                break;
+            }
+            case Utility::entityIndex<Sailing::SailingEntity>(): {
+                auto r = recordOf<Sailing::SailingEntity>(entry);
+                line << '\t' << text(r.sailingID, sizeof(r.sailingID)) << '\t' << text(r.vesselID, sizeof(r.vesselID))
+                     << '\t' << r.LRL << '\t' << r.HRL;
+                break;
+            }
+            case Utility::entityIndex<Vehicle::VehicleEntity>(): {
+                auto r = recordOf<Vehicle::VehicleEntity>(entry);
+                line << '\t' << text(r.plate, sizeof(r.plate)) << '\t' << text(r.phone, sizeof(r.phone))
+                     << '\t' << r.length << '\t' << r.height;
+                break;
+            }
+            case Utility::entityIndex<Reservation::ReservationEntity>(): {
+                // IDs are dictionary keys; Ids.dat creations are in the feed too.
+                auto r = recordOf<Reservation::ReservationEntity>(entry);
+                line << '\t' << r.sailingKey << '\t' << r.plateKey << '\t' << (r.checkedIn ? 1 : 0)
+                     << '\t' << static_cast<int>(r.deck) << '\t' << static_cast<int>(r.lane);
+                break;
+            }
+            case Utility::entityIndex<Waitlist::WaitlistEntity>(): {
+                auto r = recordOf<Waitlist::WaitlistEntity>(entry);
+                line << '\t' << text(r.sailingID, sizeof(r.sailingID)) << '\t' << text(r.vehiclePlate, sizeof(r.vehiclePlate))
+                     << '\t' << static_cast<int>(r.vehicleClass) << '\t' << r.sequence << '\t' << r.requestTime;
+                break;
+            }
+            case Utility::entityIndex<IdDictionary::IdEntity>(): {
+                auto r = recordOf<IdDictionary::IdEntity>(entry);
+                line << '\t' << r.key << '\t' << text(r.id, sizeof(r.id));
+                break;
+            }
+        }
+        return line.str();
+    }
+
+    void follow(uint64_t after, const std::function<bool(const std::string& lines)>& write) {
+        Cursor cursor(after);
+        std::vector<Entry> batch;
+        std::string lines;
+        while (true) {
+            batch.clear();
+            if (cursor.read(batch, FOLLOW_BATCH_ENTRIES) == 0) {
+                if (!write(std::string())) return;
+                std::this_thread::sleep_for(std::chrono::milliseconds(FOLLOW_POLL_MS));
+                continue;
+            }
+            lines.clear();
+            for (const auto& entry : batch) {
+                lines += describe(entry);
+                lines += '\n';
+            }
+            if (!write(lines)) return;
+        }
+    }
+
+    void serve(const std::string& socketPath, std::string& error) {
+        struct sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        if (socketPath.size() >= sizeof(address.sun_path)) {
+            error = "socket path too long: " + socketPath;
+            return;
+        }
+        memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+        int listener = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        ::unlink(socketPath.c_str()); // A socket left by an earlier run
+        if (listener < 0 || ::bind(listener, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0 ||
+            ::listen(listener, 16) != 0) {
+            error = "could not listen on " + socketPath + ": " + strerror(errno);
+            if (listener >= 0) ::close(listener);
+            return;
+        }
+
+        while (true) {
+            int client = ::accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+            if (client < 0) {
+                if (errno == EINTR || errno == ECONNABORTED) continue;
+                error = std::string("accept failed: ") + strerror(errno);
+                ::close(listener);
+                return;
+            }
+            std::thread([client]() {
+                // The resume point: digits up to the newline.
+                std::string request;
+                char c;
+                while (request.size() < 32 && ::recv(client, &c, 1, 0) == 1 && c != '\n') request += c;
+                uint64_t after = std::strtoull(request.c_str(), nullptr, 10);
+                follow(after, [client](const std::string& lines) {
+                    if (lines.empty()) {
+                        struct pollfd check = { client, POLLRDHUP, 0 };
+                        return ::poll(&check, 1, 0) == 0; // Still connected if nothing happened
+                    }
+                    size_t sent = 0;
+                    while (sent < lines.size()) {
+                        ssize_t n = ::send(client, lines.data() + sent, lines.size() - sent, MSG_NOSIGNAL);
+                        if (n < 0 && errno == EINTR) continue;
+                        if (n <= 0) return false;
+                        sent += static_cast<size_t>(n);
+                    }
+                    return true;
+                });
+                ::close(client);
+            }).detach();
+        }
+    }
+}
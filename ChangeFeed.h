@@ -0,0 +1,110 @@
+// ChangeFeed.h
+//******************************************************************
+// DEFINITION MODULE: ChangeFeed
+//
+// PURPOSE:          Change-data capture. Every record created, updated
+//                   or deleted through the Utility primitives, by any
+//                   process sharing the Data directory, is appended to
+//                   Data/Changes.log as one fixed-size Entry with a
+//                   sequence number, so downstream systems (billing, gate
+//                   displays) follow the changes instead of re-scanning
+//                   the data files.
+//
+//                   Sequence numbers start at 1 and have no gaps, and
+//                   entry n is stored at a fixed offset, so a consumer
+//                   resumes from the last sequence it processed with one
+//                   positioned read. Changes to the same record appear in
+//                   the order they were made. The log is never rewritten;
+//                   consumers read it directly (Cursor) or through
+//                   `ferry --changes` / `ferry --changes-socket`, which
+//                   stream describe() lines.
+//
+//                   An entry is appended after its change is written and
+//                   before the change's file locks are released, without
+//                   an fsync: a crash in between loses the entry.
+//
+// (* Revision History:
+//   Rev. 1.0 - 2025/08/24 - Initial version
+// *)
+//******************************************************************
+#ifndef CHANGE_FEED_H
+#define CHANGE_FEED_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace ChangeFeed {
+
+    // Largest entity record (Sailing, Waitlist).
+    const size_t MAX_RECORD_BYTES = 64;
+
+    // On-disk entry; Changes.log is a 64-byte header followed by these.
+    struct Entry {
+        uint64_t sequence;         // 1 for the first change, then one more per change
+        int64_t timeMicros;        // When it was appended, microseconds since the epoch
+        int64_t position;          // Record position in its data file
+        uint8_t entity;            // Data file, as a Utility::entityFileName() index
+        uint8_t op;                // Utility::ChangeOp
+        uint16_t recordSize;       // Bytes of `record` used
+        char reserved[4];
+        char record[MAX_RECORD_BYTES];  // The record written; for a delete, the record removed
+    };
+    static_assert(sizeof(Entry) == 96, "ChangeFeed::Entry is an on-disk layout");
+
+    //-----------
+    // Opens the log for appending and starts recording every change made
+    // through Utility by this process. Returns false if it could not.
+    bool open();
+    //-----------
+    // Stops recording.
+    void close();
+
+    // A consumer's place in the log: the sequence of the last entry it
+    // has read. Save position() and pass it back to resume.
+    class Cursor {
+    public:
+        explicit Cursor(uint64_t after = 0);
+        ~Cursor();
+        Cursor(const Cursor&) = delete;
+        Cursor& operator=(const Cursor&) = delete;
+
+        //-----------
+        // Appends up to `max` entries after the cursor to `out` and moves
+        // past them. Returns how many; 0 once caught up (or if there is
+        // no log yet).
+        size_t read(std::vector<Entry>& out, size_t max);
+        //-----------
+        uint64_t position() const { return after; }
+
+    private:
+        bool openLog();
+        int fd = -1;
+        uint64_t after;
+    };
+
+    //-----------
+    // One tab-separated line (without the newline):
+    //   sequence timeMicros file create|update|delete position fields...
+    // where the fields are those of the record, e.g. for Sailings.dat
+    // sailingID vesselID LRL HRL.
+    std::string describe(const Entry& entry);
+    //-----------
+    // Passes describe() lines, newline terminated, for every entry after
+    // `after` to `write`, then waits for more, indefinitely. While waiting
+    // `write` is called with no lines every FOLLOW_POLL_MS and should just
+    // say whether the consumer is still there. Returns when `write`
+    // returns false.
+    const int FOLLOW_POLL_MS = 50;
+    void follow(uint64_t after, const std::function<bool(const std::string& lines)>& write);
+    //-----------
+    // Serves the feed on the Unix domain socket `socketPath`. Each client
+    // sends the sequence to resume after (0 for the start) and a newline,
+    // then receives lines as from follow() until it disconnects. Returns
+    // only if the socket could not be set up, with the reason in `error`.
+    void serve(const std::string& socketPath, std::string& error);
+}
+
+#endif // CHANGE_FEED_H
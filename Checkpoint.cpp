@@ -0,0 +1,418 @@
+// Checkpoint.cpp
+//*******************************
+// Checkpoint.cpp
+//
+// Checkpoint.dat layout (native byte order, no padding):
+//   FileHeader
+//   bloomWords x uint64_t                 plate filter bit array
+//   per sailing: char sailingID[21], then per deck (low, high):
+//     double metres, uint16_t lanes, lanes x LaneRecord
+// Checkpoint.log is a sequence of fixed-size LogRecords; a torn record at
+// the tail (crash mid-append) is ignored, and overwritten by the next
+// append. Every process that shares Data/ appends to the same log, so an
+// append or truncation takes an exclusive lock on it (Utility::lockRecords)
+// and writes at the whole-record end it finds then, never at an offset
+// remembered from earlier.
+//
+// The image is read through a read-only mmap so a large checkpoint is
+// parsed straight from the page cache; if mapping fails it is read into
+// a buffer instead. Lane log records carry the lane's new absolute state,
+// so replaying the whole log in order is idempotent.
+//
+// Rev 1.1 - 2025-08-25 - Log appends and truncation locked across processes
+// Rev 1.0 - 2025-08-15 - Initial version
+//*******************************
+
+#include "Checkpoint.h"
+#include "BloomFilter.h"
+#include "LaneAllocator.h"
+#include "Reservation.h"
+#include "Sailing.h"
+#include "Utility.h"
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Checkpoint {
+
+    namespace {
+        const char* IMAGE_PATH = "Data/Checkpoint.dat";
+        const char* LOG_PATH = "Data/Checkpoint.log";
+        const char MAGIC[8] = { 'F', 'E', 'R', 'R', 'Y', 'C', 'K', '1' };
+        const uint32_t VERSION = 1;
+        // Pooled LRL/HRL and the lane sums are both built by adding and
+        // subtracting the same lengths, so they agree to well within this.
+        const double TOLERANCE = 1e-6;
+
+        #pragma pack(push, 1)
+        struct FileHeader {
+            char magic[8];
+            uint32_t version;
+            uint32_t sailingCount;
+            uint64_t bloomInsertions;
+            uint64_t bloomWords;
+        };
+
+        struct LaneRecord {
+            double used;
+            int32_t vehicles;
+        };
+
+        enum class LogType : unsigned char {
+            SailingAdded = 1,   // a = LCLL, b = HCLL
+            SailingDropped = 2,
+            Lane = 3,           // deck, lane, a = used, vehicles
+            PlateAdded = 4
+        };
+
+        struct LogRecord {
+            unsigned char type;
+            char key[21];       // sailingID or vehiclePlate
+            int32_t deck;
+            int32_t lane;
+            double a;
+            double b;
+            int32_t vehicles;
+        };
+        #pragma pack(pop)
+
+        // This process's appends; other processes are excluded by the
+        // file lock.
+        std::mutex logLock;
+        int logFd = -1;
+
+        bool writeAll(const void* buffer, size_t bytes, long long offset) {
+            const char* data = static_cast<const char*>(buffer);
+            size_t total = 0;
+            while (total < bytes) {
+                ssize_t wrote = ::pwrite(logFd, data + total, bytes - total, static_cast<off_t>(offset + total));
+                if (wrote < 0 && errno == EINTR) continue;
+                if (wrote <= 0) return false;
+                total += static_cast<size_t>(wrote);
+            }
+            return true;
+        }
+
+        void appendLocked(const LogRecord& record) {
+            if (logFd < 0) return;
+            Utility::lockRecords(logFd, Utility::LockMode::Exclusive, -1, 0);
+            struct stat info;
+            bool appended = ::fstat(logFd, &info) == 0;
+            if (appended) {
+                long long end = static_cast<long long>(info.st_size);
+                appended = writeAll(&record, sizeof(LogRecord), end - end % static_cast<long long>(sizeof(LogRecord)));
+            }
+            Utility::unlockFile(logFd);
+            if (!appended) std::cerr << "ERROR: Could not append to " << LOG_PATH << std::endl;
+        }
+
+        void append(LogType type, const std::string& key, int deck, int lane, double a, double b, int vehicles) {
+            LogRecord record;
+            memset(&record, 0, sizeof(LogRecord));
+            record.type = static_cast<unsigned char>(type);
+            strncpy(record.key, key.c_str(), 20);
+            record.deck = deck;
+            record.lane = lane;
+            record.a = a;
+            record.b = b;
+            record.vehicles = vehicles;
+            std::lock_guard<std::mutex> guard(logLock);
+            appendLocked(record);
+        }
+
+        // Opens the log for appending, emptying it first if `truncate`.
+        void openLog(bool truncate) {
+            std::lock_guard<std::mutex> guard(logLock);
+            if (logFd < 0) logFd = ::open(LOG_PATH, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+            if (logFd < 0) {
+                std::cerr << "ERROR: Could not open " << LOG_PATH << std::endl;
+                return;
+            }
+            if (!truncate) return;
+            Utility::lockRecords(logFd, Utility::LockMode::Exclusive, -1, 0);
+            if (::ftruncate(logFd, 0) != 0) std::cerr << "ERROR: Could not empty " << LOG_PATH << std::endl;
+            Utility::unlockFile(logFd);
+        }
+
+        // Read-only view of a whole file: mmap'ed if possible, else copied.
+        class FileView {
+        public:
+            explicit FileView(const char* path) {
+                int fd = ::open(path, O_RDONLY);
+                if (fd < 0) return;
+                struct stat info;
+                if (::fstat(fd, &info) == 0 && info.st_size > 0) {
+                    length = static_cast<size_t>(info.st_size);
+                    void* mapped = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+                    if (mapped != MAP_FAILED) {
+                        mapping = mapped;
+                        bytes = static_cast<const char*>(mapped);
+                    } else {
+                        copy.resize(length);
+                        ssize_t got = ::pread(fd, copy.data(), length, 0);
+                        length = got > 0 ? static_cast<size_t>(got) : 0;
+                        bytes = copy.data();
+                    }
+                }
+                ::close(fd);
+            }
+            ~FileView() {
+                if (mapping) ::munmap(mapping, length);
+            }
+            FileView(const FileView&) = delete;
+            FileView& operator=(const FileView&) = delete;
+
+            const char* data() const { return bytes; }
+            size_t size() const { return length; }
+
+        private:
+            void* mapping = nullptr;
+            const char* bytes = nullptr;
+            size_t length = 0;
+            std::vector<char> copy;
+        };
+
+        // Bounds-checked sequential reader over a FileView.
+        class Cursor {
+        public:
+            Cursor(const char* data, size_t size) : data(data), size(size) {}
+
+            template<typename T>
+            bool read(T& out) {
+                if (size - offset < sizeof(T)) return false;
+                memcpy(&out, data + offset, sizeof(T));
+                offset += sizeof(T);
+                return true;
+            }
+
+        private:
+            const char* data;
+            size_t size;
+            size_t offset = 0;
+        };
+
+        using Tables = std::map<std::string, LaneAllocator::SailingTable>;
+
+        LaneAllocator::DeckTable emptyDeck(double metres) {
+            LaneAllocator::DeckTable deck;
+            deck.metres = metres;
+            deck.used.assign(LaneAllocator::laneCount(metres), 0.0);
+            deck.vehicles.assign(deck.used.size(), 0);
+            return deck;
+        }
+
+        bool readImage(Tables& tables, BloomFilter& filter) {
+            FileView image(IMAGE_PATH);
+            if (!image.data()) return false;
+            Cursor cursor(image.data(), image.size());
+
+            FileHeader header;
+            if (!cursor.read(header) || memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+                header.version != VERSION) {
+                return false;
+            }
+            if (header.bloomWords > image.size() / sizeof(uint64_t)) return false;
+            std::vector<uint64_t> words(header.bloomWords);
+            for (uint64_t& word : words) {
+                if (!cursor.read(word)) return false;
+            }
+            filter = BloomFilter(std::move(words), header.bloomInsertions);
+
+            for (uint32_t i = 0; i < header.sailingCount; i++) {
+                char sailingID[21];
+                if (!cursor.read(sailingID)) return false;
+                sailingID[20] = '\0';
+                LaneAllocator::SailingTable table;
+                table.sailingID = sailingID;
+                for (auto& deck : table.decks) {
+                    uint16_t lanes = 0;
+                    if (!cursor.read(deck.metres) || !cursor.read(lanes)) return false;
+                    if (lanes != LaneAllocator::laneCount(deck.metres)) return false;
+                    deck.used.resize(lanes);
+                    deck.vehicles.resize(lanes);
+                    for (uint16_t lane = 0; lane < lanes; lane++) {
+                        LaneRecord record;
+                        if (!cursor.read(record)) return false;
+                        deck.used[lane] = record.used;
+                        deck.vehicles[lane] = record.vehicles;
+                    }
+                }
+                tables[table.sailingID] = std::move(table);
+            }
+            return true;
+        }
+
+        void replayLog(Tables& tables, BloomFilter& filter) {
+            FileView log(LOG_PATH);
+            if (!log.data()) return;
+            size_t count = log.size() / sizeof(LogRecord);
+            for (size_t i = 0; i < count; i++) {
+                LogRecord record;
+                memcpy(&record, log.data() + i * sizeof(LogRecord), sizeof(LogRecord));
+                record.key[20] = '\0';
+                switch (static_cast<LogType>(record.type)) {
+                case LogType::SailingAdded: {
+                    LaneAllocator::SailingTable& table = tables[record.key];
+                    table.sailingID = record.key;
+                    table.decks[0] = emptyDeck(record.a);
+                    table.decks[1] = emptyDeck(record.b);
+                    break;
+                }
+                case LogType::SailingDropped:
+                    tables.erase(record.key);
+                    break;
+                case LogType::Lane: {
+                    auto table = tables.find(record.key);
+                    if (table == tables.end() || record.deck < 0 || record.deck > 1) break;
+                    LaneAllocator::DeckTable& deck = table->second.decks[record.deck];
+                    if (record.lane < 0 || record.lane >= static_cast<int>(deck.used.size())) break;
+                    deck.used[record.lane] = record.a;
+                    deck.vehicles[record.lane] = record.vehicles;
+                    break;
+                }
+                case LogType::PlateAdded:
+                    filter.add(record.key);
+                    break;
+                }
+            }
+        }
+
+        double freeMetres(const LaneAllocator::DeckTable& deck) {
+            double used = 0.0;
+            for (double lane : deck.used) used += lane;
+            return deck.metres - used;
+        }
+
+        // Keeps only tables of sailings that still exist and checks them
+        // against the pooled figures on disk.
+        bool validate(Tables& tables) {
+            Tables kept;
+            long long vehicles = 0;
+            bool consistent = true;
+            Utility::scanRecords<Sailing::SailingEntity>([&](int, const Sailing::SailingEntity& sailing) {
+                auto table = tables.find(sailing.sailingID);
+                if (table == tables.end() ||
+                    std::fabs(freeMetres(table->second.decks[0]) - sailing.LRL) > TOLERANCE ||
+                    std::fabs(freeMetres(table->second.decks[1]) - sailing.HRL) > TOLERANCE) {
+                    consistent = false;
+                    return false;
+                }
+                for (const auto& deck : table->second.decks) {
+                    for (int count : deck.vehicles) vehicles += count;
+                }
+                kept.insert(tables.extract(table));
+                return true;
+            });
+            if (!consistent || vehicles != Utility::recordCount<Reservation::ReservationEntity>()) return false;
+            tables.swap(kept);
+            return true;
+        }
+    }
+
+    bool load() {
+        Tables tables;
+        BloomFilter filter;
+        if (!readImage(tables, filter)) {
+            std::cout << "MODEL/Checkpoint: No usable checkpoint, rebuilding." << std::endl;
+            return false;
+        }
+        replayLog(tables, filter);
+        if (filter.empty() || !validate(tables)) {
+            std::cout << "MODEL/Checkpoint: Checkpoint is stale, rebuilding." << std::endl;
+            return false;
+        }
+
+        std::vector<LaneAllocator::SailingTable> imported;
+        imported.reserve(tables.size());
+        for (auto& entry : tables) imported.push_back(std::move(entry.second));
+        LaneAllocator::importTables(imported);
+        Reservation::installPlateFilter(std::move(filter));
+        openLog(false);
+        std::cout << "MODEL/Checkpoint: Restored " << imported.size() << " sailings." << std::endl;
+        return true;
+    }
+
+    void write() {
+        BloomFilter filter = Reservation::copyPlateFilter();
+        if (filter.empty() || filter.insertions() > filter.capacity()) {
+            // Too many plates (or cancelled plates) for the false positive
+            // rate it was sized for: start over from the live reservations.
+            Reservation::buildPlateFilter();
+            filter = Reservation::copyPlateFilter();
+        }
+        std::vector<LaneAllocator::SailingTable> tables = LaneAllocator::exportTables();
+
+        std::string tempPath = std::string(IMAGE_PATH) + ".tmp";
+        {
+            std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+            FileHeader header;
+            memcpy(header.magic, MAGIC, sizeof(MAGIC));
+            header.version = VERSION;
+            header.sailingCount = static_cast<uint32_t>(tables.size());
+            header.bloomInsertions = filter.insertions();
+            header.bloomWords = filter.bitWords().size();
+            out.write(reinterpret_cast<const char*>(&header), sizeof(FileHeader));
+            out.write(reinterpret_cast<const char*>(filter.bitWords().data()),
+                      filter.bitWords().size() * sizeof(uint64_t));
+            for (const auto& table : tables) {
+                char sailingID[21] = {};
+                strncpy(sailingID, table.sailingID.c_str(), 20);
+                out.write(sailingID, sizeof(sailingID));
+                for (const auto& deck : table.decks) {
+                    uint16_t lanes = static_cast<uint16_t>(deck.used.size());
+                    out.write(reinterpret_cast<const char*>(&deck.metres), sizeof(double));
+                    out.write(reinterpret_cast<const char*>(&lanes), sizeof(uint16_t));
+                    for (uint16_t lane = 0; lane < lanes; lane++) {
+                        LaneRecord record = { deck.used[lane], deck.vehicles[lane] };
+                        out.write(reinterpret_cast<const char*>(&record), sizeof(LaneRecord));
+                    }
+                }
+            }
+            if (!out) {
+                std::cerr << "ERROR: Could not write checkpoint '" << tempPath << "'" << std::endl;
+                return;
+            }
+        }
+
+        std::error_code ec;
+        std::filesystem::rename(tempPath, IMAGE_PATH, ec);
+        if (ec) {
+            std::cerr << "ERROR: Could not install checkpoint: " << ec.message() << std::endl;
+            return;
+        }
+        // The image now covers everything logged so far.
+        openLog(true);
+    }
+
+    void close() {
+        std::lock_guard<std::mutex> guard(logLock);
+        if (logFd >= 0) ::close(logFd);
+        logFd = -1;
+    }
+
+    void logSailingAdded(const std::string& sailingID, double LCLL, double HCLL) {
+        append(LogType::SailingAdded, sailingID, 0, 0, LCLL, HCLL, 0);
+    }
+
+    void logSailingDropped(const std::string& sailingID) {
+        append(LogType::SailingDropped, sailingID, 0, 0, 0.0, 0.0, 0);
+    }
+
+    void logLane(const std::string& sailingID, int deck, int lane, double used, int vehicles) {
+        append(LogType::Lane, sailingID, deck, lane, used, 0.0, vehicles);
+    }
+
+    void logPlateAdded(const std::string& vehiclePlate) {
+        append(LogType::PlateAdded, vehiclePlate, 0, 0, 0.0, 0.0, 0);
+    }
+}
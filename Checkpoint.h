@@ -0,0 +1,65 @@
+// Checkpoint.h
+//******************************************************************
+// DEFINITION MODULE: Checkpoint
+//
+// PURPOSE:          Warm start for the in-memory state that is otherwise
+//                   rebuilt from full scans of the data files at start-up:
+//                   the lane tables of every sailing (LaneAllocator) and
+//                   the reserved-plate Bloom filter (Reservation).
+//
+//                   Data/Checkpoint.dat is a complete image written at
+//                   shutdown; Data/Checkpoint.log is an append-only delta
+//                   log of every change made since. load() maps the image,
+//                   replays the log over it and installs the result only
+//                   if it agrees with the pooled LRL/HRL of every sailing
+//                   and with the number of reservations on disk. Anything
+//                   missing, torn or inconsistent makes load() return
+//                   false, and the caller falls back to a cold rebuild.
+//
+//                   The log functions are called by the modules whose
+//                   state is checkpointed, while they hold their own
+//                   locks; they never call back into those modules. Every
+//                   process sharing Data/ appends to the one log under a
+//                   file lock.
+//
+// (* Revision History:
+//   Rev. 1.1 - 2025/08/25 - Log shared by every process on Data/
+//   Rev. 1.0 - 2025/08/15 - Initial version
+// *)
+//******************************************************************
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <string>
+
+namespace Checkpoint {
+
+    //-----------
+    // Restores the lane tables and plate filter from the checkpoint plus
+    // delta log and opens the log for appending. Call after every data
+    // module is initialized. Returns false (and installs nothing) if
+    // there is no usable checkpoint.
+    bool load();
+    //-----------
+    // Writes a fresh image of the current state and empties the delta
+    // log. Must not race with bookings: call from init and shutdown only.
+    void write();
+    //-----------
+    // Stops logging. Changes made afterwards are not recorded.
+    void close();
+
+    //-----------
+    // --- Delta log ---
+    // No-ops until load() or write() has opened the log.
+    //-----------
+    void logSailingAdded(const std::string& sailingID, double LCLL, double HCLL);
+    //-----------
+    void logSailingDropped(const std::string& sailingID);
+    //-----------
+    // New state of one lane.
+    void logLane(const std::string& sailingID, int deck, int lane, double used, int vehicles);
+    //-----------
+    void logPlateAdded(const std::string& vehiclePlate);
+}
+
+#endif // CHECKPOINT_H
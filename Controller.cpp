@@ -7,129 +7,485 @@
 //
 // Rev 1.0 - 2025-07-22
 //     - Initial version
+// Rev 1.1 - 2025-08-05
+//     - Latency histogram for every entry point, dumped at shutdown
+// Rev 1.2 - 2025-08-06
+//     - EXPLAIN mode for per-call I/O
+// Rev 1.3 - 2025-08-08
+//     - Top-k sailings by remaining capacity
+// Rev 1.4 - 2025-08-09
+//     - Per-vessel capacity aggregates
+// Rev 1.5 - 2025-08-10
+//     - Snapshot-isolated sailing reports
+// Rev 1.6 - 2025-08-11
+//     - Batch check-in
+// Rev 1.7 - 2025-08-12
+//     - Lane-level packing replaces pooled LRL/HRL subtraction
+// Rev 1.8 - 2025-08-13
+//     - Waitlist for full sailings, promoted on cancellation
+// Rev 1.9 - 2025-08-14
+//     - Earliest fitting sailing on a route
+// Rev 1.10 - 2025-08-15
+//     - Warm start from checkpoint + delta log
+// Rev 1.11 - 2025-08-16
+//     - Data files loaded concurrently on a thread pool at start-up
+// Rev 1.12 - 2025-08-17
+//     - ID dictionary loaded before any module that stores keys
+// Rev 1.13 - 2025-08-19
+//     - Booking re-checks for an existing reservation under the lock
+//     - Lookups take a string_view
+// Rev 1.14 - 2025-08-24
+//     - Change feed of every write (Data/Changes.log)
+// Rev 1.15 - 2025-08-25
+//     - Promotion passes over waiting vehicles that do not fit
+//     - Cancelling a reservation that is not on the sailing changes nothing
+// Rev 1.16 - 2025-08-25
+//     - Entry points hold the Data/ generation lock; caches are reloaded
+//       after another process has written
+//     - A reload holds the generation lock exclusively and counts as a
+//       write if it placed unplaced reservations
 //*******************************
 
 #include "Controller.h"
 #include "Utility.h"
+#include "Metrics.h"
+#include "LaneAllocator.h"
+#include "Checkpoint.h"
+#include "ChangeFeed.h"
+#include "ThreadPool.h"
+#include <atomic>
+#include <iostream>
+#include <mutex>
+#include <shared_mutex>
+#include <fcntl.h>
+#include <unistd.h>
 
 namespace Controller {
 
+    namespace {
+        // --- Other processes ---
+        // Booths may run separate processes on one Data/ directory, each
+        // with its own module caches. Every entry point holds
+        // Data/Generation.lock, shared to read and exclusively to write,
+        // so writes from different processes never interleave. The file
+        // holds a count of writes; a process that finds it has moved since
+        // it last looked rebuilds its caches from the data files first.
+        const char* const GENERATION_PATH = "Data/Generation.lock";
+
+        // Shared by entry points in this process, exclusive to a reload.
+        // Always taken before the file lock.
+        std::shared_mutex cacheLock;
+        // The generation the caches reflect.
+        std::atomic<uint64_t> seenGeneration{ 0 };
+
+        uint64_t readGeneration(int fd) {
+            uint64_t generation = 0;
+            if (fd < 0 || ::pread(fd, &generation, sizeof(generation), 0) != sizeof(generation)) return 0;
+            return generation;
+        }
+
+        void writeGeneration(int fd, uint64_t generation) {
+            if (fd >= 0 && ::pwrite(fd, &generation, sizeof(generation), 0) != sizeof(generation)) {
+                std::cerr << "ERROR: Could not update " << GENERATION_PATH << std::endl;
+            }
+        }
+
+        // Rebuilds every cache from the data files, as init() does
+        // without a checkpoint. Caller holds cacheLock and the generation
+        // lock exclusively, since placing unplaced reservations writes
+        // their lanes back. Returns true if it wrote anything.
+        bool reloadCaches() {
+            IdDictionary::reload();
+            Vessel::reload();
+            Vehicle::init();
+            Reservation::init();
+            ThreadPool pool;
+            auto sailings = pool.submit([]() { Sailing::reload(); });
+            auto waitlist = pool.submit([]() { Waitlist::reload(); });
+            bool wrote = LaneAllocator::load(pool);
+            Reservation::buildPlateFilter(pool);
+            sailings.get();
+            waitlist.get();
+            return wrote;
+        }
+
+        enum class Access {
+            Read,        // Shared: only the caches are read
+            Write,       // Exclusive: the data files change
+            Checkpoint   // Exclusive: only the checkpoint is written, from the caches
+        };
+
+        // Holds the generation lock for one entry point, with the caches
+        // current. A write advances the generation when it is done, even
+        // if it failed part way, so the other processes look again.
+        class DataGuard {
+        public:
+            explicit DataGuard(Access access) : file(GENERATION_PATH, true), writing(access == Access::Write) {
+                Utility::LockMode mode = access == Access::Read ? Utility::LockMode::Shared
+                                                                : Utility::LockMode::Exclusive;
+                while (true) {
+                    cache = std::shared_lock<std::shared_mutex>(cacheLock);
+                    file.all(mode);
+                    if (readGeneration(file.descriptor()) == seenGeneration) return;
+                    Utility::unlockFile(file.descriptor());
+                    cache.unlock();
+                    reload();
+                }
+            }
+
+            ~DataGuard() {
+                if (!writing) return;
+                uint64_t next = seenGeneration + 1;
+                writeGeneration(file.descriptor(), next);
+                seenGeneration = next;
+            }
+
+            DataGuard(const DataGuard&) = delete;
+            DataGuard& operator=(const DataGuard&) = delete;
+
+        private:
+            Utility::FileLock file;
+            bool writing;
+            std::shared_lock<std::shared_mutex> cache;
+
+            // Another process has written: reload with this process's
+            // entry points held off. Every other process is held off too,
+            // as the reload may write, but may write again before the
+            // caller relocks. A reload that wrote is a write itself.
+            static void reload() {
+                std::unique_lock<std::shared_mutex> exclusive(cacheLock);
+                Utility::FileLock held(GENERATION_PATH, true);
+                held.all(Utility::LockMode::Exclusive);
+                uint64_t current = readGeneration(held.descriptor());
+                if (current == seenGeneration) return; // Another thread got here first
+                if (reloadCaches()) {
+                    current++;
+                    writeGeneration(held.descriptor(), current);
+                }
+                seenGeneration = current;
+            }
+        };
+
+        // Held by every call that changes a sailing's bookings, so space
+        // freed by a cancellation is handed to the waitlist before any
+        // other booking can take it.
+        std::mutex bookingLock;
+
+        // Places and records one reservation. Caller holds bookingLock.
+        bool bookLocked(const std::string& sailingID, const Vehicle::VehicleEntity& vehicle) {
+            // Callers check too, but only the lock makes it stick
+            if (Reservation::isValidReservation(vehicle.plate)) return false;
+            double vehicleLength = LaneAllocator::occupiedLength(vehicle);
+            std::vector<LaneAllocator::Move> moves;
+            auto placement = LaneAllocator::place(sailingID, vehicle.plate, vehicleLength,
+                                                  LaneAllocator::needsHighDeck(vehicle), moves);
+            if (!placement) return false;
+
+            Reservation::createReservation(sailingID, vehicle.plate,
+                                           static_cast<unsigned char>(placement->deck),
+                                           static_cast<unsigned char>(placement->lane));
+            if (!moves.empty()) {
+                std::vector<Reservation::LaneAssignment> assignments;
+                for (const auto& move : moves) {
+                    assignments.push_back({ move.vehiclePlate, static_cast<unsigned char>(move.to.deck),
+                                            static_cast<unsigned char>(move.to.lane) });
+                }
+                Reservation::assignLanes(sailingID, assignments);
+            }
+
+            // The pooled figures stay the deck totals
+            if (placement->deck == LaneAllocator::Deck::High) {
+                Sailing::decreaseHRL(sailingID, vehicleLength);
+            } else {
+                Sailing::decreaseLRL(sailingID, vehicleLength);
+            }
+            Waitlist::remove(vehicle.plate);
+            return true;
+        }
+
+        // Books waiting vehicles onto `sailingID`, oldest request first. A
+        // vehicle that does not fit is passed over, so a smaller one behind
+        // it can still take the space. Space freed on the low deck can only
+        // serve regular vehicles. Caller holds bookingLock.
+        std::vector<std::string> promoteLocked(const std::string& sailingID, LaneAllocator::Deck freedDeck) {
+            std::vector<std::string> promoted;
+            bool oversize = freedDeck == LaneAllocator::Deck::High;
+            for (const auto& entry : Waitlist::waiting(sailingID, true, oversize)) {
+                auto vehicle = Vehicle::getVehicle(entry.vehiclePlate);
+                if (!vehicle) {
+                    Waitlist::remove(entry.vehiclePlate);
+                    continue;
+                }
+                if (bookLocked(sailingID, *vehicle)) promoted.push_back(entry.vehiclePlate);
+            }
+            return promoted;
+        }
+    }
+
     // --- System Lifecycle Functions (from Start-up/Shutdown OCDs) ---
     void init() {
-        Sailing::init();
+        Utility::init();
+        // Held exclusively while the caches are built, so they start out
+        // current, and the generation then moves on, since a cold load
+        // may have placed converted reservations.
+        ::close(::open(GENERATION_PATH, O_RDWR | O_CREAT | O_CLOEXEC, 0644));
+        Utility::FileLock generation(GENERATION_PATH, true);
+        generation.all(Utility::LockMode::Exclusive);
+        ChangeFeed::open();
+        IdDictionary::init();
         Vessel::init();
         Vehicle::init();
         Reservation::init();
-        Utility::init();
+
+        // The sailing table and capacity index, the waitlist and the lane
+        // tables each load from their own files, so they are built side by
+        // side. The lane tables and plate filter are built on this thread,
+        // which farms the chunks of the large files out to the pool.
+        ThreadPool pool;
+        auto sailings = pool.submit([]() { Sailing::init(); });
+        auto waitlist = pool.submit([]() { Waitlist::init(); });
+        if (!Checkpoint::load()) {
+            LaneAllocator::load(pool);
+            Reservation::buildPlateFilter(pool);
+            Checkpoint::write();
+        }
+        sailings.get();
+        waitlist.get();
+        uint64_t next = readGeneration(generation.descriptor()) + 1;
+        writeGeneration(generation.descriptor(), next);
+        seenGeneration = next;
     }
 
     void shutdown() {
+        DataGuard guard(Access::Checkpoint); // The checkpoint is written from current caches
         Sailing::shutdown();
         Vessel::shutdown();
         Vehicle::shutdown();
         Reservation::shutdown();
+        Waitlist::shutdown();
+        IdDictionary::shutdown();
+        ChangeFeed::close();
         Utility::shutdown();
+        Checkpoint::write();
+        Checkpoint::close();
+        LaneAllocator::clear();
+        Metrics::dump(std::cout);
+    }
+
+    void dumpMetrics(std::ostream& out) {
+        Metrics::dump(out);
+    }
+
+    void setExplain(bool enabled) {
+        Metrics::setExplain(enabled ? &std::clog : nullptr);
     }
 
     // --- Validation/Check Functions (Called by UI before other actions) ---
-    bool checkVesselExists(const std::string& vesselID) {
+    bool checkVesselExists(std::string_view vesselID) {
+        Metrics::ScopedTimer timer(Metrics::Operation::CheckVesselExists);
+        DataGuard data(Access::Read);
         return Vessel::isValidVessel(vesselID);
     }
 
-    bool checkSailingExists(const std::string& sailingID) {
+    bool checkSailingExists(std::string_view sailingID) {
+        Metrics::ScopedTimer timer(Metrics::Operation::CheckSailingExists);
+        DataGuard data(Access::Read);
         return Sailing::isValidSailing(sailingID);
     }
 
-    bool checkReservationExists(const std::string& vehiclePlate) {
+    bool checkReservationExists(std::string_view vehiclePlate) {
+        Metrics::ScopedTimer timer(Metrics::Operation::CheckReservationExists);
+        DataGuard data(Access::Read);
         return Reservation::isValidReservation(vehiclePlate);
     }
 
-    bool checkVehicleExists(const std::string& vehiclePlate) {
+    bool checkVehicleExists(std::string_view vehiclePlate) {
+        Metrics::ScopedTimer timer(Metrics::Operation::CheckVehicleExists);
+        DataGuard data(Access::Read);
         return Vehicle::isValidVehicle(vehiclePlate);
     }
 
     // --- Data Retrieval Functions (for displaying info in the UI) ---
-    std::optional<Vessel::VesselEntity> getVessel(const std::string& vesselID) {
+    std::optional<Vessel::VesselEntity> getVessel(std::string_view vesselID) {
+        Metrics::ScopedTimer timer(Metrics::Operation::GetVessel);
+        DataGuard data(Access::Read);
         return Vessel::getVessel(vesselID);
     }
 
-    std::optional<Sailing::SailingEntity> getSailing(const std::string& sailingID) {
+    std::optional<Sailing::SailingEntity> getSailing(std::string_view sailingID) {
+        Metrics::ScopedTimer timer(Metrics::Operation::GetSailing);
+        DataGuard data(Access::Read);
         return Sailing::getSailing(sailingID);
     }
 
-    std::optional<Reservation::ReservationEntity> getReservation(const std::string& vehiclePlate) {
+    std::optional<Reservation::ReservationEntity> getReservation(std::string_view vehiclePlate) {
+        Metrics::ScopedTimer timer(Metrics::Operation::GetReservation);
+        DataGuard data(Access::Read);
         return Reservation::getReservation(vehiclePlate);
     }
 
-    std::optional<Vehicle::VehicleEntity> getVehicle(const std::string& vehiclePlate) {
+    std::optional<Vehicle::VehicleEntity> getVehicle(std::string_view vehiclePlate) {
+        Metrics::ScopedTimer timer(Metrics::Operation::GetVehicle);
+        DataGuard data(Access::Read);
         return Vehicle::getVehicle(vehiclePlate);
     }
 
     // --- Use Case Functions (from specific OCDs) ---
     void createNewVessel(const std::string& vesselID, double LCLL, double HCLL) {
+        Metrics::ScopedTimer timer(Metrics::Operation::CreateNewVessel);
+        DataGuard data(Access::Write);
         Vessel::createVessel(vesselID, LCLL, HCLL);
     }
 
     void createNewSailing(const std::string& vesselID, const std::string& sailingID) {
+        Metrics::ScopedTimer timer(Metrics::Operation::CreateNewSailing);
+        DataGuard data(Access::Write);
         Sailing::createSailing(vesselID, sailingID);
+        if (auto vessel = Vessel::getVessel(vesselID)) {
+            LaneAllocator::onSailingCreated(sailingID, vessel->LCLL, vessel->HCLL);
+        }
     }
 
-    void createNewReservation(const std::string& sailingID, const std::string& vehiclePlate) {
-        Reservation::createReservation(sailingID, vehiclePlate);
-
-        auto vehicle = getVehicle(vehiclePlate).value();
-        auto sailing = getSailing(sailingID).value();
-
-        // Assume 4.5m for regular vehicles, include 0.5m buffer
-        double vehicleLength = (vehicle.length > 0 ? vehicle.length : 4.5) + 0.5;
-        double vehicleHeight = vehicle.height;
-
-        // Decrease HRL if special vehicle or LRL is full, otherwise decrease LRL
-        if (vehicleHeight > 2.0 || vehicleLength > 7.0 || sailing.LRL < vehicleLength) {
-            Sailing::decreaseHRL(sailingID, vehicleLength);
-        } else {
-            Sailing::decreaseLRL(sailingID, vehicleLength);
-        }
+    bool createNewReservation(const std::string& sailingID, const std::string& vehiclePlate) {
+        Metrics::ScopedTimer timer(Metrics::Operation::CreateNewReservation);
+        DataGuard data(Access::Write);
+        auto vehicle = Vehicle::getVehicle(vehiclePlate);
+        if (!vehicle) return false;
+        std::lock_guard<std::mutex> guard(bookingLock);
+        return bookLocked(sailingID, *vehicle);
     }
 
     void createNewVehicle(const std::string& vehiclePlate, const std::string& phoneNumber, double length, double height) {
+        Metrics::ScopedTimer timer(Metrics::Operation::CreateNewVehicle);
+        DataGuard data(Access::Write);
         Vehicle::createVehicle(vehiclePlate, phoneNumber, length, height);
     }
 
-    void cancelReservation(const std::string& sailingID, const std::string& vehiclePlate) {
-        Reservation::cancelReservation(sailingID, vehiclePlate);
+    std::vector<std::string> cancelReservation(const std::string& sailingID, const std::string& vehiclePlate) {
+        Metrics::ScopedTimer timer(Metrics::Operation::CancelReservation);
+        DataGuard data(Access::Write);
+        std::lock_guard<std::mutex> guard(bookingLock);
+        auto removed = Reservation::cancelReservation(sailingID, vehiclePlate);
+        // Nothing was booked on this sailing, so there is no space to give back
+        if (!removed) return {};
 
-        auto vehicle = getVehicle(vehiclePlate).value();
+        auto vehicle = Vehicle::getVehicle(vehiclePlate).value();
+        double vehicleLength = LaneAllocator::occupiedLength(vehicle);
 
-        double vehicleLength = (vehicle.length > 0 ? vehicle.length : 4.5) + 0.5;
-        double vehicleHeight = vehicle.height;
-
-        // Increase HRL/LRL depending on vehicle type
-        // TODO: Consider case when regular vehicle is put into HRL lane
-        // May need to store lane type in Reservation
-        if (vehicleHeight > 2.0 || vehicleLength > 7.0) {
+        // Give the space back to the deck the vehicle was actually placed on
+        LaneAllocator::Placement recorded = { removed->deck == static_cast<unsigned char>(LaneAllocator::Deck::High)
+                                                  ? LaneAllocator::Deck::High : LaneAllocator::Deck::Low,
+                                              removed->lane };
+        auto placement = LaneAllocator::release(sailingID, vehiclePlate, recorded, vehicleLength);
+        bool highDeck = placement ? placement->deck == LaneAllocator::Deck::High
+                                  : recorded.deck == LaneAllocator::Deck::High;
+        if (highDeck) {
             Sailing::increaseHRL(sailingID, vehicleLength);
         } else {
             Sailing::increaseLRL(sailingID, vehicleLength);
         }
+        return promoteLocked(sailingID, highDeck ? LaneAllocator::Deck::High : LaneAllocator::Deck::Low);
+    }
+
+    bool joinWaitlist(const std::string& sailingID, const std::string& vehiclePlate) {
+        Metrics::ScopedTimer timer(Metrics::Operation::JoinWaitlist);
+        DataGuard data(Access::Write);
+        auto vehicle = Vehicle::getVehicle(vehiclePlate);
+        if (!vehicle || !Sailing::isValidSailing(sailingID)) return false;
+        std::lock_guard<std::mutex> guard(bookingLock);
+        if (Reservation::isValidReservation(vehiclePlate)) return false;
+        return Waitlist::add(sailingID, vehiclePlate, LaneAllocator::needsHighDeck(*vehicle)
+                                                          ? Waitlist::VehicleClass::Oversize
+                                                          : Waitlist::VehicleClass::Regular);
+    }
+
+    bool leaveWaitlist(const std::string& vehiclePlate) {
+        Metrics::ScopedTimer timer(Metrics::Operation::LeaveWaitlist);
+        DataGuard data(Access::Write);
+        std::lock_guard<std::mutex> guard(bookingLock);
+        return Waitlist::remove(vehiclePlate);
+    }
+
+    std::optional<Waitlist::WaitlistEntity> getWaitlistEntry(const std::string& vehiclePlate) {
+        Metrics::ScopedTimer timer(Metrics::Operation::GetWaitlistEntry);
+        DataGuard data(Access::Read);
+        return Waitlist::find(vehiclePlate);
     }
 
     void checkInVehicle(const std::string& vehiclePlate) {
+        Metrics::ScopedTimer timer(Metrics::Operation::CheckInVehicle);
+        DataGuard data(Access::Write);
         Reservation::checkIn(vehiclePlate);
     }
 
+    std::vector<std::string> checkInVehicles(const std::vector<std::string>& vehiclePlates) {
+        Metrics::ScopedTimer timer(Metrics::Operation::CheckInVehicles);
+        DataGuard data(Access::Write);
+        return Reservation::checkInBatch(vehiclePlates);
+    }
+
     void deleteSailing(const std::string& sailingID) {
+        Metrics::ScopedTimer timer(Metrics::Operation::DeleteSailing);
+        DataGuard data(Access::Write);
+        std::lock_guard<std::mutex> guard(bookingLock);
         Sailing::deleteSailing(sailingID);
         Reservation::deleteReservations(sailingID);
+        Waitlist::removeSailing(sailingID);
+        LaneAllocator::onSailingDeleted(sailingID);
     }
     
     
     // --- Query and Report Functions ---
+    std::vector<LaneAllocator::LaneOccupancy> getLaneOccupancy(const std::string& sailingID) {
+        Metrics::ScopedTimer timer(Metrics::Operation::GetLaneOccupancy);
+        DataGuard data(Access::Read);
+        return LaneAllocator::occupancy(sailingID);
+    }
+
+    std::optional<Sailing::SailingEntity> findEarliestFittingSailing(const std::string& route, double length,
+                                                                      double height, const std::string& fromSailingID) {
+        Metrics::ScopedTimer timer(Metrics::Operation::FindEarliestFittingSailing);
+        DataGuard data(Access::Read);
+        Vehicle::VehicleEntity vehicle = {};
+        vehicle.length = length;
+        vehicle.height = height;
+        return CapacityIndex::earliestFitting(route, LaneAllocator::occupiedLength(vehicle),
+                                              LaneAllocator::needsHighDeck(vehicle), fromSailingID);
+    }
+
     std::vector<Sailing::SailingEntity> getSailingReport(int offset) {
+        Metrics::ScopedTimer timer(Metrics::Operation::GetSailingReport);
+        DataGuard data(Access::Read);
         return Sailing::getSailings(offset);
     }
 
+    Sailing::SailingSnapshot openSailingReport() {
+        DataGuard data(Access::Read);
+        return Sailing::openSnapshot();
+    }
+
+    std::vector<Sailing::SailingEntity> getSailingReport(const Sailing::SailingSnapshot& snapshot, int offset) {
+        Metrics::ScopedTimer timer(Metrics::Operation::GetSailingReport);
+        DataGuard data(Access::Read);
+        return Sailing::getSailings(snapshot, offset);
+    }
+
     Sailing::SailingEntity queryIndividualSailing(const std::string& sailingID) {
-        return getSailing(sailingID).value(); 
+        Metrics::ScopedTimer timer(Metrics::Operation::QueryIndividualSailing);
+        DataGuard data(Access::Read);
+        return Sailing::getSailing(sailingID).value();
+    }
+
+    std::vector<Sailing::SailingEntity> getTopSailingsByCapacity(CapacityIndex::Lane lane, int k, const std::string& vesselID) {
+        Metrics::ScopedTimer timer(Metrics::Operation::GetTopSailingsByCapacity);
+        DataGuard data(Access::Read);
+        if (k <= 0) return {};
+        return CapacityIndex::topK(lane, static_cast<size_t>(k), vesselID);
+    }
+
+    CapacityIndex::VesselAggregate getVesselCapacitySummary(const std::string& vesselID) {
+        Metrics::ScopedTimer timer(Metrics::Operation::GetVesselCapacitySummary);
+        DataGuard data(Access::Read);
+        return CapacityIndex::vesselAggregate(vesselID);
     }
 }
\ No newline at end of file
@@ -8,22 +8,57 @@
 //                   data model layer (Sailing, Vessel, etc.). This is the
 //                   declaration of the controller's public interface.
 //
+//                   Several processes may share one Data/ directory. Each
+//                   call holds Data/Generation.lock, shared to read and
+//                   exclusively to write, so writes from different
+//                   processes never interleave, and a process reloads its
+//                   caches first if another has written since its last call.
+//
 // (* Revision History:
 //   Rev. 1.0 - 2025/07/07
 //   Rev. 1.1 - 2025/07/08 
 //      - Add validation functions
 //   Rev. 1.2 - 2025/07/22
 //      - Add data retrieval functions, update some function parameters
+//   Rev. 1.3 - 2025/08/05
+//      - Add per-operation latency instrumentation (see Metrics)
+//   Rev. 1.4 - 2025/08/06
+//      - Add EXPLAIN-style per-call I/O summaries
+//   Rev. 1.5 - 2025/08/08
+//      - Add top-k sailings by remaining capacity query
+//   Rev. 1.6 - 2025/08/09
+//      - Add per-vessel capacity aggregates
+//   Rev. 1.7 - 2025/08/10
+//      - Add snapshot-isolated sailing reports
+//   Rev. 1.8 - 2025/08/11
+//      - Add batch check-in
+//   Rev. 1.9 - 2025/08/12
+//      - Reservations are placed in individual lanes; add lane occupancy
+//   Rev. 1.10 - 2025/08/13
+//      - Add waitlist for full sailings
+//   Rev. 1.11 - 2025/08/14
+//      - Add earliest fitting sailing search
+//   Rev. 1.12 - 2025/08/19
+//      - Lookups take a string_view and make no heap allocation
+//   Rev. 1.13 - 2025/08/24
+//      - init() starts recording every change in the change feed
+//   Rev. 1.14 - 2025/08/25
+//      - Calls are serialized with other processes and see their writes
 // *)
 //******************************************************************
 #ifndef CONTROLLER_H
 #define CONTROLLER_H
 
 #include <string>
+#include <string_view>
+#include <ostream>
 #include "Sailing.h"
 #include "Vessel.h"
 #include "Vehicle.h"
 #include "Reservation.h"
+#include "CapacityIndex.h"
+#include "LaneAllocator.h"
+#include "Waitlist.h"
 
 // The Controller namespace encapsulates all central application logic,
 // making it a global, static class that doesn't need to be instantiated.
@@ -34,26 +69,35 @@ namespace Controller {
     void init();    // Initializes all lower-level modules and connects to the DB.
     //-----------
     void shutdown(); // Shuts down all lower-level modules and disconnects from the DB.
+    //-----------
+    // Prints the latency histogram summary of every entry point called so far.
+    void dumpMetrics(std::ostream& out);
+    //-----------
+    // When enabled, every Controller call prints its latency and the file
+    // I/O it caused (opens, seeks, records scanned, bytes) to std::clog.
+    void setExplain(bool enabled);
 
     // --- Validation/Check Functions (Called by UI before other actions) ---
+    // These and the retrieval functions below are served from in-memory
+    // indexes once warm and make no heap allocation.
     //-----------
-    bool checkVesselExists(const std::string& vesselID);
+    bool checkVesselExists(std::string_view vesselID);
     //-----------
-    bool checkSailingExists(const std::string& sailingID);
+    bool checkSailingExists(std::string_view sailingID);
     //-----------
-    bool checkReservationExists(const std::string& vehiclePlate);
+    bool checkReservationExists(std::string_view vehiclePlate);
     //-----------
-    bool checkVehicleExists(const std::string& vehiclePlate);
+    bool checkVehicleExists(std::string_view vehiclePlate);
 
     // --- Data Retrieval Functions (for displaying info in the UI) ---
     //-----------
-    std::optional<Vessel::VesselEntity> getVessel(const std::string& vesselID);
+    std::optional<Vessel::VesselEntity> getVessel(std::string_view vesselID);
     //-----------
-    std::optional<Sailing::SailingEntity> getSailing(const std::string& sailingID);
+    std::optional<Sailing::SailingEntity> getSailing(std::string_view sailingID);
     //-----------
-    std::optional<Reservation::ReservationEntity> getReservation(const std::string& vehiclePlate);
+    std::optional<Reservation::ReservationEntity> getReservation(std::string_view vehiclePlate);
     //-----------
-    std::optional<Vehicle::VehicleEntity> getVehicle(const std::string& vehiclePlate);
+    std::optional<Vehicle::VehicleEntity> getVehicle(std::string_view vehiclePlate);
 
     // --- Use Case Functions (from specific OCDs) ---
     //-----------
@@ -61,22 +105,74 @@ namespace Controller {
     //-----------
     void createNewSailing(const std::string& vesselID, const std::string& sailingID);
     //-----------
-    void createNewReservation(const std::string& sailingID, const std::string& vehiclePlate);
+    // Places the vehicle in a lane (see LaneAllocator) and records the
+    // reservation. Returns false, booking nothing, if no lane can take it.
+    bool createNewReservation(const std::string& sailingID, const std::string& vehiclePlate);
     //-----------
     void createNewVehicle(const std::string& vehiclePlate, const std::string& phoneNumber, double length, double height);
     //-----------
-    void cancelReservation(const std::string& sailingID, const std::string& vehiclePlate);
+    // Frees the vehicle's lane space and, in the same call, books as many
+    // waitlisted vehicles (oldest request first) as now fit. Returns the
+    // plates that were promoted. Does nothing if the vehicle has no
+    // reservation on `sailingID`.
+    std::vector<std::string> cancelReservation(const std::string& sailingID, const std::string& vehiclePlate);
+    //-----------
+    // Queues the vehicle for `sailingID`. Returns false if the vehicle or
+    // sailing does not exist, or the vehicle is already booked or waiting.
+    bool joinWaitlist(const std::string& sailingID, const std::string& vehiclePlate);
+    //-----------
+    bool leaveWaitlist(const std::string& vehiclePlate);
+    //-----------
+    // Served from memory; does not read Waitlist.dat.
+    std::optional<Waitlist::WaitlistEntity> getWaitlistEntry(const std::string& vehiclePlate);
     //-----------
     void checkInVehicle(const std::string& vehiclePlate);
     //-----------
+    // Checks in a whole boarding queue in one pass over the reservations.
+    // Returns the plates that have no reservation.
+    std::vector<std::string> checkInVehicles(const std::vector<std::string>& vehiclePlates);
+    //-----------
     void deleteSailing(const std::string& sailingID);
     
     
     // --- Query and Report Functions ---
     //-----------
+    // Earliest sailing on `route` (departure terminal, e.g. "YVR") at or
+    // after `fromSailingID` with enough remaining LRL or HRL for a vehicle
+    // of these dimensions, using the same oversize rule and 0.5m buffer
+    // as createNewReservation. O(log n) in the route's sailings.
+    std::optional<Sailing::SailingEntity> findEarliestFittingSailing(
+        const std::string& route,           // in
+        double length,                      // in: vehicle length in metres
+        double height,                      // in: vehicle height in metres
+        const std::string& fromSailingID    // in: "" to search from the first sailing
+    );
+    //-----------
+    // Capacity, metres used and vehicle count of every lane of a sailing.
+    std::vector<LaneAllocator::LaneOccupancy> getLaneOccupancy(const std::string& sailingID);
+    //-----------
     std::vector<Sailing::SailingEntity> getSailingReport(int offset);
     //-----------
+    // Pins the current version of the sailing table. Every page fetched
+    // with the overload below sees that same point in time, no matter
+    // what bookings or deletions happen meanwhile.
+    Sailing::SailingSnapshot openSailingReport();
+    //-----------
+    std::vector<Sailing::SailingEntity> getSailingReport(const Sailing::SailingSnapshot& snapshot, int offset);
+    //-----------
     Sailing::SailingEntity queryIndividualSailing(const std::string& sailingID);
+    //-----------
+    // Up to `k` sailings with the most remaining LRL or HRL, largest first,
+    // optionally restricted to one vessel ("" = whole fleet).
+    std::vector<Sailing::SailingEntity> getTopSailingsByCapacity(
+        CapacityIndex::Lane lane,       // in: lane pool to rank by
+        int k,                          // in: number of sailings wanted
+        const std::string& vesselID     // in: vessel filter, "" for all
+    );
+    //-----------
+    // Remaining and booked lane metres across all sailings of a vessel.
+    // Served from the in-memory aggregate; does not read Sailings.dat.
+    CapacityIndex::VesselAggregate getVesselCapacitySummary(const std::string& vesselID);
 }
 
 #endif // CONTROLLER_H
\ No newline at end of file
@@ -0,0 +1,88 @@
+// IdDictionary.cpp
+//*******************************
+// IdDictionary.cpp
+//
+// Two in-memory indexes over Ids.dat: a vector from key to ID (keys are
+// dense, so key - 1 is the index) and a hash map from ID to key. Reads
+// share a std::shared_mutex; intern() of a new ID appends one record
+// under the exclusive lock. The map is keyed on Utility::FixedText, so
+// find() builds its probe key in place and never allocates.
+//
+// Rev 1.2 - 2025-08-25 - reload()
+// Rev 1.1 - 2025-08-19 - Fixed-width map keys: allocation-free find()
+// Rev 1.0 - 2025-08-17 - Initial version
+//*******************************
+
+#include "IdDictionary.h"
+#include "Utility.h"
+#include <algorithm>
+#include <iostream>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace IdDictionary {
+
+    namespace {
+        std::shared_mutex dictionaryLock;
+        std::vector<std::string> idsByKey;                  // key - 1 -> ID
+        using IdText = Utility::FixedText<sizeof(IdEntity::id)>;
+        std::unordered_map<IdText, Key, IdText::Hash> keysById;  // ID -> key
+
+        Key findLocked(std::string_view id) {
+            auto found = keysById.find(IdText(id));
+            return found == keysById.end() ? NO_KEY : found->second;
+        }
+    }
+
+    void init() {
+        reload();
+        std::cout << "MODEL/IdDictionary: Initialized." << std::endl;
+    }
+
+    void reload() {
+        std::unique_lock<std::shared_mutex> guard(dictionaryLock);
+        idsByKey.clear();
+        keysById.clear();
+        for (const auto& entity : Utility::readAllRecords<IdEntity>()) {
+            idsByKey.emplace_back(IdText::ofField(entity.id).view());
+            keysById[IdText(idsByKey.back())] = static_cast<Key>(idsByKey.size());
+        }
+    }
+
+    void shutdown() {
+        std::cout << "MODEL/IdDictionary: Shut down." << std::endl;
+    }
+
+    Key intern(std::string_view id) {
+        {
+            std::shared_lock<std::shared_mutex> guard(dictionaryLock);
+            Key key = findLocked(id);
+            if (key != NO_KEY) return key;
+        }
+        std::unique_lock<std::shared_mutex> guard(dictionaryLock);
+        Key key = findLocked(id);
+        if (key != NO_KEY) return key;
+
+        IdEntity entity;
+        memset(&entity, 0, sizeof(IdEntity));
+        entity.key = static_cast<Key>(idsByKey.size() + 1);
+        if (!id.empty()) memcpy(entity.id, id.data(), std::min<size_t>(id.size(), 20));
+        Utility::createRecord(entity);
+        idsByKey.emplace_back(entity.id);
+        keysById[IdText(idsByKey.back())] = entity.key;
+        return entity.key;
+    }
+
+    Key find(std::string_view id) {
+        std::shared_lock<std::shared_mutex> guard(dictionaryLock);
+        return findLocked(id);
+    }
+
+    std::string name(Key key) {
+        std::shared_lock<std::shared_mutex> guard(dictionaryLock);
+        if (key == NO_KEY || key > idsByKey.size()) return {};
+        return idsByKey[key - 1];
+    }
+}
@@ -0,0 +1,71 @@
+// IdDictionary.h
+//******************************************************************
+// DEFINITION MODULE: IdDictionary
+//
+// PURPOSE:          Interning table that maps string IDs (sailing IDs,
+//                   vehicle plates) to dense 32-bit surrogate keys, so
+//                   high-volume records can store and compare 4-byte keys
+//                   instead of 21-byte strings. Keys are handed out in
+//                   order starting at 1 and never reused or removed, so a
+//                   key read from disk always names the same ID.
+//
+//                   Every key is persisted in Ids.dat as it is assigned;
+//                   the whole table is held in memory after init().
+//                   Lookups take a shared lock and may run concurrently.
+//
+// (* Revision History:
+//   Rev. 1.2 - 2025/08/25 - Added reload()
+//   Rev. 1.1 - 2025/08/18 - Naturally aligned schema 2 layout
+//   Rev. 1.0 - 2025/08/17 - Initial version
+// *)
+//******************************************************************
+#ifndef ID_DICTIONARY_H
+#define ID_DICTIONARY_H
+
+#include <cstdint>
+#include <cstring> // For strcmp
+#include <string>
+#include <string_view>
+
+namespace IdDictionary {
+
+    using Key = uint32_t;
+    // Never assigned; returned by find() for an ID that has no key.
+    const Key NO_KEY = 0;
+
+    // Entity structure for persistent storage. The record at file
+    // position p holds key p + 1.
+    struct IdEntity {
+        Key key;
+        char id[21];               // Fixed-length 20 chars + null
+        char reserved[3];
+
+        // Equality operator for CRUD operations
+        bool operator==(const IdEntity& other) const {
+            return strcmp(id, other.id) == 0;
+        }
+    };
+    static_assert(sizeof(IdEntity) == 28, "IdEntity is an on-disk layout");
+
+    //-----------
+    // Loads Ids.dat.
+    void init();
+    //-----------
+    // Loads Ids.dat again, without init()'s message, to pick up keys
+    // another process has assigned.
+    void reload();
+    //-----------
+    void shutdown();
+    //-----------
+    // The key for `id`, assigning (and persisting) a new one if needed.
+    Key intern(std::string_view id);
+    //-----------
+    // The key for `id`, or NO_KEY if it has never been interned. Never
+    // writes, so a query for an unknown ID costs no I/O.
+    Key find(std::string_view id);
+    //-----------
+    // The ID a key stands for; empty for NO_KEY or an unknown key.
+    std::string name(Key key);
+}
+
+#endif // ID_DICTIONARY_H
@@ -0,0 +1,458 @@
+// LaneAllocator.cpp
+//*******************************
+// LaneAllocator.cpp
+//
+// Per-sailing lane model. Each deck keeps the free metres of every lane
+// plus an ordered set of (free metres, lane) so the best-fit lane is a
+// single lower_bound. Booking and cancelling are an erase + insert in
+// that set: O(log lanes). Only a booking that fails best-fit on a deck
+// with enough total free space triggers the O(v log v) repack of that
+// deck.
+//
+// Every lane change is also appended to the checkpoint delta log, so a
+// restart can restore the lane tables without reading Reservations.dat.
+// Tables restored that way carry no per-vehicle detail; it is read back
+// from the data files only when a repack of that sailing needs it.
+//
+// Rev 1.5 - 2025-08-25 - load() reports whether it wrote lanes back
+// Rev 1.4 - 2025-08-25 - Cold load places reservations converted from schema 1
+// Rev 1.3 - 2025-08-17 - Join reservations to vehicles on IdDictionary keys
+// Rev 1.2 - 2025-08-16 - Cold load reads and resolves reservations on a thread pool
+// Rev 1.1 - 2025-08-15 - Checkpoint export/import, lazily loaded occupants
+// Rev 1.0 - 2025-08-12 - Initial version
+//*******************************
+
+#include "LaneAllocator.h"
+#include "Checkpoint.h"
+#include "IdDictionary.h"
+#include "Reservation.h"
+#include "Sailing.h"
+#include "Utility.h"
+#include "Vessel.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <future>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace LaneAllocator {
+
+    namespace {
+        // Tolerance for comparing sums of lane metres.
+        const double EPSILON = 1e-9;
+
+        struct DeckState {
+            std::vector<double> capacity;               // Per lane
+            std::vector<double> used;                   // Per lane
+            std::vector<int> vehicles;                  // Per lane
+            std::set<std::pair<double, int>> byFree;    // (free metres, lane)
+
+            double freeIn(int lane) const { return capacity[lane] - used[lane]; }
+
+            double totalFree() const {
+                double total = 0.0;
+                for (size_t lane = 0; lane < capacity.size(); lane++) total += freeIn(static_cast<int>(lane));
+                return total;
+            }
+
+            void reset(double deckMetres) {
+                int lanes = laneCount(deckMetres);
+                capacity.assign(lanes, lanes ? deckMetres / lanes : 0.0);
+                used.assign(lanes, 0.0);
+                vehicles.assign(lanes, 0);
+                byFree.clear();
+                for (int lane = 0; lane < lanes; lane++) byFree.insert({ capacity[lane], lane });
+            }
+
+            // Smallest gap that holds `length`, or -1.
+            int bestFit(double length) const {
+                auto it = byFree.lower_bound({ length - EPSILON, -1 });
+                return it == byFree.end() ? -1 : it->second;
+            }
+
+            void add(int lane, double length) {
+                byFree.erase({ freeIn(lane), lane });
+                used[lane] += length;
+                vehicles[lane]++;
+                byFree.insert({ freeIn(lane), lane });
+            }
+
+            void remove(int lane, double length) {
+                byFree.erase({ freeIn(lane), lane });
+                used[lane] -= length;
+                vehicles[lane]--;
+                byFree.insert({ freeIn(lane), lane });
+            }
+
+            double metres() const {
+                double total = 0.0;
+                for (double lane : capacity) total += lane;
+                return total;
+            }
+        };
+
+        struct Occupant {
+            Deck deck;
+            int lane;
+            double length;
+        };
+
+        struct SailingState {
+            DeckState decks[2];
+            std::unordered_map<std::string, Occupant> occupants; // plate -> lane
+            // False when restored from a checkpoint: `occupants` is empty
+            // until hydrateLocked() reads it back from the data files.
+            bool occupantsLoaded = true;
+
+            DeckState& of(Deck deck) { return decks[static_cast<int>(deck)]; }
+        };
+
+        std::mutex allocatorLock;
+        std::unordered_map<std::string, SailingState> sailings; // sailingID -> lanes
+
+        SailingState makeSailing(double LCLL, double HCLL) {
+            SailingState state;
+            state.of(Deck::Low).reset(LCLL);
+            state.of(Deck::High).reset(HCLL);
+            return state;
+        }
+
+        // Returns the lanes of `sailingID`, sizing them from the vessel if
+        // the sailing was created since load(). The lock is dropped while
+        // the sailing and vessel are looked up.
+        SailingState* findOrCreateLocked(std::unique_lock<std::mutex>& guard, const std::string& sailingID) {
+            auto found = sailings.find(sailingID);
+            if (found != sailings.end()) return &found->second;
+
+            guard.unlock();
+            auto sailing = Sailing::getSailing(sailingID);
+            auto vessel = sailing ? Vessel::getVessel(sailing->vesselID) : std::nullopt;
+            guard.lock();
+            if (!vessel) return nullptr;
+            const double LCLL = vessel->LCLL, HCLL = vessel->HCLL;
+            auto created = sailings.try_emplace(sailingID, makeSailing(LCLL, HCLL));
+            if (created.second) Checkpoint::logSailingAdded(sailingID, LCLL, HCLL);
+            return &created.first->second;
+        }
+
+        void logLaneLocked(const std::string& sailingID, SailingState& state, Deck deck, int lane) {
+            const DeckState& decks = state.of(deck);
+            Checkpoint::logLane(sailingID, static_cast<int>(deck), lane, decks.used[lane], decks.vehicles[lane]);
+        }
+
+        // Reads the vehicles booked on `sailingID` (and their lengths) back
+        // from Reservations.dat and Vehicles.dat: one pass over each.
+        void hydrateLocked(const std::string& sailingID, SailingState& state) {
+            std::unordered_map<std::string, Occupant> found;
+            IdDictionary::Key sailingKey = IdDictionary::find(sailingID);
+            if (sailingKey != IdDictionary::NO_KEY) {
+                Utility::scanRecords<Reservation::ReservationEntity>([&](int, const Reservation::ReservationEntity& r) {
+                    if (r.sailingKey == sailingKey) {
+                        Deck deck = r.deck == static_cast<unsigned char>(Deck::High) ? Deck::High : Deck::Low;
+                        found[IdDictionary::name(r.plateKey)] = { deck, r.lane, 0.0 };
+                    }
+                    return true;
+                });
+            }
+            size_t remaining = found.size();
+            if (remaining > 0) {
+                Utility::scanRecords<Vehicle::VehicleEntity>([&](int, const Vehicle::VehicleEntity& v) {
+                    auto occupant = found.find(v.plate);
+                    if (occupant != found.end()) {
+                        occupant->second.length = occupiedLength(v);
+                        remaining--;
+                    }
+                    return remaining > 0;
+                });
+            }
+            state.occupants = std::move(found);
+            state.occupantsLoaded = true;
+        }
+
+        // Rebuilds `deck` best-fit decreasing with every vehicle already on
+        // it plus the new one. On success the new vehicle's lane is
+        // returned and `moves` lists the vehicles that changed lane; on
+        // failure the deck is left untouched.
+        int repackLocked(const std::string& sailingID, SailingState& state, Deck deck,
+                         const std::string& newPlate, double newLength, std::vector<Move>& moves) {
+            DeckState& current = state.of(deck);
+            if (current.totalFree() + EPSILON < newLength) return -1;
+            if (!state.occupantsLoaded) hydrateLocked(sailingID, state);
+
+            std::vector<std::pair<double, std::string>> items;
+            for (const auto& [plate, occupant] : state.occupants) {
+                if (occupant.deck == deck) items.push_back({ occupant.length, plate });
+            }
+            items.push_back({ newLength, newPlate });
+            std::sort(items.begin(), items.end(), [](const auto& a, const auto& b) {
+                if (a.first != b.first) return a.first > b.first;
+                return a.second < b.second;
+            });
+
+            DeckState packed;
+            packed.reset(current.metres());
+
+            std::unordered_map<std::string, int> assigned;
+            for (const auto& [length, plate] : items) {
+                int lane = packed.bestFit(length);
+                if (lane < 0) return -1;
+                packed.add(lane, length);
+                assigned[plate] = lane;
+            }
+
+            current = std::move(packed);
+            for (size_t lane = 0; lane < current.capacity.size(); lane++) {
+                logLaneLocked(sailingID, state, deck, static_cast<int>(lane));
+            }
+            for (auto& [plate, occupant] : state.occupants) {
+                if (occupant.deck != deck) continue;
+                int lane = assigned[plate];
+                if (lane != occupant.lane) {
+                    occupant.lane = lane;
+                    moves.push_back({ plate, { deck, lane } });
+                }
+            }
+            return assigned[newPlate];
+        }
+
+        std::optional<Placement> placeOnDeckLocked(const std::string& sailingID, SailingState& state, Deck deck,
+                                                   const std::string& plate, double length, std::vector<Move>& moves) {
+            DeckState& decks = state.of(deck);
+            int lane = decks.bestFit(length);
+            if (lane >= 0) {
+                decks.add(lane, length);
+                logLaneLocked(sailingID, state, deck, lane);
+            } else {
+                lane = repackLocked(sailingID, state, deck, plate, length, moves);
+                if (lane < 0) return {};
+            }
+            if (state.occupantsLoaded) state.occupants[plate] = { deck, lane, length };
+            return Placement{ deck, lane };
+        }
+    }
+
+    int laneCount(double deckMetres) {
+        if (deckMetres <= 0) return 0;
+        int lanes = static_cast<int>(std::lround(deckMetres / STANDARD_LANE_METRES));
+        return std::clamp(lanes, 1, MAX_LANES_PER_DECK);
+    }
+
+    double occupiedLength(const Vehicle::VehicleEntity& vehicle) {
+        // Assume 4.5m for regular vehicles, include 0.5m buffer
+        return (vehicle.length > 0 ? vehicle.length : 4.5) + 0.5;
+    }
+
+    bool needsHighDeck(const Vehicle::VehicleEntity& vehicle) {
+        return vehicle.height > 2.0 || occupiedLength(vehicle) > 7.0;
+    }
+
+    bool load(ThreadPool& pool) {
+        std::unordered_map<std::string, Vessel::VesselEntity> vessels;
+        for (const auto& vessel : Utility::readAllRecords<Vessel::VesselEntity>()) {
+            vessels[vessel.vesselID] = vessel;
+        }
+        // Only plates with a key can appear on a reservation.
+        struct VehicleSize {
+            double length;
+            bool highDeckOnly;
+        };
+        std::unordered_map<IdDictionary::Key, VehicleSize> lengths;
+        for (const auto& vehicle : Utility::readAllRecords<Vehicle::VehicleEntity>(pool)) {
+            IdDictionary::Key plateKey = IdDictionary::find(vehicle.plate);
+            if (plateKey != IdDictionary::NO_KEY) lengths[plateKey] = { occupiedLength(vehicle), needsHighDeck(vehicle) };
+        }
+
+        // Resolve every reservation's vehicle length chunk by chunk on the
+        // pool; the lane tables are then filled in file order below.
+        struct Booking {
+            const Reservation::ReservationEntity* reservation;
+            double length;
+            bool highDeckOnly;
+        };
+        std::vector<Reservation::ReservationEntity> reservations =
+            Utility::readAllRecords<Reservation::ReservationEntity>(pool);
+        const size_t chunk = Utility::LOAD_CHUNK_RECORDS;
+        std::vector<std::future<std::vector<Booking>>> resolved;
+        for (size_t first = 0; first < reservations.size(); first += chunk) {
+            size_t last = std::min(reservations.size(), first + chunk);
+            resolved.push_back(pool.submit([&reservations, &lengths, first, last]() {
+                std::vector<Booking> bookings;
+                bookings.reserve(last - first);
+                for (size_t i = first; i < last; i++) {
+                    auto length = lengths.find(reservations[i].plateKey);
+                    if (length != lengths.end()) {
+                        bookings.push_back({ &reservations[i], length->second.length, length->second.highDeckOnly });
+                    }
+                }
+                return bookings;
+            }));
+        }
+
+        // Reservations converted from schema 1 have no lane yet. They are
+        // placed once every recorded lane is filled, as a booking would be
+        // (or, if the original release overbooked the sailing, in the
+        // emptiest lane of their deck), and their lanes saved below.
+        std::unordered_map<std::string, std::vector<Reservation::LaneAssignment>> placed;
+        {
+            std::lock_guard<std::mutex> guard(allocatorLock);
+            sailings.clear();
+            std::unordered_map<IdDictionary::Key, SailingState*> byKey;
+            for (const auto& sailing : Utility::readAllRecords<Sailing::SailingEntity>()) {
+                auto vessel = vessels.find(sailing.vesselID);
+                if (vessel == vessels.end()) continue;
+                SailingState& state = sailings[sailing.sailingID] = makeSailing(vessel->second.LCLL, vessel->second.HCLL);
+                IdDictionary::Key sailingKey = IdDictionary::find(sailing.sailingID);
+                if (sailingKey != IdDictionary::NO_KEY) byKey[sailingKey] = &state;
+            }
+
+            std::vector<std::pair<SailingState*, Booking>> unplaced;
+            for (auto& bookings : resolved) {
+                for (const Booking& booking : bookings.get()) {
+                    const Reservation::ReservationEntity& reservation = *booking.reservation;
+                    auto sailing = byKey.find(reservation.sailingKey);
+                    if (sailing == byKey.end()) continue;
+
+                    SailingState& state = *sailing->second;
+                    if (reservation.lane == Reservation::UNPLACED_LANE) {
+                        unplaced.push_back({ &state, booking });
+                        continue;
+                    }
+                    Deck deck = reservation.deck == static_cast<unsigned char>(Deck::High) ? Deck::High : Deck::Low;
+                    int lane = reservation.lane;
+                    // Trust the stored lane even if it is now overfull, so the
+                    // model matches what staff were told.
+                    if (lane < static_cast<int>(state.of(deck).capacity.size())) {
+                        state.of(deck).add(lane, booking.length);
+                        state.occupants[IdDictionary::name(reservation.plateKey)] = { deck, lane, booking.length };
+                    }
+                }
+            }
+
+            for (auto& [state, booking] : unplaced) {
+                Deck deck = booking.highDeckOnly ? Deck::High : Deck::Low;
+                int lane = state->of(deck).bestFit(booking.length);
+                if (lane < 0 && deck == Deck::Low && state->of(Deck::High).bestFit(booking.length) >= 0) {
+                    deck = Deck::High;
+                    lane = state->of(deck).bestFit(booking.length);
+                }
+                DeckState& decks = state->of(deck);
+                if (lane < 0 && !decks.byFree.empty()) lane = decks.byFree.rbegin()->second;
+                if (lane < 0) continue; // The deck has no lanes at all
+                decks.add(lane, booking.length);
+                std::string plate = IdDictionary::name(booking.reservation->plateKey);
+                state->occupants[plate] = { deck, lane, booking.length };
+                placed[IdDictionary::name(booking.reservation->sailingKey)].push_back(
+                    { plate, static_cast<unsigned char>(deck), static_cast<unsigned char>(lane) });
+            }
+        }
+        for (const auto& [sailingID, assignments] : placed) Reservation::assignLanes(sailingID, assignments);
+        return !placed.empty();
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> guard(allocatorLock);
+        sailings.clear();
+    }
+
+    std::optional<Placement> place(const std::string& sailingID, const std::string& vehiclePlate,
+                                   double length, bool highDeckOnly, std::vector<Move>& moves) {
+        std::unique_lock<std::mutex> guard(allocatorLock);
+        SailingState* state = findOrCreateLocked(guard, sailingID);
+        if (!state || state->occupants.count(vehiclePlate)) return {};
+
+        if (!highDeckOnly) {
+            auto placement = placeOnDeckLocked(sailingID, *state, Deck::Low, vehiclePlate, length, moves);
+            if (placement) return placement;
+        }
+        return placeOnDeckLocked(sailingID, *state, Deck::High, vehiclePlate, length, moves);
+    }
+
+    std::optional<Placement> release(const std::string& sailingID, const std::string& vehiclePlate,
+                                     const Placement& recorded, double length) {
+        std::lock_guard<std::mutex> guard(allocatorLock);
+        auto sailing = sailings.find(sailingID);
+        if (sailing == sailings.end()) return {};
+        SailingState& state = sailing->second;
+
+        Placement placement = recorded;
+        if (state.occupantsLoaded) {
+            auto occupant = state.occupants.find(vehiclePlate);
+            if (occupant == state.occupants.end()) return {};
+            placement = { occupant->second.deck, occupant->second.lane };
+            length = occupant->second.length;
+            state.occupants.erase(occupant);
+        }
+        DeckState& decks = state.of(placement.deck);
+        if (placement.lane < 0 || placement.lane >= static_cast<int>(decks.capacity.size())) return {};
+        decks.remove(placement.lane, length);
+        logLaneLocked(sailingID, state, placement.deck, placement.lane);
+        return placement;
+    }
+
+    void onSailingCreated(const std::string& sailingID, double LCLL, double HCLL) {
+        std::lock_guard<std::mutex> guard(allocatorLock);
+        sailings[sailingID] = makeSailing(LCLL, HCLL);
+        Checkpoint::logSailingAdded(sailingID, LCLL, HCLL);
+    }
+
+    void onSailingDeleted(const std::string& sailingID) {
+        std::lock_guard<std::mutex> guard(allocatorLock);
+        sailings.erase(sailingID);
+        Checkpoint::logSailingDropped(sailingID);
+    }
+
+    std::vector<SailingTable> exportTables() {
+        std::lock_guard<std::mutex> guard(allocatorLock);
+        std::vector<SailingTable> tables;
+        tables.reserve(sailings.size());
+        for (auto& [sailingID, state] : sailings) {
+            SailingTable table;
+            table.sailingID = sailingID;
+            for (Deck deck : { Deck::Low, Deck::High }) {
+                const DeckState& decks = state.of(deck);
+                DeckTable& out = table.decks[static_cast<int>(deck)];
+                out.metres = decks.metres();
+                out.used = decks.used;
+                out.vehicles = decks.vehicles;
+            }
+            tables.push_back(std::move(table));
+        }
+        return tables;
+    }
+
+    void importTables(const std::vector<SailingTable>& tables) {
+        std::lock_guard<std::mutex> guard(allocatorLock);
+        sailings.clear();
+        for (const auto& table : tables) {
+            SailingState& state = sailings[table.sailingID];
+            state.occupantsLoaded = false;
+            for (Deck deck : { Deck::Low, Deck::High }) {
+                const DeckTable& in = table.decks[static_cast<int>(deck)];
+                DeckState& decks = state.of(deck);
+                decks.reset(in.metres);
+                for (size_t lane = 0; lane < decks.capacity.size() && lane < in.used.size(); lane++) {
+                    decks.add(static_cast<int>(lane), in.used[lane]);
+                    decks.vehicles[lane] = in.vehicles[lane];
+                }
+            }
+        }
+    }
+
+    std::vector<LaneOccupancy> occupancy(const std::string& sailingID) {
+        std::unique_lock<std::mutex> guard(allocatorLock);
+        std::vector<LaneOccupancy> result;
+        SailingState* sailing = findOrCreateLocked(guard, sailingID);
+        if (!sailing) return result;
+        for (Deck deck : { Deck::Low, Deck::High }) {
+            const DeckState& state = sailing->of(deck);
+            for (size_t lane = 0; lane < state.capacity.size(); lane++) {
+                result.push_back({ deck, static_cast<int>(lane), state.capacity[lane],
+                                   state.used[lane], state.vehicles[lane] });
+            }
+        }
+        return result;
+    }
+}
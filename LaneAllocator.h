@@ -0,0 +1,151 @@
+// LaneAllocator.h
+//******************************************************************
+// DEFINITION MODULE: LaneAllocator
+//
+// PURPOSE:          Lane-level model of every sailing's car decks. Each
+//                   vessel deck (low ceiling = LCLL, high ceiling = HCLL)
+//                   is split into individual lanes of roughly
+//                   STANDARD_LANE_METRES each, and every reservation
+//                   occupies one lane, since a vehicle can never straddle
+//                   two lanes. The pooled LRL/HRL figures on the sailing
+//                   record remain the deck totals; this module decides
+//                   whether a vehicle actually fits and where.
+//
+//                   Placement is best-fit: the lane with the smallest gap
+//                   that still holds the vehicle, found in O(log lanes)
+//                   from an ordered set of (free metres, lane). When no
+//                   single gap is large enough but the deck as a whole
+//                   is, the deck is repacked best-fit decreasing (longest
+//                   vehicle first) and the vehicles that changed lane are
+//                   reported back so their reservations can be updated.
+//
+//                   load() rebuilds the state from the lane stored on every
+//                   reservation. A warm start instead restores the lane
+//                   tables from the checkpoint (see Checkpoint) and reads
+//                   per-vehicle detail back only for sailings that need a
+//                   repack.
+//
+// (* Revision History:
+//   Rev. 1.4 - 2025/08/25 - load() reports whether it wrote lanes back
+//   Rev. 1.3 - 2025/08/25 - Cold load places unplaced reservations
+//   Rev. 1.2 - 2025/08/16 - Parallel cold load
+//   Rev. 1.1 - 2025/08/15 - Checkpoint export/import of lane tables
+//   Rev. 1.0 - 2025/08/12 - Initial version
+// *)
+//******************************************************************
+#ifndef LANE_ALLOCATOR_H
+#define LANE_ALLOCATOR_H
+
+#include <optional>
+#include <string>
+#include <vector>
+#include "Vehicle.h"
+#include "ThreadPool.h"
+
+namespace LaneAllocator {
+
+    // Nominal length of one lane; a deck of L metres gets round(L / 100)
+    // lanes (at least one) of equal length.
+    const double STANDARD_LANE_METRES = 100.0;
+    const int MAX_LANES_PER_DECK = 255;
+
+    enum class Deck {
+        Low = 0,    // Low ceiling deck (LCLL / LRL)
+        High = 1    // High ceiling deck (HCLL / HRL)
+    };
+
+    struct Placement {
+        Deck deck;
+        int lane;
+    };
+
+    // A vehicle that a repack moved to a different lane.
+    struct Move {
+        std::string vehiclePlate;
+        Placement to;
+    };
+
+    struct LaneOccupancy {
+        Deck deck;
+        int lane;
+        double capacity;    // Lane length in metres
+        double used;        // Metres taken by vehicles (buffers included)
+        int vehicles;
+    };
+
+    // Lane table of one deck, as saved in a checkpoint.
+    struct DeckTable {
+        double metres = 0.0;            // Deck length (LCLL or HCLL)
+        std::vector<double> used;       // Per lane
+        std::vector<int> vehicles;      // Per lane
+    };
+
+    struct SailingTable {
+        std::string sailingID;
+        DeckTable decks[2];             // Indexed by Deck
+    };
+
+    //-----------
+    // Number of lanes a deck of `deckMetres` is split into.
+    int laneCount(double deckMetres);
+    //-----------
+    // Deck space a vehicle takes: its length (4.5m if unknown) plus the
+    // 0.5m buffer.
+    double occupiedLength(const Vehicle::VehicleEntity& vehicle);
+    //-----------
+    // Oversize vehicles (over 2.0m tall or over 7.0m occupied) may only
+    // use the high ceiling deck.
+    bool needsHighDeck(const Vehicle::VehicleEntity& vehicle);
+
+    //-----------
+    // Rebuilds every sailing's lanes from Vessels.dat, Sailings.dat,
+    // Vehicles.dat and the lane stored on each reservation. Reservations
+    // with no lane (Reservation::UNPLACED_LANE) are placed and their
+    // lanes written back. The large files are read and resolved in
+    // chunks on `pool`; call from a thread that is not one of its workers.
+    // Returns true if any lane was written back.
+    bool load(ThreadPool& pool);
+    //-----------
+    void clear();
+
+    //-----------
+    // Finds a lane for `vehiclePlate` on `sailingID` and reserves it.
+    // Regular vehicles try the low deck first, then the high deck;
+    // oversize vehicles only the high deck. Returns nothing (and changes
+    // nothing) if the vehicle does not fit. Vehicles relocated by a
+    // repack are appended to `moves`.
+    std::optional<Placement> place(
+        const std::string& sailingID,           // in
+        const std::string& vehiclePlate,        // in
+        double length,                          // in:  occupied length (see occupiedLength)
+        bool highDeckOnly,                      // in:  see needsHighDeck
+        std::vector<Move>& moves                // out: lane changes of other vehicles
+    );
+    //-----------
+    // Frees the lane space held by `vehiclePlate`. `recorded` and `length`
+    // (the lane stored on the reservation and the vehicle's occupied
+    // length) are used when the sailing's per-vehicle detail has not been
+    // loaded. Returns where it was, or nothing if the vehicle had no space
+    // on this sailing.
+    std::optional<Placement> release(
+        const std::string& sailingID,           // in
+        const std::string& vehiclePlate,        // in
+        const Placement& recorded,              // in
+        double length                           // in
+    );
+    //-----------
+    void onSailingCreated(const std::string& sailingID, double LCLL, double HCLL);
+    //-----------
+    void onSailingDeleted(const std::string& sailingID);
+    //-----------
+    // Lane tables of every sailing, for a checkpoint.
+    std::vector<SailingTable> exportTables();
+    //-----------
+    // Replaces all state with `tables`; per-vehicle detail is loaded lazily.
+    void importTables(const std::vector<SailingTable>& tables);
+    //-----------
+    // Every lane of the sailing, low deck first. Empty if unknown.
+    std::vector<LaneOccupancy> occupancy(const std::string& sailingID);
+}
+
+#endif // LANE_ALLOCATOR_H
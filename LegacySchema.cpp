@@ -0,0 +1,130 @@
+// LegacySchema.cpp
+//*******************************
+// LegacySchema.cpp
+//
+// Field-by-field copies between the schema 1 packed records and the
+// schema 2 entity structs. Text fields have the same length in both, so
+// they are copied whole. Reservation IDs go through the IdDictionary.
+//
+// Rev 1.1 - 2025-08-25 - Reservations convert between ID strings and keys
+// Rev 1.0 - 2025-08-18 - Initial version
+//*******************************
+
+#include "LegacySchema.h"
+#include "Vessel.h"
+#include "Sailing.h"
+#include "Vehicle.h"
+#include "Reservation.h"
+#include "Waitlist.h"
+#include "IdDictionary.h"
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+namespace LegacySchema {
+
+    namespace {
+        template <size_t N, size_t M>
+        void copyText(char (&to)[N], const char (&from)[M]) {
+            static_assert(N == M, "Text field lengths differ between schemas");
+            memcpy(to, from, N);
+        }
+
+        template <size_t N>
+        std::string_view textOf(const char (&field)[N]) {
+            return std::string_view(field, strnlen(field, N - 1));
+        }
+
+        template <size_t N>
+        void copyName(char (&to)[N], const std::string& name) {
+            memset(to, 0, N);
+            memcpy(to, name.data(), std::min(name.size(), N - 1));
+        }
+    }
+
+    void upgrade(const VesselRecord& in, Vessel::VesselEntity& out) {
+        out = {};
+        copyText(out.vesselID, in.vesselID);
+        out.LCLL = in.LCLL;
+        out.HCLL = in.HCLL;
+    }
+
+    void upgrade(const SailingRecord& in, Sailing::SailingEntity& out) {
+        out = {};
+        copyText(out.sailingID, in.sailingID);
+        copyText(out.vesselID, in.vesselID);
+        out.LRL = in.LRL;
+        out.HRL = in.HRL;
+    }
+
+    void upgrade(const VehicleRecord& in, Vehicle::VehicleEntity& out) {
+        out = {};
+        copyText(out.plate, in.plate);
+        copyText(out.phone, in.phone);
+        out.length = in.length;
+        out.height = in.height;
+    }
+
+    void upgrade(const ReservationRecord& in, Reservation::ReservationEntity& out) {
+        out = {};
+        out.sailingKey = IdDictionary::intern(textOf(in.sailingID));
+        out.plateKey = IdDictionary::intern(textOf(in.vehiclePlate));
+        out.checkedIn = in.checkedIn;
+        out.lane = Reservation::UNPLACED_LANE;
+    }
+
+    void upgrade(const WaitlistRecord& in, Waitlist::WaitlistEntity& out) {
+        out = {};
+        copyText(out.sailingID, in.sailingID);
+        copyText(out.vehiclePlate, in.vehiclePlate);
+        out.sequence = in.sequence;
+        out.requestTime = in.requestTime;
+        out.vehicleClass = in.vehicleClass;
+    }
+
+    void upgrade(const IdRecord& in, IdDictionary::IdEntity& out) {
+        out = {};
+        out.key = in.key;
+        copyText(out.id, in.id);
+    }
+
+    void downgrade(const Vessel::VesselEntity& in, VesselRecord& out) {
+        copyText(out.vesselID, in.vesselID);
+        out.LCLL = in.LCLL;
+        out.HCLL = in.HCLL;
+    }
+
+    void downgrade(const Sailing::SailingEntity& in, SailingRecord& out) {
+        copyText(out.sailingID, in.sailingID);
+        copyText(out.vesselID, in.vesselID);
+        out.LRL = in.LRL;
+        out.HRL = in.HRL;
+    }
+
+    void downgrade(const Vehicle::VehicleEntity& in, VehicleRecord& out) {
+        copyText(out.plate, in.plate);
+        copyText(out.phone, in.phone);
+        out.length = in.length;
+        out.height = in.height;
+    }
+
+    void downgrade(const Reservation::ReservationEntity& in, ReservationRecord& out) {
+        copyName(out.sailingID, IdDictionary::name(in.sailingKey));
+        copyName(out.vehiclePlate, IdDictionary::name(in.plateKey));
+        out.checkedIn = in.checkedIn;
+    }
+
+    void downgrade(const Waitlist::WaitlistEntity& in, WaitlistRecord& out) {
+        copyText(out.sailingID, in.sailingID);
+        copyText(out.vehiclePlate, in.vehiclePlate);
+        out.sequence = in.sequence;
+        out.requestTime = in.requestTime;
+        out.vehicleClass = in.vehicleClass;
+    }
+
+    void downgrade(const IdDictionary::IdEntity& in, IdRecord& out) {
+        out.key = in.key;
+        copyText(out.id, in.id);
+    }
+}
@@ -0,0 +1,110 @@
+// LegacySchema.h
+//******************************************************************
+// DEFINITION MODULE: LegacySchema
+//
+// PURPOSE:          The schema 1 record layouts: byte-packed structs
+//                   written with no file header, as every data file was
+//                   stored before schema 2 aligned the entity structs and
+//                   added a FileHeader (see Utility.h). Utility reads and
+//                   writes schema 1 files through these layouts so an
+//                   unmigrated Data directory keeps working, and
+//                   migrateData converts them for good.
+//
+//                   Only the layouts and the field-by-field conversions
+//                   live here; the entity headers describe schema 2 alone.
+//
+//                   Schema 1 reservations are the records of the original
+//                   release: ID strings and no lane. Upgrading one interns
+//                   its IDs (IdDictionary must be loaded) and leaves it
+//                   unplaced; the application does not use such a file
+//                   until migrateData has converted it.
+//
+// (* Revision History:
+//   Rev. 1.1 - 2025/08/25 - Reservations use the original release's layout
+//   Rev. 1.0 - 2025/08/18 - Initial version
+// *)
+//******************************************************************
+#ifndef LEGACY_SCHEMA_H
+#define LEGACY_SCHEMA_H
+
+#include <cstdint>
+
+namespace Vessel { struct VesselEntity; }
+namespace Sailing { struct SailingEntity; }
+namespace Vehicle { struct VehicleEntity; }
+namespace Reservation { struct ReservationEntity; }
+namespace Waitlist { struct WaitlistEntity; }
+namespace IdDictionary { struct IdEntity; }
+
+namespace LegacySchema {
+
+    #pragma pack(push, 1)
+    struct VesselRecord {
+        char vesselID[21];
+        double LCLL;
+        double HCLL;
+    };
+
+    struct SailingRecord {
+        char sailingID[21];
+        char vesselID[21];
+        double LRL;
+        double HRL;
+    };
+
+    struct VehicleRecord {
+        char plate[21];
+        char phone[16];
+        double length;
+        double height;
+    };
+
+    struct ReservationRecord {
+        char sailingID[21];
+        char vehiclePlate[21];
+        bool checkedIn;
+    };
+
+    struct WaitlistRecord {
+        char sailingID[21];
+        char vehiclePlate[21];
+        uint64_t sequence;
+        int64_t requestTime;
+        unsigned char vehicleClass;
+    };
+
+    struct IdRecord {
+        uint32_t key;
+        char id[21];
+    };
+    #pragma pack(pop)
+
+    // Schema 1 layout of each entity type.
+    template <typename T> struct Layout;
+    template <> struct Layout<Vessel::VesselEntity> { using Record = VesselRecord; };
+    template <> struct Layout<Sailing::SailingEntity> { using Record = SailingRecord; };
+    template <> struct Layout<Vehicle::VehicleEntity> { using Record = VehicleRecord; };
+    template <> struct Layout<Reservation::ReservationEntity> { using Record = ReservationRecord; };
+    template <> struct Layout<Waitlist::WaitlistEntity> { using Record = WaitlistRecord; };
+    template <> struct Layout<IdDictionary::IdEntity> { using Record = IdRecord; };
+
+    //-----------
+    // Schema 1 -> schema 2. Padding in `out` is zeroed.
+    void upgrade(const VesselRecord& in, Vessel::VesselEntity& out);
+    void upgrade(const SailingRecord& in, Sailing::SailingEntity& out);
+    void upgrade(const VehicleRecord& in, Vehicle::VehicleEntity& out);
+    void upgrade(const ReservationRecord& in, Reservation::ReservationEntity& out);
+    void upgrade(const WaitlistRecord& in, Waitlist::WaitlistEntity& out);
+    void upgrade(const IdRecord& in, IdDictionary::IdEntity& out);
+    //-----------
+    // Schema 2 -> schema 1, for writes to a file not yet migrated. A
+    // reservation loses its deck and lane.
+    void downgrade(const Vessel::VesselEntity& in, VesselRecord& out);
+    void downgrade(const Sailing::SailingEntity& in, SailingRecord& out);
+    void downgrade(const Vehicle::VehicleEntity& in, VehicleRecord& out);
+    void downgrade(const Reservation::ReservationEntity& in, ReservationRecord& out);
+    void downgrade(const Waitlist::WaitlistEntity& in, WaitlistRecord& out);
+    void downgrade(const IdDictionary::IdEntity& in, IdRecord& out);
+}
+
+#endif // LEGACY_SCHEMA_H
@@ -0,0 +1,268 @@
+// Metrics.cpp
+//*******************************
+// Metrics.cpp
+//
+// Latency histograms for Controller operations. Each thread records into
+// its own set of histograms (guarded by an uncontended per-thread mutex);
+// the registry of all thread sets is only walked when a report is built.
+//
+// Rev 1.3 - 2025-08-21 - Averages include preallocations
+// Rev 1.2 - 2025-08-07 - Cache counters and active session gauge
+// Rev 1.1 - 2025-08-06 - Per-operation I/O attribution and EXPLAIN output
+// Rev 1.0 - 2025-08-05 - Initial version
+//*******************************
+
+#include "Metrics.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace Metrics {
+
+    namespace {
+        const char* const OPERATION_NAMES[OPERATION_COUNT] = {
+            "checkVesselExists",
+            "checkSailingExists",
+            "checkReservationExists",
+            "checkVehicleExists",
+            "getVessel",
+            "getSailing",
+            "getReservation",
+            "getVehicle",
+            "createNewVessel",
+            "createNewSailing",
+            "createNewReservation",
+            "createNewVehicle",
+            "cancelReservation",
+            "joinWaitlist",
+            "leaveWaitlist",
+            "getWaitlistEntry",
+            "checkInVehicle",
+            "checkInVehicles",
+            "deleteSailing",
+            "getSailingReport",
+            "queryIndividualSailing",
+            "getTopSailingsByCapacity",
+            "getVesselCapacitySummary",
+            "getLaneOccupancy",
+            "findEarliestFittingSailing",
+        };
+
+        struct ThreadHistograms {
+            std::mutex lock;
+            std::array<LatencyHistogram, OPERATION_COUNT> ops;
+            std::array<Utility::IoStats, OPERATION_COUNT> io;
+        };
+
+        std::atomic<std::ostream*> explainStream{ nullptr };
+
+        std::mutex cacheLock;
+        std::map<std::string, std::unique_ptr<CacheCounter>> caches;
+
+        std::atomic<int> sessions{ 0 };
+
+        // Every thread's histogram set is kept here, including threads that
+        // have exited, so their samples still appear in reports.
+        std::mutex registryLock;
+        std::vector<std::shared_ptr<ThreadHistograms>> registry;
+
+        ThreadHistograms& localHistograms() {
+            thread_local std::shared_ptr<ThreadHistograms> mine = [] {
+                auto created = std::make_shared<ThreadHistograms>();
+                std::lock_guard<std::mutex> guard(registryLock);
+                registry.push_back(created);
+                return created;
+            }();
+            return *mine;
+        }
+
+        double toMicros(uint64_t ns) { return ns / 1000.0; }
+    }
+
+    const char* operationName(Operation op) {
+        return OPERATION_NAMES[static_cast<size_t>(op)];
+    }
+
+    // --- LatencyHistogram ---
+    size_t LatencyHistogram::bucketIndex(uint64_t ns) {
+        if (ns > MAX_TRACKABLE_NS) ns = MAX_TRACKABLE_NS;
+        if (ns < 2 * SUB_BUCKETS) return static_cast<size_t>(ns);
+        int msb = 63;
+        while (!(ns >> msb)) msb--;
+        int shift = msb - SUB_BUCKET_BITS;
+        return static_cast<size_t>(shift) * SUB_BUCKETS + static_cast<size_t>(ns >> shift);
+    }
+
+    uint64_t LatencyHistogram::bucketUpperBound(size_t index) {
+        if (index < 2 * SUB_BUCKETS) return index;
+        size_t shift = index / SUB_BUCKETS - 1;
+        uint64_t mantissa = index - shift * SUB_BUCKETS;
+        return ((mantissa + 1) << shift) - 1;
+    }
+
+    void LatencyHistogram::record(uint64_t ns) {
+        buckets[bucketIndex(ns)]++;
+        total++;
+        sum += ns;
+        if (ns > maxValue) maxValue = ns;
+    }
+
+    void LatencyHistogram::merge(const LatencyHistogram& other) {
+        for (size_t i = 0; i < BUCKET_COUNT; i++) buckets[i] += other.buckets[i];
+        total += other.total;
+        sum += other.sum;
+        maxValue = std::max(maxValue, other.maxValue);
+    }
+
+    void LatencyHistogram::reset() {
+        buckets.fill(0);
+        total = 0;
+        sum = 0;
+        maxValue = 0;
+    }
+
+    uint64_t LatencyHistogram::percentile(double p) const {
+        if (total == 0) return 0;
+        uint64_t target = static_cast<uint64_t>(std::ceil(p * total));
+        if (target == 0) target = 1;
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKET_COUNT; i++) {
+            seen += buckets[i];
+            if (seen >= target) return std::min(bucketUpperBound(i), maxValue);
+        }
+        return maxValue;
+    }
+
+    // --- Recording and reporting ---
+    void recordOperation(Operation op, uint64_t ns, const Utility::IoStats& io) {
+        ThreadHistograms& local = localHistograms();
+        {
+            std::lock_guard<std::mutex> guard(local.lock);
+            local.ops[static_cast<size_t>(op)].record(ns);
+            local.io[static_cast<size_t>(op)] += io;
+        }
+
+        std::ostream* explain = explainStream.load(std::memory_order_relaxed);
+        if (explain != nullptr) {
+            *explain << "EXPLAIN " << operationName(op) << " (" << toMicros(ns) << " us)\n";
+            Utility::printIoStats(*explain, io, "  ");
+            explain->flush();
+        }
+    }
+
+    Utility::IoStats ioTotals(Operation op) {
+        Utility::IoStats merged;
+        std::lock_guard<std::mutex> guard(registryLock);
+        for (auto& thread : registry) {
+            std::lock_guard<std::mutex> threadGuard(thread->lock);
+            merged += thread->io[static_cast<size_t>(op)];
+        }
+        return merged;
+    }
+
+    void setExplain(std::ostream* out) {
+        explainStream.store(out, std::memory_order_relaxed);
+    }
+
+    LatencyHistogram snapshot(Operation op) {
+        LatencyHistogram merged;
+        std::lock_guard<std::mutex> guard(registryLock);
+        for (auto& thread : registry) {
+            std::lock_guard<std::mutex> threadGuard(thread->lock);
+            merged.merge(thread->ops[static_cast<size_t>(op)]);
+        }
+        return merged;
+    }
+
+    std::vector<OperationSummary> summaries() {
+        std::vector<OperationSummary> rows;
+        for (size_t i = 0; i < OPERATION_COUNT; i++) {
+            Operation op = static_cast<Operation>(i);
+            LatencyHistogram h = snapshot(op);
+            if (h.count() == 0) continue;
+            rows.push_back({ op, h.count(), h.mean() / 1000.0,
+                             toMicros(h.percentile(0.50)), toMicros(h.percentile(0.99)),
+                             toMicros(h.percentile(0.999)), toMicros(h.max()) });
+        }
+        return rows;
+    }
+
+    void dump(std::ostream& out) {
+        auto rows = summaries();
+        out << "METRICS: Controller operation latency (microseconds)\n";
+        if (rows.empty()) {
+            out << "  (no operations recorded)" << std::endl;
+            return;
+        }
+        std::ios::fmtflags flags = out.flags();
+        std::streamsize precision = out.precision();
+        out << "  " << std::left << std::setw(24) << "operation" << std::right
+            << std::setw(10) << "count" << std::setw(11) << "mean" << std::setw(11) << "p50"
+            << std::setw(11) << "p99" << std::setw(11) << "p999" << std::setw(11) << "max" << "\n";
+        out << std::fixed << std::setprecision(1);
+        for (const auto& row : rows) {
+            out << "  " << std::left << std::setw(24) << operationName(row.op) << std::right
+                << std::setw(10) << row.count << std::setw(11) << row.meanUs << std::setw(11) << row.p50Us
+                << std::setw(11) << row.p99Us << std::setw(11) << row.p999Us << std::setw(11) << row.maxUs << "\n";
+        }
+
+        out << "METRICS: Average file I/O per call\n";
+        for (const auto& row : rows) {
+            Utility::IoStats average = ioTotals(row.op);
+            for (auto& file : average.files) {
+                file.opens /= row.count;
+                file.seeks /= row.count;
+                file.bytesRead /= row.count;
+                file.bytesWritten /= row.count;
+                file.recordsScanned /= row.count;
+                file.truncates /= row.count;
+                file.fsyncs /= row.count;
+                file.preallocations /= row.count;
+            }
+            out << "  " << operationName(row.op) << "\n";
+            Utility::printIoStats(out, average, "    ");
+        }
+        out.flush();
+        out.flags(flags);
+        out.precision(precision);
+    }
+
+    void reset() {
+        std::lock_guard<std::mutex> guard(registryLock);
+        for (auto& thread : registry) {
+            std::lock_guard<std::mutex> threadGuard(thread->lock);
+            for (auto& h : thread->ops) h.reset();
+            thread->io.fill(Utility::IoStats());
+        }
+    }
+
+    // --- Cache counters ---
+    CacheCounter& cacheCounter(const std::string& name) {
+        std::lock_guard<std::mutex> guard(cacheLock);
+        auto& counter = caches[name];
+        if (!counter) counter = std::make_unique<CacheCounter>();
+        return *counter;
+    }
+
+    std::vector<CacheSummary> cacheSummaries() {
+        std::vector<CacheSummary> rows;
+        std::lock_guard<std::mutex> guard(cacheLock);
+        for (auto& [name, counter] : caches) {
+            rows.push_back({ name, counter->hits.load(std::memory_order_relaxed),
+                             counter->misses.load(std::memory_order_relaxed) });
+        }
+        return rows;
+    }
+
+    // --- Sessions ---
+    void sessionStarted() { sessions.fetch_add(1); }
+
+    void sessionEnded() { sessions.fetch_sub(1); }
+
+    int activeSessions() { return sessions.load(); }
+
+} // end namespace Metrics
@@ -0,0 +1,198 @@
+// Metrics.h
+//******************************************************************
+// DEFINITION MODULE: Metrics
+//
+// PURPOSE:          Built-in latency instrumentation for the Controller.
+//                   Every Controller entry point opens a ScopedTimer which
+//                   records the elapsed time into an HDR-style (log-linear)
+//                   histogram owned by the calling thread. Histograms are
+//                   merged across threads only when a report is requested,
+//                   so the recording path only ever takes the calling
+//                   thread's own (uncontended) lock.
+//
+//                   The timer also attributes the Utility I/O counters
+//                   (opens, seeks, bytes, records scanned, ...) that move
+//                   during the call to the operation, and can print an
+//                   EXPLAIN-style summary of each call for debugging.
+//
+//                   Also holds the process-wide gauges that are not tied
+//                   to one operation: cache hit/miss counters and the
+//                   number of active UI/batch sessions.
+//
+// (* Revision History:
+//   Rev. 1.2 - 2025/08/07 - Cache counters and active session gauge
+//   Rev. 1.1 - 2025/08/06 - Per-operation I/O attribution and EXPLAIN output
+//   Rev. 1.0 - 2025/08/05 - Initial version
+// *)
+//******************************************************************
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "Utility.h"
+
+namespace Metrics {
+
+    // One entry per instrumented Controller entry point.
+    enum class Operation {
+        CheckVesselExists,
+        CheckSailingExists,
+        CheckReservationExists,
+        CheckVehicleExists,
+        GetVessel,
+        GetSailing,
+        GetReservation,
+        GetVehicle,
+        CreateNewVessel,
+        CreateNewSailing,
+        CreateNewReservation,
+        CreateNewVehicle,
+        CancelReservation,
+        JoinWaitlist,
+        LeaveWaitlist,
+        GetWaitlistEntry,
+        CheckInVehicle,
+        CheckInVehicles,
+        DeleteSailing,
+        GetSailingReport,
+        QueryIndividualSailing,
+        GetTopSailingsByCapacity,
+        GetVesselCapacitySummary,
+        GetLaneOccupancy,
+        FindEarliestFittingSailing,
+        COUNT
+    };
+
+    const size_t OPERATION_COUNT = static_cast<size_t>(Operation::COUNT);
+
+    //-----------
+    // Returns the Controller function name for an operation.
+    const char* operationName(Operation op);
+
+    // Log-linear latency histogram in nanoseconds. Each power of two is
+    // split into SUB_BUCKETS linear buckets, giving ~3% relative error
+    // from 64ns up to MAX_TRACKABLE_NS; larger values are clamped.
+    class LatencyHistogram {
+    public:
+        static const int SUB_BUCKET_BITS = 5;
+        static const uint64_t SUB_BUCKETS = 1u << SUB_BUCKET_BITS;
+        static const int MAX_SHIFT = 40 - SUB_BUCKET_BITS;
+        static const uint64_t MAX_TRACKABLE_NS = (uint64_t(1) << 40) - 1;
+        static const size_t BUCKET_COUNT = (MAX_SHIFT + 1) * SUB_BUCKETS + SUB_BUCKETS;
+
+        void record(uint64_t ns);
+        void merge(const LatencyHistogram& other);
+        void reset();
+
+        uint64_t count() const { return total; }
+        uint64_t max() const { return maxValue; }
+        double mean() const { return total ? static_cast<double>(sum) / total : 0.0; }
+        // Value (ns) at or below which `p` (0.0 - 1.0) of samples fall.
+        uint64_t percentile(double p) const;
+
+        static size_t bucketIndex(uint64_t ns);
+        static uint64_t bucketUpperBound(size_t index);
+
+    private:
+        std::array<uint64_t, BUCKET_COUNT> buckets{};
+        uint64_t total = 0;
+        uint64_t sum = 0;
+        uint64_t maxValue = 0;
+    };
+
+    // Summary row for one operation, as exposed to reports.
+    struct OperationSummary {
+        Operation op;
+        uint64_t count;
+        double meanUs;
+        double p50Us;
+        double p99Us;
+        double p999Us;
+        double maxUs;
+    };
+
+    //-----------
+    // Adds one call of `op` (latency sample plus the file I/O it caused)
+    // to the calling thread's totals.
+    void recordOperation(Operation op, uint64_t ns, const Utility::IoStats& io);
+    //-----------
+    // Merges every thread's histogram for `op` into one.
+    LatencyHistogram snapshot(Operation op);
+    //-----------
+    // Summaries for every operation that has at least one sample.
+    std::vector<OperationSummary> summaries();
+    //-----------
+    // Total file I/O attributed to `op` across all threads.
+    Utility::IoStats ioTotals(Operation op);
+    //-----------
+    // Prints a human-readable latency table followed by the average
+    // file I/O per call of each operation.
+    void dump(std::ostream& out);
+    //-----------
+    // When `out` is non-null, every timed call prints its latency and
+    // per-file I/O to `out` as it completes. Pass nullptr to disable.
+    void setExplain(std::ostream* out);
+    //-----------
+    // Clears every histogram (all threads).
+    void reset();
+
+    // --- Cache counters ---
+    struct CacheCounter {
+        std::atomic<uint64_t> hits{ 0 };
+        std::atomic<uint64_t> misses{ 0 };
+
+        void hit() { hits.fetch_add(1, std::memory_order_relaxed); }
+        void miss() { misses.fetch_add(1, std::memory_order_relaxed); }
+    };
+
+    struct CacheSummary {
+        std::string name;
+        uint64_t hits;
+        uint64_t misses;
+    };
+
+    //-----------
+    // Returns the counter registered under `name`, creating it on first
+    // use. The reference stays valid for the life of the program, so
+    // callers should look it up once and keep it.
+    CacheCounter& cacheCounter(const std::string& name);
+    //-----------
+    std::vector<CacheSummary> cacheSummaries();
+
+    // --- Sessions ---
+    //-----------
+    void sessionStarted();
+    //-----------
+    void sessionEnded();
+    //-----------
+    int activeSessions();
+
+    // RAII timer: records the lifetime of the object, and the I/O done
+    // by this thread meanwhile, against `op`.
+    class ScopedTimer {
+    public:
+        explicit ScopedTimer(Operation op)
+            : op(op), ioAtStart(Utility::ioStats()), start(std::chrono::steady_clock::now()) {}
+        ~ScopedTimer() {
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            recordOperation(op, static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()),
+                Utility::ioStats() - ioAtStart);
+        }
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    private:
+        Operation op;
+        Utility::IoStats ioAtStart;
+        std::chrono::steady_clock::time_point start;
+    };
+}
+
+#endif // METRICS_H
@@ -0,0 +1,194 @@
+// MetricsExporter.cpp
+//*******************************
+// MetricsExporter.cpp
+//
+// Prometheus text format exporter. A single background thread wakes up
+// on a fixed interval, renders every metric into a string and atomically
+// replaces the configured textfile.
+//
+// Rev 1.4 - 2025-08-25 - File bytes are the size on disk; logical bytes added
+// Rev 1.3 - 2025-08-17 - ID dictionary record count
+// Rev 1.2 - 2025-08-13 - Waitlist record count
+// Rev 1.1 - 2025-08-09 - Per-vessel lane metre gauges
+// Rev 1.0 - 2025-08-07 - Initial version
+//*******************************
+
+#include "MetricsExporter.h"
+#include "Metrics.h"
+#include "Utility.h"
+#include "Vessel.h"
+#include "Sailing.h"
+#include "Vehicle.h"
+#include "Reservation.h"
+#include "Waitlist.h"
+#include "IdDictionary.h"
+#include "CapacityIndex.h"
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+namespace MetricsExporter {
+
+    namespace {
+        std::mutex exporterLock;
+        std::condition_variable wakeUp;
+        std::thread worker;
+        bool running = false;
+        bool stopRequested = false;
+        std::string exportPath;
+
+        const char* const ENTITY_LABELS[Utility::ENTITY_COUNT] = {
+            "vessel", "sailing", "vehicle", "reservation", "waitlist", "id"
+        };
+
+        template <typename T>
+        void writeEntity(std::ostream& records, std::ostream& bytes, std::ostream& logical) {
+            size_t index = Utility::entityIndex<T>();
+            Utility::FileLayout layout = Utility::fileLayout<T>();
+            records << "ferry_records{entity=\"" << ENTITY_LABELS[index] << "\"} " << layout.records() << "\n";
+            bytes << "ferry_data_file_bytes{file=\"" << Utility::entityFileName(index) << "\"} "
+                  << layout.allocatedBytes << "\n";
+            logical << "ferry_data_logical_bytes{file=\"" << Utility::entityFileName(index) << "\"} "
+                    << layout.fileBytes << "\n";
+        }
+
+        void writeCounter(std::ostream& out, const char* name, const char* help,
+                          const Utility::IoStats& totals, uint64_t Utility::IoCounters::*field) {
+            out << "# HELP " << name << " " << help << "\n"
+                << "# TYPE " << name << " counter\n";
+            for (size_t i = 0; i < Utility::ENTITY_COUNT; i++) {
+                out << name << "{file=\"" << Utility::entityFileName(i) << "\"} "
+                    << totals.files[i].*field << "\n";
+            }
+        }
+
+        bool writeFile(const std::string& path) {
+            std::ostringstream text;
+            writePrometheus(text);
+
+            std::string tempPath = path + ".tmp";
+            {
+                std::ofstream file(tempPath, std::ios::trunc);
+                if (!file) return false;
+                file << text.str();
+                if (!file) return false;
+            }
+            std::error_code ec;
+            std::filesystem::rename(tempPath, path, ec);
+            return !ec;
+        }
+
+        void exportLoop(int intervalSeconds) {
+            std::unique_lock<std::mutex> lock(exporterLock);
+            while (!stopRequested) {
+                std::string path = exportPath;
+                lock.unlock();
+                if (!writeFile(path)) {
+                    std::cerr << "ERROR: Could not write metrics file: " << path << std::endl;
+                }
+                lock.lock();
+                wakeUp.wait_for(lock, std::chrono::seconds(intervalSeconds), [] { return stopRequested; });
+            }
+        }
+    }
+
+    void writePrometheus(std::ostream& out) {
+        // --- Storage ---
+        std::ostringstream records, bytes, logical;
+        writeEntity<Vessel::VesselEntity>(records, bytes, logical);
+        writeEntity<Sailing::SailingEntity>(records, bytes, logical);
+        writeEntity<Vehicle::VehicleEntity>(records, bytes, logical);
+        writeEntity<Reservation::ReservationEntity>(records, bytes, logical);
+        writeEntity<Waitlist::WaitlistEntity>(records, bytes, logical);
+        writeEntity<IdDictionary::IdEntity>(records, bytes, logical);
+        out << "# HELP ferry_records Number of records stored per entity.\n"
+            << "# TYPE ferry_records gauge\n" << records.str()
+            << "# HELP ferry_data_file_bytes Size of each data file on disk in bytes, including preallocated space.\n"
+            << "# TYPE ferry_data_file_bytes gauge\n" << bytes.str()
+            << "# HELP ferry_data_logical_bytes Bytes of each data file in use: the header and records.\n"
+            << "# TYPE ferry_data_logical_bytes gauge\n" << logical.str();
+
+        // --- Per-vessel lane metres (from the in-memory aggregate) ---
+        out << "# HELP ferry_vessel_lane_metres Lane metres across all sailings of a vessel.\n"
+            << "# TYPE ferry_vessel_lane_metres gauge\n";
+        for (const auto& [vesselID, totals] : CapacityIndex::allVesselAggregates()) {
+            out << "ferry_vessel_lane_metres{vessel=\"" << vesselID << "\",lane=\"LRL\",state=\"remaining\"} " << totals.remainingLRL << "\n"
+                << "ferry_vessel_lane_metres{vessel=\"" << vesselID << "\",lane=\"LRL\",state=\"booked\"} " << totals.bookedLRL() << "\n"
+                << "ferry_vessel_lane_metres{vessel=\"" << vesselID << "\",lane=\"HRL\",state=\"remaining\"} " << totals.remainingHRL << "\n"
+                << "ferry_vessel_lane_metres{vessel=\"" << vesselID << "\",lane=\"HRL\",state=\"booked\"} " << totals.bookedHRL() << "\n";
+        }
+
+        // --- Operation latency ---
+        auto rows = Metrics::summaries();
+        out << "# HELP ferry_operation_latency_seconds Controller operation latency.\n"
+            << "# TYPE ferry_operation_latency_seconds summary\n";
+        Utility::IoStats ioTotals;
+        for (const auto& row : rows) {
+            const char* name = Metrics::operationName(row.op);
+            out << "ferry_operation_latency_seconds{operation=\"" << name << "\",quantile=\"0.5\"} " << row.p50Us / 1e6 << "\n"
+                << "ferry_operation_latency_seconds{operation=\"" << name << "\",quantile=\"0.99\"} " << row.p99Us / 1e6 << "\n"
+                << "ferry_operation_latency_seconds{operation=\"" << name << "\",quantile=\"0.999\"} " << row.p999Us / 1e6 << "\n"
+                << "ferry_operation_latency_seconds_sum{operation=\"" << name << "\"} " << row.meanUs * row.count / 1e6 << "\n"
+                << "ferry_operation_latency_seconds_count{operation=\"" << name << "\"} " << row.count << "\n";
+            ioTotals += Metrics::ioTotals(row.op);
+        }
+
+        // --- File I/O attributed to Controller operations ---
+        writeCounter(out, "ferry_file_opens_total", "File opens by Controller operations.", ioTotals, &Utility::IoCounters::opens);
+        writeCounter(out, "ferry_file_records_scanned_total", "Records read by Controller operations.", ioTotals, &Utility::IoCounters::recordsScanned);
+        writeCounter(out, "ferry_file_read_bytes_total", "Bytes read by Controller operations.", ioTotals, &Utility::IoCounters::bytesRead);
+        writeCounter(out, "ferry_file_written_bytes_total", "Bytes written by Controller operations.", ioTotals, &Utility::IoCounters::bytesWritten);
+        writeCounter(out, "ferry_file_fsyncs_total", "fsync calls by Controller operations.", ioTotals, &Utility::IoCounters::fsyncs);
+
+        // --- Caches ---
+        auto caches = Metrics::cacheSummaries();
+        out << "# HELP ferry_cache_requests_total Cache lookups by result.\n"
+            << "# TYPE ferry_cache_requests_total counter\n";
+        for (const auto& cache : caches) {
+            out << "ferry_cache_requests_total{cache=\"" << cache.name << "\",result=\"hit\"} " << cache.hits << "\n"
+                << "ferry_cache_requests_total{cache=\"" << cache.name << "\",result=\"miss\"} " << cache.misses << "\n";
+        }
+        out << "# HELP ferry_cache_hit_ratio Fraction of cache lookups that hit.\n"
+            << "# TYPE ferry_cache_hit_ratio gauge\n";
+        for (const auto& cache : caches) {
+            uint64_t total = cache.hits + cache.misses;
+            out << "ferry_cache_hit_ratio{cache=\"" << cache.name << "\"} "
+                << (total ? static_cast<double>(cache.hits) / total : 0.0) << "\n";
+        }
+
+        // --- Sessions ---
+        out << "# HELP ferry_active_sessions Interactive and batch sessions currently running.\n"
+            << "# TYPE ferry_active_sessions gauge\n"
+            << "ferry_active_sessions " << Metrics::activeSessions() << "\n";
+    }
+
+    bool start(const std::string& path, int intervalSeconds) {
+        std::lock_guard<std::mutex> guard(exporterLock);
+        if (running) return false;
+        exportPath = path;
+        stopRequested = false;
+        running = true;
+        worker = std::thread(exportLoop, intervalSeconds < 1 ? 1 : intervalSeconds);
+        return true;
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> guard(exporterLock);
+            if (!running) return;
+            stopRequested = true;
+        }
+        wakeUp.notify_all();
+        worker.join();
+
+        std::lock_guard<std::mutex> guard(exporterLock);
+        running = false;
+        writeFile(exportPath);
+    }
+
+} // end namespace MetricsExporter
@@ -0,0 +1,47 @@
+// MetricsExporter.h
+//******************************************************************
+// DEFINITION MODULE: MetricsExporter
+//
+// PURPOSE:          Publishes the system's counters in the Prometheus
+//                   text exposition format so the terminal box can be
+//                   scraped (node_exporter textfile collector) and alerted
+//                   on. Exposes per-entity record counts and file sizes,
+//                   per-vessel remaining/booked lane metres,
+//                   Controller operation latencies, per-file I/O including
+//                   fsyncs, cache hit/miss counters and active sessions.
+//
+// (* Revision History:
+//   Rev. 1.1 - 2025/08/09 - Per-vessel lane metre gauges
+//   Rev. 1.0 - 2025/08/07 - Initial version
+// *)
+//******************************************************************
+#ifndef METRICS_EXPORTER_H
+#define METRICS_EXPORTER_H
+
+#include <ostream>
+#include <string>
+
+namespace MetricsExporter {
+
+    //-----------
+    // Writes one complete exposition of every metric to `out`.
+    void writePrometheus(std::ostream& out);
+
+    //-----------
+    // Starts a background thread that rewrites `path` every
+    // `intervalSeconds`. Each export is written to a temporary file and
+    // renamed over `path`, so a scraper never sees a partial file.
+    // Returns false if an exporter is already running.
+    bool start(
+        const std::string& path,    // in: destination textfile (e.g. Data/ferry.prom)
+        int intervalSeconds         // in: seconds between exports (>= 1)
+    );
+
+    //-----------
+    // Writes a final export and stops the background thread (no-op if
+    // the exporter is not running).
+    void stop();
+
+}
+
+#endif // METRICS_EXPORTER_H
@@ -0,0 +1,238 @@
+// ReportReplica.cpp
+//*******************************
+// ReportReplica.cpp
+//
+// Sailings.dat mapped read-only, and a seqlock-style copy loop over the
+// mapping. The mapping is shared by every thread of the reporting
+// process: reads hold mappingLock shared, and only remapping takes it
+// exclusively. Nothing here ever writes to the file or blocks a writer,
+// except a report that falls back to the shared file lock.
+//
+// Rev 1.0 - 2025-08-23 - Initial version
+//*******************************
+
+#include "ReportReplica.h"
+#include "Utility.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ReportReplica {
+
+    namespace {
+        using Sailing::SailingEntity;
+        using Utility::FileHeader;
+
+        const char* const PATH = Utility::getFilePath<SailingEntity>();
+
+        std::shared_mutex mappingLock;
+        bool opened = false;
+        int fd = -1;                   // The file mapped (kept open for fstat and the fallback lock)
+        const char* base = nullptr;    // Its mapping; null while the file is missing or empty
+        long long mappedBytes = 0;
+
+        std::atomic<uint64_t> reads{ 0 };
+        std::atomic<uint64_t> retries{ 0 };
+        std::atomic<uint64_t> fallbacks{ 0 };
+        std::atomic<uint64_t> remaps{ 0 };
+
+        const FileHeader* header() { return reinterpret_cast<const FileHeader*>(base); }
+
+        const SailingEntity* records() {
+            return reinterpret_cast<const SailingEntity*>(base + sizeof(FileHeader));
+        }
+
+        // Complete records before `end`, within the mapping.
+        size_t recordsBefore(long long end) {
+            end = std::min(end, mappedBytes);
+            if (end <= static_cast<long long>(sizeof(FileHeader))) return 0;
+            return static_cast<size_t>((end - static_cast<long long>(sizeof(FileHeader))) / sizeof(SailingEntity));
+        }
+
+        void unmapLocked() {
+            if (base != nullptr) ::munmap(const_cast<char*>(base), static_cast<size_t>(mappedBytes));
+            base = nullptr;
+            mappedBytes = 0;
+        }
+
+        void closeLocked() {
+            unmapLocked();
+            if (fd >= 0) ::close(fd);
+            fd = -1;
+        }
+
+        // Maps all of `fd` as it is now, replacing any mapping. Leaves the
+        // old mapping on failure.
+        bool mapLocked(std::string& error) {
+            struct stat info;
+            if (::fstat(fd, &info) != 0) {
+                error = std::string("could not stat ") + PATH + ": " + strerror(errno);
+                return false;
+            }
+            if (info.st_size == 0) return true; // No sailings yet
+            if (info.st_size < static_cast<off_t>(sizeof(FileHeader))) {
+                error = std::string(PATH) + " is in schema 1; migrate it first";
+                return false;
+            }
+            void* view = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+            if (view == MAP_FAILED) {
+                error = std::string("could not map ") + PATH + ": " + strerror(errno);
+                return false;
+            }
+            const FileHeader* mapped = static_cast<const FileHeader*>(view);
+            const char* unusable = nullptr;
+            if (memcmp(mapped->magic, Utility::FILE_MAGIC, sizeof(Utility::FILE_MAGIC)) != 0) {
+                unusable = " is in schema 1; migrate it first";
+            } else if (mapped->schemaVersion != Utility::SCHEMA_VERSION ||
+                       mapped->recordSize != sizeof(SailingEntity)) {
+                unusable = " has an unsupported schema version or record size";
+            }
+            if (unusable != nullptr) {
+                ::munmap(view, static_cast<size_t>(info.st_size));
+                error = std::string(PATH) + unusable;
+                return false;
+            }
+            unmapLocked();
+            base = static_cast<const char*>(view);
+            mappedBytes = static_cast<long long>(info.st_size);
+            remaps++;
+            return true;
+        }
+
+        // Opens and maps the file now at PATH. A missing file is not an error.
+        bool reopenLocked(std::string& error) {
+            closeLocked();
+            fd = ::open(PATH, O_RDONLY | O_CLOEXEC);
+            if (fd < 0) {
+                if (errno == ENOENT) return true;
+                error = std::string("could not open ") + PATH + ": " + strerror(errno);
+                return false;
+            }
+            return mapLocked(error);
+        }
+
+        // True if the file at PATH is not the one mapped: it has appeared,
+        // been replaced, or had nothing to map last time. A file removed
+        // meanwhile keeps being served as it was.
+        bool staleLocked() {
+            struct stat onDisk;
+            if (::stat(PATH, &onDisk) != 0) return false;
+            struct stat mapped;
+            if (fd < 0 || ::fstat(fd, &mapped) != 0) return true;
+            return onDisk.st_ino != mapped.st_ino || onDisk.st_dev != mapped.st_dev || base == nullptr;
+        }
+
+        // The logical end the header gives now; may be past the mapping.
+        long long logicalEndLocked() {
+            if (__atomic_load_n(&header()->flags, __ATOMIC_ACQUIRE) & Utility::HEADER_TRACKS_END) {
+                return static_cast<long long>(__atomic_load_n(&header()->dataEnd, __ATOMIC_ACQUIRE));
+            }
+            struct stat info;
+            return ::fstat(fd, &info) == 0 ? static_cast<long long>(info.st_size) : mappedBytes;
+        }
+
+        // Runs `copy(records, count)` over the mapped records until a run
+        // overlaps no write, then returns. `copy` must start its result
+        // afresh on every call.
+        template <typename Copy>
+        void consistentCopy(Copy copy) {
+            reads++;
+            std::string error;
+            for (int attempt = 0; attempt < MAX_RETRIES; attempt++) {
+                std::shared_lock<std::shared_mutex> guard(mappingLock);
+                if (!opened) return;
+                if (attempt == 0 && staleLocked()) {
+                    guard.unlock();
+                    std::unique_lock<std::shared_mutex> exclusive(mappingLock);
+                    if (staleLocked()) reopenLocked(error);
+                    continue;
+                }
+                if (base == nullptr) return;
+
+                uint64_t done = __atomic_load_n(&header()->writesDone, __ATOMIC_ACQUIRE);
+                long long end = logicalEndLocked();
+                if (end > mappedBytes) {
+                    // Grown past the mapping since it was made.
+                    guard.unlock();
+                    std::unique_lock<std::shared_mutex> exclusive(mappingLock);
+                    if (base != nullptr && logicalEndLocked() > mappedBytes) mapLocked(error);
+                    continue;
+                }
+                copy(records(), recordsBefore(end));
+                // The copy's loads complete before writesBegun is loaded.
+                __atomic_thread_fence(__ATOMIC_ACQUIRE);
+                if (__atomic_load_n(&header()->writesBegun, __ATOMIC_RELAXED) == done) return;
+                retries++;
+                guard.unlock();
+                std::this_thread::yield();
+            }
+
+            // Writers keep overlapping (or one died mid-write): copy with
+            // them locked out.
+            std::unique_lock<std::shared_mutex> exclusive(mappingLock);
+            if (base == nullptr) return;
+            Utility::lockRecords(fd, Utility::LockMode::Shared, -1, 0);
+            if (logicalEndLocked() > mappedBytes) mapLocked(error);
+            copy(records(), recordsBefore(logicalEndLocked()));
+            Utility::unlockFile(fd);
+            fallbacks++;
+        }
+    }
+
+    bool open(std::string& error) {
+        std::unique_lock<std::shared_mutex> guard(mappingLock);
+        if (!reopenLocked(error)) {
+            closeLocked();
+            return false;
+        }
+        opened = true;
+        return true;
+    }
+
+    void close() {
+        std::unique_lock<std::shared_mutex> guard(mappingLock);
+        closeLocked();
+        opened = false;
+    }
+
+    std::vector<SailingEntity> getSailingReport(int offset) {
+        std::vector<SailingEntity> sailings;
+        consistentCopy([&](const SailingEntity* mapped, size_t count) {
+            size_t first = std::min(offset > 0 ? static_cast<size_t>(offset) : 0, count);
+            sailings.assign(mapped + first, mapped + count);
+        });
+        return sailings;
+    }
+
+    std::optional<SailingEntity> queryIndividualSailing(std::string_view sailingID) {
+        std::optional<SailingEntity> found;
+        consistentCopy([&](const SailingEntity* mapped, size_t count) {
+            found.reset();
+            for (size_t i = 0; i < count; i++) {
+                const char* id = mapped[i].sailingID;
+                if (std::string_view(id, strnlen(id, sizeof(mapped[i].sailingID))) == sailingID) {
+                    found = mapped[i];
+                    return;
+                }
+            }
+        });
+        return found;
+    }
+
+    Stats stats() {
+        Stats current;
+        current.reads = reads;
+        current.retries = retries;
+        current.fallbacks = fallbacks;
+        current.remaps = remaps;
+        return current;
+    }
+}
@@ -0,0 +1,70 @@
+// ReportReplica.h
+//******************************************************************
+// DEFINITION MODULE: ReportReplica
+//
+// PURPOSE:          Read-only replica of the sailing table for a separate
+//                   reporting process (ferry --report). Sailings.dat is
+//                   mapped read-only, and reports are copied straight out
+//                   of the pages the booking process writes through,
+//                   without taking any file lock, so no amount of report
+//                   traffic can make a booking wait.
+//
+//                   Consistency comes from the write generations in the
+//                   file header (see Utility::WriteGeneration), used like
+//                   a seqlock: a copy that overlapped a write is thrown
+//                   away and taken again, and after MAX_RETRIES such
+//                   attempts it is taken under a shared file lock instead.
+//                   Every report is one consistent version of the file,
+//                   as of some moment during the call.
+//
+//                   The file is mapped again when its logical end passes
+//                   the mapped size and when it is replaced (migrateFile).
+//                   Schema 1 files cannot be mapped, since deletes
+//                   truncate them; run migrateData first.
+//
+// (* Revision History:
+//   Rev. 1.0 - 2025/08/23 - Initial version
+// *)
+//******************************************************************
+#ifndef REPORT_REPLICA_H
+#define REPORT_REPLICA_H
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Sailing.h"
+
+namespace ReportReplica {
+
+    // Lock-free attempts at a report before it is taken under the lock.
+    const int MAX_RETRIES = 64;
+
+    struct Stats {
+        uint64_t reads = 0;        // Reports and queries served
+        uint64_t retries = 0;      // Copies discarded because a write overlapped
+        uint64_t fallbacks = 0;    // Reports taken under the file lock
+        uint64_t remaps = 0;       // Times the file was (re)mapped
+    };
+
+    //-----------
+    // Maps Sailings.dat. A missing or empty file is mapped once it has
+    // sailings. Returns false, with the reason in `error`, if the file is
+    // not in schema 2 or could not be mapped.
+    bool open(std::string& error);
+    //-----------
+    void close();
+    //-----------
+    // As Controller::getSailingReport(offset): every sailing from
+    // position `offset` on, in file order.
+    std::vector<Sailing::SailingEntity> getSailingReport(int offset);
+    //-----------
+    // As Controller::queryIndividualSailing, but empty if there is no
+    // such sailing.
+    std::optional<Sailing::SailingEntity> queryIndividualSailing(std::string_view sailingID);
+    //-----------
+    Stats stats();
+}
+
+#endif // REPORT_REPLICA_H
@@ -0,0 +1,280 @@
+// Repository.h
+//******************************************************************
+// DEFINITION MODULE: Repository
+//
+// PURPOSE:          A keyed, index-backed view of one entity file, so a
+//                   data module no longer hand-writes a "readRecord until
+//                   nullopt, compare the key" loop for every lookup.
+//
+//                   Each entity declares its key at compile time with a
+//                   key policy (TextKey or IntegerKey over member
+//                   pointers). The first use loads the file with one
+//                   sequential read into a mirror of the records plus a
+//                   hash index from key to file position; after that
+//                   find()/exists() cost no I/O and update()/erase() write
+//                   exactly the record they change. The mirror follows
+//                   Utility's position semantics, including deleteRecord's
+//                   "move the last record into the hole" relocation.
+//
+//                   Keys are unique: insert() refuses a key that is
+//                   already present. Every write to the file must go
+//                   through the repository (the owning module's
+//                   Utility::scanRecords readers are unaffected); call
+//                   reset() if the file was changed behind its back.
+//
+//                   Text keys are Utility::FixedText, built in place from
+//                   a string_view, and view() reads a record where it
+//                   sits, so a lookup makes no heap allocation.
+//
+//                   Lookups report to Metrics::cacheCounter(name): a hit
+//                   is served from the loaded index, a miss had to load
+//                   the file first.
+//
+// (* Revision History:
+//   Rev. 1.1 - 2025/08/19 - Fixed-width text keys and view(): lookups
+//                          never allocate
+//   Rev. 1.0 - 2025/08/19 - Initial version
+// *)
+//******************************************************************
+#ifndef REPOSITORY_H
+#define REPOSITORY_H
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "Utility.h"
+#include "Metrics.h"
+
+namespace RepositoryDetail {
+    template <typename Member> struct MemberType;
+    template <typename Class, typename Field> struct MemberType<Field Class::*> { using Type = Field; };
+}
+
+// Key policy for an entity identified by one fixed-length text field,
+// e.g. TextKey<&Vessel::VesselEntity::vesselID>.
+template <auto Field>
+struct TextKey {
+    using Key = Utility::FixedText<std::extent_v<typename RepositoryDetail::MemberType<decltype(Field)>::Type>>;
+    using Hash = typename Key::Hash;
+
+    template <typename T>
+    static Key keyOf(const T& record) { return Key::ofField(record.*Field); }
+};
+
+// Key policy for an entity identified by one or two 32-bit integer
+// fields, packed into one 64-bit key in declaration order.
+template <auto... Fields>
+struct IntegerKey {
+    static_assert(sizeof...(Fields) >= 1 && sizeof...(Fields) <= 2, "IntegerKey takes one or two fields");
+    using Key = uint64_t;
+    using Hash = std::hash<Key>;
+
+    template <typename T>
+    static Key keyOf(const T& record) {
+        Key key = 0;
+        ((key = (key << 32) | static_cast<uint32_t>(record.*Fields)), ...);
+        return key;
+    }
+};
+
+template <typename T, typename KeyPolicy>
+class Repository {
+public:
+    using Key = typename KeyPolicy::Key;
+
+    // `name` labels the cache counter, e.g. "vehicles".
+    explicit Repository(const char* name) : name(name) {}
+
+    Repository(const Repository&) = delete;
+    Repository& operator=(const Repository&) = delete;
+
+    static Key keyOf(const T& record) { return KeyPolicy::keyOf(record); }
+
+    //-----------
+    // Drops the index; the next call reloads the file.
+    void reset() {
+        std::unique_lock<std::shared_mutex> guard(lock);
+        loaded = false;
+        records.clear();
+        index.clear();
+    }
+    //-----------
+    std::optional<T> find(const Key& key) {
+        std::shared_lock<std::shared_mutex> guard = readLock();
+        auto found = index.find(key);
+        if (found == index.end()) return std::nullopt;
+        return records[found->second];
+    }
+    //-----------
+    // Calls `read(record)` on the stored record with `key`, without
+    // copying it, and returns whether there was one. `read` runs under
+    // the repository's shared lock and must not call back into it.
+    template <typename Reader>
+    bool view(const Key& key, Reader&& read) {
+        std::shared_lock<std::shared_mutex> guard = readLock();
+        auto found = index.find(key);
+        if (found == index.end()) return false;
+        read(static_cast<const T&>(records[found->second]));
+        return true;
+    }
+    //-----------
+    bool exists(const Key& key) {
+        std::shared_lock<std::shared_mutex> guard = readLock();
+        return index.count(key) != 0;
+    }
+    //-----------
+    // The first record, in file order, for which `match(record)` is true.
+    // Scans the in-memory mirror, not the file.
+    template <typename Predicate>
+    std::optional<T> findIf(Predicate match) {
+        std::shared_lock<std::shared_mutex> guard = readLock();
+        for (const T& record : records) {
+            if (match(record)) return record;
+        }
+        return std::nullopt;
+    }
+    //-----------
+    // Appends `record`. Returns false, writing nothing, if its key is
+    // already present.
+    bool insert(const T& record) {
+        std::unique_lock<std::shared_mutex> guard = writeLock();
+        Key key = keyOf(record);
+        if (index.count(key)) return false;
+        Utility::createRecord(record);
+        index.emplace(std::move(key), records.size());
+        records.push_back(record);
+        return true;
+    }
+    //-----------
+    // Overwrites the record with the same key as `record`. Returns false
+    // if there is none.
+    bool update(const T& record) {
+        std::unique_lock<std::shared_mutex> guard = writeLock();
+        auto found = index.find(keyOf(record));
+        if (found == index.end()) return false;
+        Utility::updateRecord(static_cast<int>(found->second), record);
+        records[found->second] = record;
+        return true;
+    }
+    //-----------
+    // Overwrites every listed record with one coalesced write pass.
+    // Records whose key is not present are skipped. Returns how many
+    // were written.
+    size_t updateAll(const std::vector<T>& changed) {
+        std::unique_lock<std::shared_mutex> guard = writeLock();
+        std::vector<std::pair<int, T>> updates;
+        for (const T& record : changed) {
+            auto found = index.find(keyOf(record));
+            if (found == index.end()) continue;
+            updates.emplace_back(static_cast<int>(found->second), record);
+            records[found->second] = record;
+        }
+        size_t written = updates.size();
+        Utility::updateRecords(std::move(updates));
+        return written;
+    }
+    //-----------
+    // Removes the record with `key` and returns it.
+    std::optional<T> erase(const Key& key) {
+        std::unique_lock<std::shared_mutex> guard = writeLock();
+        auto found = index.find(key);
+        if (found == index.end()) return std::nullopt;
+        return eraseLocked(found->second);
+    }
+    //-----------
+    // Removes every record for which `match(record)` is true and returns
+    // them.
+    template <typename Predicate>
+    std::vector<T> eraseIf(Predicate match) {
+        std::unique_lock<std::shared_mutex> guard = writeLock();
+        std::vector<T> removed;
+        // Walk backwards so the record moved into each hole (the last
+        // one) has already been examined.
+        for (size_t position = records.size(); position-- > 0;) {
+            if (!match(records[position])) continue;
+            auto record = eraseLocked(position);
+            if (!record) break;
+            removed.push_back(*record);
+        }
+        return removed;
+    }
+    //-----------
+    size_t size() {
+        std::shared_lock<std::shared_mutex> guard = readLock();
+        return records.size();
+    }
+
+private:
+    const char* name;
+    Metrics::CacheCounter* counter = nullptr;
+    std::shared_mutex lock;
+    bool loaded = false;
+    std::vector<T> records;                  // File order: position -> record
+    std::unordered_map<Key, size_t, typename KeyPolicy::Hash> index;   // Key -> position
+
+    // Caller holds `lock` exclusively.
+    void loadLocked() {
+        // Looked up here rather than in the constructor: repositories
+        // are namespace-scope objects and Metrics may not exist yet.
+        if (!counter) counter = &Metrics::cacheCounter(name);
+        records = Utility::readAllRecords<T>();
+        index.clear();
+        index.reserve(records.size());
+        for (size_t position = 0; position < records.size(); position++) {
+            index.emplace(keyOf(records[position]), position); // First occurrence wins
+        }
+        loaded = true;
+    }
+
+    std::shared_lock<std::shared_mutex> readLock() {
+        bool missed = false;
+        while (true) {
+            std::shared_lock<std::shared_mutex> guard(lock);
+            if (loaded) {
+                if (!missed) counter->hit();
+                return guard;
+            }
+            guard.unlock();
+            std::unique_lock<std::shared_mutex> exclusive(lock);
+            if (!loaded) {
+                loadLocked();
+                counter->miss();
+                missed = true;
+            }
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> writeLock() {
+        std::unique_lock<std::shared_mutex> guard(lock);
+        if (!loaded) loadLocked();
+        return guard;
+    }
+
+    // Mirrors Utility::deleteRecord. Caller holds `lock` exclusively.
+    std::optional<T> eraseLocked(size_t position) {
+        T removed = records[position];
+        if (!Utility::deleteRecord<T>(static_cast<int>(position))) {
+            loaded = false; // The file no longer matches; reload on next use
+            return std::nullopt;
+        }
+        auto self = index.find(keyOf(removed));
+        if (self != index.end() && self->second == position) index.erase(self);
+        size_t last = records.size() - 1;
+        if (position != last) {
+            records[position] = records[last];
+            auto moved = index.find(keyOf(records[position]));
+            if (moved != index.end() && moved->second == last) moved->second = position;
+        }
+        records.pop_back();
+        return removed;
+    }
+};
+
+#endif // REPOSITORY_H
@@ -15,117 +15,203 @@
 //     - Refactored to use Utility functions for CRUD operations
 //   Rev. 1.2 - 2025/07/23
 //     - Added getReservation function implementation
+//   Rev. 1.3 - 2025/08/11
+//     - Added checkInBatch implementation
+//   Rev. 1.4 - 2025/08/12
+//     - Store deck/lane on create, added assignLanes
+//   Rev. 1.5 - 2025/08/15
+//     - Plate Bloom filter; cancelReservation returns the removed record
+//   Rev. 1.6 - 2025/08/16
+//     - Parallel plate filter build
+//   Rev. 1.7 - 2025/08/17
+//     - Match on IdDictionary keys: IDs are resolved once per call and
+//       every scan compares integers
+//   Rev. 1.8 - 2025/08/19
+//     - Lookups and writes go through a Repository keyed on the plate;
+//       deleteReservations removes the right records; lookups take a
+//       string_view and never allocate
+//   Rev. 1.9 - 2025/08/25
+//     - init() refuses a Reservations.dat still in schema 1
 // *)
 //******************************************************************
 #include "Reservation.h"
+#include "Checkpoint.h"
+#include "Repository.h"
 #include <cstring>
+#include <iostream>
 #include <vector>
+#include <unordered_set>
+#include <string_view>
+#include <mutex>
+#include <stdexcept>
 
 using namespace Reservation;
 using namespace Utility;
 
 // No file handles - managed by Utility
 
-void Reservation::init() {}
+namespace {
+    std::mutex filterLock;
+    BloomFilter plateFilter;    // Empty until installed
+    Repository<ReservationEntity, ReservationKey> reservations("reservations");
+}
+
+void Reservation::init() {
+    // A schema 1 file holds the ID strings of the original release and no
+    // lanes; its records cannot be matched by key until it is converted.
+    if (Utility::fileSchema<ReservationEntity>() != Utility::SCHEMA_VERSION) {
+        throw std::runtime_error(std::string(Utility::getFilePath<ReservationEntity>()) +
+                                 " is in schema 1; run run_migrate_data before starting");
+    }
+    reservations.reset();
+}
 
 void Reservation::shutdown() {}
 
-void Reservation::createReservation(const std::string& sailingID, const std::string& vehiclePlate) {
+void Reservation::createReservation(const std::string& sailingID, const std::string& vehiclePlate,
+                                    unsigned char deck, unsigned char lane) {
     // Create entity
     ReservationEntity newEntity;
     memset(&newEntity, 0, sizeof(ReservationEntity));
-    strncpy(newEntity.sailingID, sailingID.c_str(), 20);
-    strncpy(newEntity.vehiclePlate, vehiclePlate.c_str(), 20);
+    newEntity.sailingKey = IdDictionary::intern(sailingID);
+    newEntity.plateKey = IdDictionary::intern(vehiclePlate);
     newEntity.checkedIn = false;
-    
-    // Create record via Utility
-    createRecord(newEntity);
-}
+    newEntity.deck = deck;
+    newEntity.lane = lane;
 
-void Reservation::cancelReservation(const std::string& sailingID, 
-                                   const std::string& vehiclePlate) {
-    // Create search entity
-    ReservationEntity searchEntity;
-    memset(&searchEntity, 0, sizeof(ReservationEntity));
-    strncpy(searchEntity.sailingID, sailingID.c_str(), 20);
-    strncpy(searchEntity.vehiclePlate, vehiclePlate.c_str(), 20);
+    // The filter must know the plate before the record can be seen
+    {
+        std::lock_guard<std::mutex> guard(filterLock);
+        plateFilter.add(vehiclePlate);
+    }
+    Checkpoint::logPlateAdded(vehiclePlate);
     
-    // Delete via Utility
-   int position = 0;
-    while (true) {
-        auto record = Utility::readRecord<ReservationEntity>(position);
-        if (!record.has_value()) break;
-        if (*record == searchEntity) {
-            Utility::deleteRecord<ReservationEntity>(position);
-            return;
-        }
-        position++;
+    // Create record via the repository
+    if (!reservations.insert(newEntity)) {
+        std::cerr << "ERROR: Vehicle '" << vehiclePlate << "' already has a reservation" << std::endl;
     }
 }
 
+std::optional<ReservationEntity> Reservation::cancelReservation(const std::string& sailingID,
+                                                               const std::string& vehiclePlate) {
+    IdDictionary::Key sailingKey = IdDictionary::find(sailingID);
+    IdDictionary::Key plateKey = IdDictionary::find(vehiclePlate);
+    if (sailingKey == IdDictionary::NO_KEY || plateKey == IdDictionary::NO_KEY) return {};
+
+    auto record = reservations.find(plateKey);
+    if (!record || record->sailingKey != sailingKey) return {};
+    return reservations.erase(plateKey);
+}
+
 void Reservation::deleteReservations(const std::string& sailingID) {
-    // Find all reservations for this sailing
-    std::vector<ReservationEntity> toDelete;
-    int position = 0;
-    
-    while (true) {
-        auto record = readRecord<ReservationEntity>(position);
-        if (!record.has_value()) break;
-        
-        if (strcmp(record->sailingID, sailingID.c_str()) == 0) {
-            toDelete.push_back(*record);
-        }
-        position++;
-    }
-    
-    // Delete found records
-    for (auto& entity : toDelete) {
-        Utility::deleteRecord<ReservationEntity>(position);
-    }
+    IdDictionary::Key sailingKey = IdDictionary::find(sailingID);
+    if (sailingKey == IdDictionary::NO_KEY) return;
+    reservations.eraseIf([sailingKey](const ReservationEntity& record) {
+        return record.sailingKey == sailingKey;
+    });
 }
 
-bool Reservation::isValidReservation(const std::string& vehiclePlate) {
-    int position = 0;
-    while (true) {
-        auto record = readRecord<ReservationEntity>(position);
-        if (!record.has_value()) break;
-        
-        if (strcmp(record->vehiclePlate, vehiclePlate.c_str()) == 0) {
-            return true;
-        }
-        position++;
+bool Reservation::isValidReservation(std::string_view vehiclePlate) {
+    {
+        std::lock_guard<std::mutex> guard(filterLock);
+        if (!plateFilter.empty() && !plateFilter.mightContain(vehiclePlate)) return false;
     }
-    return false;
+    IdDictionary::Key plateKey = IdDictionary::find(vehiclePlate);
+    if (plateKey == IdDictionary::NO_KEY) return false;
+    return reservations.exists(plateKey);
 }
 
 void Reservation::checkIn(const std::string& vehiclePlate) {
-    int position = 0;
-    while (true) {
-        auto record = readRecord<ReservationEntity>(position);
-        if (!record.has_value()) break;
-        
-        if (strcmp(record->vehiclePlate, vehiclePlate.c_str()) == 0) {
-            // Update and save
-            ReservationEntity updated = *record;
-            updated.checkedIn = true;
-            Utility::updateRecord<ReservationEntity>(position, updated);
-            return;
+    IdDictionary::Key plateKey = IdDictionary::find(vehiclePlate);
+    if (plateKey == IdDictionary::NO_KEY) return;
+    auto record = reservations.find(plateKey);
+    if (!record) return;
+    // Update and save
+    record->checkedIn = true;
+    reservations.update(*record);
+}
+
+std::vector<std::string> Reservation::checkInBatch(const std::vector<std::string>& vehiclePlates) {
+    // One index lookup per plate. A plate with no key has never been
+    // reserved.
+    std::unordered_set<IdDictionary::Key> found;
+    std::vector<ReservationEntity> updates;
+    for (const auto& plate : vehiclePlates) {
+        IdDictionary::Key key = IdDictionary::find(plate);
+        if (key == IdDictionary::NO_KEY || found.count(key)) continue;
+        auto record = reservations.find(key);
+        if (!record) continue;
+        found.insert(key);
+        if (!record->checkedIn) {
+            record->checkedIn = true;
+            updates.push_back(*record);
         }
-        position++;
     }
-}
 
-// New function implementation to retrieve a reservation by vehicle plate
-std::optional<ReservationEntity> Reservation::getReservation(const std::string& vehiclePlate) {
-    int position = 0;
-    while (true) {
-        auto record = readRecord<ReservationEntity>(position);
-        if (!record.has_value()) break;
-        
-        if (strcmp(record->vehiclePlate, vehiclePlate.c_str()) == 0) {
-            return record;
+    reservations.updateAll(updates);
+
+    std::vector<std::string> missing;
+    std::unordered_set<std::string_view> reported;
+    for (const auto& plate : vehiclePlates) {
+        if (!found.count(IdDictionary::find(plate)) && reported.insert(plate).second) {
+            missing.push_back(plate); // Each missing plate once
         }
-        position++;
     }
-    return {};
+    return missing;
+}
+
+void Reservation::assignLanes(const std::string& sailingID, const std::vector<LaneAssignment>& assignments) {
+    IdDictionary::Key sailingKey = IdDictionary::find(sailingID);
+    if (sailingKey == IdDictionary::NO_KEY) return;
+    std::vector<ReservationEntity> updates;
+    for (const auto& assignment : assignments) {
+        IdDictionary::Key plateKey = IdDictionary::find(assignment.vehiclePlate);
+        if (plateKey == IdDictionary::NO_KEY) continue;
+        auto record = reservations.find(plateKey);
+        if (!record || record->sailingKey != sailingKey) continue;
+        record->deck = assignment.deck;
+        record->lane = assignment.lane;
+        updates.push_back(*record);
+    }
+
+    reservations.updateAll(updates);
+}
+
+void Reservation::buildPlateFilter() {
+    BloomFilter filter(static_cast<uint64_t>(Utility::recordCount<ReservationEntity>()));
+    Utility::scanRecords<ReservationEntity>([&](int, const ReservationEntity& record) {
+        filter.add(IdDictionary::name(record.plateKey));
+        return true;
+    });
+    installPlateFilter(std::move(filter));
+}
+
+void Reservation::buildPlateFilter(ThreadPool& pool) {
+    const uint64_t expected = static_cast<uint64_t>(Utility::recordCount<ReservationEntity>());
+    auto partials = Utility::mapRecordChunks<ReservationEntity>(pool,
+        [expected](long long, std::vector<ReservationEntity>& records) {
+            BloomFilter partial(expected);
+            for (const auto& record : records) partial.add(IdDictionary::name(record.plateKey));
+            return partial;
+        });
+    BloomFilter filter(expected);
+    for (const auto& partial : partials) filter.merge(partial);
+    installPlateFilter(std::move(filter));
+}
+
+void Reservation::installPlateFilter(BloomFilter filter) {
+    std::lock_guard<std::mutex> guard(filterLock);
+    plateFilter = std::move(filter);
+}
+
+BloomFilter Reservation::copyPlateFilter() {
+    std::lock_guard<std::mutex> guard(filterLock);
+    return plateFilter;
+}
+
+// New function implementation to retrieve a reservation by vehicle plate
+std::optional<ReservationEntity> Reservation::getReservation(std::string_view vehiclePlate) {
+    IdDictionary::Key plateKey = IdDictionary::find(vehiclePlate);
+    if (plateKey == IdDictionary::NO_KEY) return {};
+    return reservations.find(plateKey);
 }
\ No newline at end of file
@@ -12,54 +12,127 @@
 //     - Refactored to use Utility functions for CRUD operations
 //   Rev. 1.2 - 2025/07/23
 //     - Added getReservation function
+//   Rev. 1.3 - 2025/08/11
+//     - Added checkInBatch function
+//   Rev. 1.4 - 2025/08/12
+//     - Reservations record the deck and lane they were placed in
+//   Rev. 1.5 - 2025/08/15
+//     - Bloom filter over reserved plates for fast negative lookups;
+//       cancelReservation returns the removed record
+//   Rev. 1.6 - 2025/08/16
+//     - buildPlateFilter overload indexing chunks on a thread pool
+//   Rev. 1.7 - 2025/08/17
+//     - Records store IdDictionary keys instead of ID strings (11 bytes)
+//   Rev. 1.8 - 2025/08/18
+//     - Naturally aligned schema 2 layout (12 bytes)
+//   Rev. 1.9 - 2025/08/19
+//     - ReservationKey policy for Repository; batch check-in and lane
+//       assignment look each plate up in the index; lookups take a
+//       string_view
+//   Rev. 1.10 - 2025/08/25
+//     - UNPLACED_LANE for reservations converted from schema 1
 // *)
 //******************************************************************
 #ifndef RESERVATION_H
 #define RESERVATION_H
 
 #include <string>
+#include <string_view>
 #include <optional>
+#include <vector>
 #include <cstring> // For strcmp
 #include "Utility.h"
+#include "Repository.h"
+#include "IdDictionary.h"
+#include "BloomFilter.h"
+#include "ThreadPool.h"
 
 namespace Reservation {
+    // `lane` of a reservation converted from schema 1, which recorded no
+    // lane; LaneAllocator::load() places it. Never a real lane index.
+    const unsigned char UNPLACED_LANE = 0xFF;
+
     // Entity structure for persistent storage
-    #pragma pack(push, 1)
+    // Schema 2 layout: naturally aligned, explicit padding.
     struct ReservationEntity {
-        char sailingID[21];        // Fixed-length 20 chars + null
-        char vehiclePlate[21];     // Fixed-length 20 chars + null
+        IdDictionary::Key sailingKey;  // Key of the sailing ID
+        IdDictionary::Key plateKey;    // Key of the vehicle plate
         bool checkedIn;            // 1 byte
+        unsigned char deck;        // 0 = low ceiling, 1 = high ceiling
+        unsigned char lane;        // Lane index within the deck
+        char reserved[1];
         
         // Equality operator for CRUD operations
         bool operator==(const ReservationEntity& other) const {
-            return strcmp(sailingID, other.sailingID) == 0 &&
-                   strcmp(vehiclePlate, other.vehiclePlate) == 0;
+            return sailingKey == other.sailingKey && plateKey == other.plateKey;
         }
     };
-    #pragma pack(pop)
+    static_assert(sizeof(ReservationEntity) == 12, "ReservationEntity is an on-disk layout");
+
+    // A vehicle holds at most one reservation, so reservations are
+    // identified by plate.
+    using ReservationKey = IntegerKey<&ReservationEntity::plateKey>;
 
     //----------- CRUD Interface -----------
+    // Throws std::runtime_error if Reservations.dat has not been migrated
+    // to schema 2 (see migrateData).
     void init();
     //-----------
     void shutdown();
     //-----------
     // Corresponds to OCD "createReservation()".
-    void createReservation(const std::string& sailingID, const std::string& vehiclePlate);
+    void createReservation(const std::string& sailingID, const std::string& vehiclePlate,
+                           unsigned char deck = 0, unsigned char lane = 0);
     //-----------
     // Corresponds to OCD "cancelReservation()".
-    void cancelReservation(const std::string& sailingID, const std::string& vehiclePlate);
+    // Returns the record that was removed, if there was one.
+    std::optional<ReservationEntity> cancelReservation(const std::string& sailingID, const std::string& vehiclePlate);
     //-----------
     // Corresponds to OCD "deleteReservations()".
     void deleteReservations(const std::string& sailingID);
     //-----------  
     // Corresponds to OCD "isValidReservation()".
-    bool isValidReservation(const std::string& vehiclePlate);
+    bool isValidReservation(std::string_view vehiclePlate);
     //-----------
     // Corresponds to OCD "checkIn()".
     void checkIn(const std::string& vehiclePlate);
     //-----------
+    // Checks in every plate in `vehiclePlates` with one index lookup per
+    // plate and one coalesced write pass.
+    // Returns the plates that have no reservation, in input order.
+    std::vector<std::string> checkInBatch(const std::vector<std::string>& vehiclePlates);
+    //-----------
+    // New deck/lane for one vehicle after its sailing was repacked.
+    struct LaneAssignment {
+        std::string vehiclePlate;
+        unsigned char deck;
+        unsigned char lane;
+    };
+    // Rewrites the deck/lane of the listed reservations on `sailingID`
+    // with one coalesced write pass.
+    void assignLanes(const std::string& sailingID, const std::vector<LaneAssignment>& assignments);
+    //-----------
+    // --- Plate filter ---
+    // Until a filter is installed every lookup scans the file. Once one
+    // is, isValidReservation() answers "no" for most unreserved plates
+    // without any I/O. Every createReservation() adds its plate (and logs
+    // it to the checkpoint delta log); cancelled plates stay in the filter
+    // until it is rebuilt.
+    //-----------
+    // Builds the filter from one pass over Reservations.dat and installs it.
+    void buildPlateFilter();
+    //-----------
+    // Same, with each chunk of the file indexed concurrently on `pool` and
+    // the partial filters merged. Call from a thread that is not one of
+    // its workers.
+    void buildPlateFilter(ThreadPool& pool);
+    //-----------
+    void installPlateFilter(BloomFilter filter);
+    //-----------
+    BloomFilter copyPlateFilter();
+    //-----------
     // New function to retrieve a reservation by vehicle plate
-    std::optional<ReservationEntity> getReservation(const std::string& vehiclePlate);
+    std::optional<ReservationEntity> getReservation(std::string_view vehiclePlate);
 }
 
 #endif // RESERVATION_H
\ No newline at end of file
@@ -5,7 +5,19 @@
 // PURPOSE:          Implements sailing data operations by calling the
 //                   generic CRUD functions in the Utility module.
 //
+//                   Sailings.dat is mirrored in a copy-on-write
+//                   SnapshotTable. Every write goes to the file and then
+//                   to the mirror while holding the module's write lock;
+//                   every read (lookups and reports) is served from a
+//                   published snapshot, so a report never observes a
+//                   half-finished deleteRecord relocation and never holds
+//                   up a booking.
+//
 // (* Revision History:
+//   Rev. 1.5 - 2025/08/25 - reload().
+//   Rev. 1.4 - 2025/08/19 - Lookups take a string_view.
+//   Rev. 1.3 - 2025/08/10 - Snapshot-isolated reads via SnapshotTable.
+//   Rev. 1.2 - 2025/08/08 - Keep CapacityIndex in sync on every change.
 //   Rev. 1.1 - 2025/07/23 - Corrected calls to Utility functions to use position.
 //   Rev. 1.0 - 2025/07/07 - Initial implementation.
 // *)
@@ -13,41 +25,72 @@
 #include "Sailing.h"
 #include "Utility.h"
 #include "Vessel.h"
+#include "CapacityIndex.h"
+#include <atomic>
 #include <iostream>
 #include <cstring>
+#include <mutex>
 #include <vector>
 #include <optional>
 
 namespace Sailing {
 
+    namespace {
+        SnapshotTable<SailingEntity> table;
+        std::atomic<bool> tableLoaded{ false };
+        // Serializes writers so the file and the mirror change together.
+        std::mutex writeLock;
+
+        void loadTable() {
+            table.load(Utility::readAllRecords<SailingEntity>());
+            tableLoaded = true;
+        }
+
+        SailingSnapshot current() {
+            if (!tableLoaded) {
+                std::lock_guard<std::mutex> guard(writeLock);
+                if (!tableLoaded) loadTable();
+            }
+            return table.snapshot();
+        }
+
+        // Internal helper function to find a record's position.
+        int findRecordPosition(const SailingSnapshot& view, std::string_view sailingID) {
+            for (size_t position = 0; position < view->size(); position++) {
+                if (sailingID == view->at(position).sailingID) {
+                    return static_cast<int>(position);
+                }
+            }
+            return -1;
+        }
+    }
+
     void init() {
+        reload();
         std::cout << "MODEL/Sailing: Initialized." << std::endl;
     }
 
-    void shutdown() {
-        std::cout << "MODEL/Sailing: Shut down." << std::endl;
+    void reload() {
+        {
+            std::lock_guard<std::mutex> guard(writeLock);
+            loadTable();
+        }
+        CapacityIndex::load();
     }
 
-    // Internal helper function to find a record's position.
-    namespace {
-        int findRecordPosition(const std::string& sailingID) {
-            int position = 0;
-            while (true) {
-                auto record = Utility::readRecord<SailingEntity>(position);
-                if (!record.has_value()) return -1;
-                if (strcmp(record->sailingID, sailingID.c_str()) == 0) return position;
-                position++;
-            }
-        }
+    void shutdown() {
+        std::cout << "MODEL/Sailing: Shut down." << std::endl;
     }
 
-    std::optional<SailingEntity> getSailing(const std::string& sailingID) {
-        int position = findRecordPosition(sailingID);
-        return (position != -1) ? Utility::readRecord<SailingEntity>(position) : std::nullopt;
+    std::optional<SailingEntity> getSailing(std::string_view sailingID) {
+        SailingSnapshot view = current();
+        int position = findRecordPosition(view, sailingID);
+        if (position == -1) return std::nullopt;
+        return view->at(static_cast<size_t>(position));
     }
 
-    bool isValidSailing(const std::string& sailingID) {
-        return findRecordPosition(sailingID) != -1;
+    bool isValidSailing(std::string_view sailingID) {
+        return findRecordPosition(current(), sailingID) != -1;
     }
 
     void createSailing(const std::string& vesselID, const std::string& sailingID) {
@@ -65,14 +108,22 @@ namespace Sailing {
         newSailing.LRL = vesselOpt->LCLL;
         newSailing.HRL = vesselOpt->HCLL;
 
+        current();
+        std::lock_guard<std::mutex> guard(writeLock);
         Utility::createRecord(newSailing);
+        table.append(newSailing);
+        CapacityIndex::onSailingCreated(newSailing);
     }
 
     void deleteSailing(const std::string& sailingID) {
-        int position = findRecordPosition(sailingID);
+        current();
+        std::lock_guard<std::mutex> guard(writeLock);
+        int position = findRecordPosition(table.snapshot(), sailingID);
         if (position != -1) {
             // THE FIX IS HERE: Call deleteRecord with the integer position.
             Utility::deleteRecord<SailingEntity>(position);
+            table.removeSwapLast(static_cast<size_t>(position));
+            CapacityIndex::onSailingDeleted(sailingID);
         } else {
             std::cerr << "ERROR: Attempted to delete non-existent sailing '" << sailingID << "'" << std::endl;
         }
@@ -81,15 +132,18 @@ namespace Sailing {
     // Internal helper for updating capacity.
     namespace {
         void updateCapacity(const std::string& sailingID, double lrlChange, double hrlChange) {
-            int position = findRecordPosition(sailingID);
+            current();
+            std::lock_guard<std::mutex> guard(writeLock);
+            SailingSnapshot view = table.snapshot();
+            int position = findRecordPosition(view, sailingID);
             if (position != -1) {
-                if (auto recordOpt = getSailing(sailingID)) {
-                    SailingEntity updatedRecord = *recordOpt;
-                    updatedRecord.LRL += lrlChange;
-                    updatedRecord.HRL += hrlChange;
-                    // THE FIX IS HERE: Call updateRecord with position and object.
-                    Utility::updateRecord(position, updatedRecord);
-                }
+                SailingEntity updatedRecord = view->at(static_cast<size_t>(position));
+                updatedRecord.LRL += lrlChange;
+                updatedRecord.HRL += hrlChange;
+                // THE FIX IS HERE: Call updateRecord with position and object.
+                Utility::updateRecord(position, updatedRecord);
+                table.set(static_cast<size_t>(position), updatedRecord);
+                CapacityIndex::onSailingUpdated(updatedRecord);
             }
         }
     }
@@ -110,15 +164,19 @@ namespace Sailing {
         updateCapacity(sailingID, 0.0, length);
     }
 
-    std::vector<SailingEntity> getSailings(int offset) {
+    SailingSnapshot openSnapshot() {
+        return current();
+    }
+
+    std::vector<SailingEntity> getSailings(const SailingSnapshot& snapshot, int offset) {
         std::vector<SailingEntity> allSailings;
-        int position = offset;
-        while (true) {
-            auto record = Utility::readRecord<SailingEntity>(position);
-            if (!record.has_value()) break;
-            allSailings.push_back(*record);
-            position++;
+        for (size_t position = offset > 0 ? static_cast<size_t>(offset) : 0; position < snapshot->size(); position++) {
+            allSailings.push_back(snapshot->at(position));
         }
         return allSailings;
     }
+
+    std::vector<SailingEntity> getSailings(int offset) {
+        return getSailings(current(), offset);
+    }
 }
\ No newline at end of file
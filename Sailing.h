@@ -6,6 +6,10 @@
 //                   structure and declares functions for data operations.
 //
 // (* Revision History:
+//   Rev. 1.6 - 2025/08/25 - Added reload().
+//   Rev. 1.5 - 2025/08/19 - Lookups take a string_view.
+//   Rev. 1.4 - 2025/08/18 - Naturally aligned schema 2 layout (64 bytes).
+//   Rev. 1.3 - 2025/08/10 - Snapshot-isolated report reads.
 //   Rev. 1.2 - 2025/07/23 - Final version for A4.
 // *)
 //******************************************************************
@@ -13,32 +17,43 @@
 #define SAILING_H
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <optional>
 #include <cstring>
+#include "SnapshotTable.h"
 
 namespace Sailing {
 
-    #pragma pack(push, 1)
+    // Schema 2 layout: the capacities first so they are 8-byte aligned,
+    // padded to exactly 64 bytes so no record straddles a cache line.
     struct SailingEntity {
-        char sailingID[21];
-        char vesselID[21];
         double LRL;
         double HRL;
+        char sailingID[21];
+        char vesselID[21];
+        char reserved[6];
         
         bool operator==(const SailingEntity& other) const {
             return strcmp(sailingID, other.sailingID) == 0;
         }
     };
-    #pragma pack(pop)
+    static_assert(sizeof(SailingEntity) == 64, "SailingEntity is an on-disk layout");
+
+    // A consistent, point-in-time view of every sailing. Holding one does
+    // not block writers; it simply keeps that version alive.
+    using SailingSnapshot = SnapshotTable<SailingEntity>::View;
 
     void init();
+    void reload();  // As init(), quietly: the file was changed by another process
     void shutdown();
-    bool isValidSailing(const std::string& sailingID);
+    bool isValidSailing(std::string_view sailingID);
     void createSailing(const std::string& vesselID, const std::string& sailingID);
     void deleteSailing(const std::string& sailingID);
-    std::optional<SailingEntity> getSailing(const std::string& sailingID);
+    std::optional<SailingEntity> getSailing(std::string_view sailingID);
     std::vector<SailingEntity> getSailings(int offset);
+    SailingSnapshot openSnapshot();
+    std::vector<SailingEntity> getSailings(const SailingSnapshot& snapshot, int offset);
     void decreaseLRL(const std::string& sailingID, double length);
     void increaseLRL(const std::string& sailingID, double length);
     void decreaseHRL(const std::string& sailingID, double length);
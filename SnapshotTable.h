@@ -0,0 +1,146 @@
+// SnapshotTable.h
+//******************************************************************
+// DEFINITION MODULE: SnapshotTable
+//
+// PURPOSE:          An in-memory, copy-on-write mirror of one entity file.
+//                   Records are held in fixed-size pages; every published
+//                   version is an immutable list of page pointers. A write
+//                   copies only the page it touches (plus the page list)
+//                   and then publishes the new version, so a reader that
+//                   took a snapshot keeps seeing exactly the records of
+//                   that point in time for as long as it holds it, while
+//                   writers carry on without waiting for it.
+//
+//                   Position semantics mirror Utility exactly, including
+//                   deleteRecord's "move the last record into the hole"
+//                   relocation, so position N in a version is position N
+//                   in the file at the moment that version was published.
+//
+//                   Writers must be serialized by the owner (the owning
+//                   data module holds its own write lock around the file
+//                   operation and the matching table update).
+//
+// (* Revision History:
+//   Rev. 1.0 - 2025/08/10 - Initial version
+// *)
+//******************************************************************
+#ifndef SNAPSHOT_TABLE_H
+#define SNAPSHOT_TABLE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+template <typename T, size_t PAGE_RECORDS = 256>
+class SnapshotTable {
+public:
+    using Page = std::array<T, PAGE_RECORDS>;
+
+    // One immutable point-in-time view of the table.
+    class Version {
+    public:
+        size_t size() const { return count; }
+        uint64_t number() const { return versionNumber; }
+        const T& at(size_t position) const {
+            return (*pages[position / PAGE_RECORDS])[position % PAGE_RECORDS];
+        }
+
+    private:
+        friend class SnapshotTable;
+        std::vector<std::shared_ptr<const Page>> pages;
+        size_t count = 0;
+        uint64_t versionNumber = 0;
+    };
+
+    using View = std::shared_ptr<const Version>;
+
+    SnapshotTable() : current(std::make_shared<Version>()) {}
+
+    // Returns the latest published version. Never blocks on writers for
+    // longer than a pointer copy.
+    View snapshot() const {
+        std::lock_guard<std::mutex> guard(publishLock);
+        return current;
+    }
+
+    // Replaces the whole table (used when loading from disk).
+    void load(const std::vector<T>& records) {
+        auto next = std::make_shared<Version>();
+        next->versionNumber = snapshot()->versionNumber + 1;
+        for (size_t i = 0; i < records.size(); i += PAGE_RECORDS) {
+            auto page = std::make_shared<Page>();
+            for (size_t j = 0; j < PAGE_RECORDS && i + j < records.size(); j++) {
+                (*page)[j] = records[i + j];
+            }
+            next->pages.push_back(page);
+        }
+        next->count = records.size();
+        publish(next);
+    }
+
+    // Mirrors Utility::createRecord.
+    void append(const T& record) {
+        auto next = beginWrite();
+        if (next->count % PAGE_RECORDS == 0) {
+            auto page = std::make_shared<Page>();
+            (*page)[0] = record;
+            next->pages.push_back(page);
+        } else {
+            writablePage(*next, next->count)[next->count % PAGE_RECORDS] = record;
+        }
+        next->count++;
+        publish(next);
+    }
+
+    // Mirrors Utility::updateRecord.
+    void set(size_t position, const T& record) {
+        auto next = beginWrite();
+        if (position >= next->count) return;
+        writablePage(*next, position)[position % PAGE_RECORDS] = record;
+        publish(next);
+    }
+
+    // Mirrors Utility::deleteRecord: the last record moves into `position`.
+    void removeSwapLast(size_t position) {
+        auto next = beginWrite();
+        if (position >= next->count) return;
+        size_t last = next->count - 1;
+        if (position < last) {
+            T moved = next->at(last);
+            writablePage(*next, position)[position % PAGE_RECORDS] = moved;
+        }
+        next->count--;
+        if (next->count % PAGE_RECORDS == 0) next->pages.pop_back();
+        publish(next);
+    }
+
+private:
+    // Starts a new version sharing every page with the current one.
+    std::shared_ptr<Version> beginWrite() {
+        View latest = snapshot();
+        auto next = std::make_shared<Version>(*latest);
+        next->versionNumber = latest->versionNumber + 1;
+        return next;
+    }
+
+    // Gives `version` a private copy of the page holding `position`.
+    static Page& writablePage(Version& version, size_t position) {
+        auto& slot = version.pages[position / PAGE_RECORDS];
+        auto copy = std::make_shared<Page>(*slot);
+        slot = copy;
+        return *copy;
+    }
+
+    void publish(const std::shared_ptr<Version>& next) {
+        std::lock_guard<std::mutex> guard(publishLock);
+        current = next;
+    }
+
+    mutable std::mutex publishLock;
+    View current;
+};
+
+#endif // SNAPSHOT_TABLE_H
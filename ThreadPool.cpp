@@ -0,0 +1,47 @@
+// ThreadPool.cpp
+//*******************************
+// ThreadPool.cpp
+//
+// A single queue under one mutex; start-up submits a few dozen coarse
+// tasks at most, so contention on it is negligible.
+//
+// Rev 1.0 - 2025-08-16 - Initial version
+//*******************************
+
+#include "ThreadPool.h"
+#include <algorithm>
+
+size_t ThreadPool::defaultThreads() {
+    return std::max<size_t>(1, std::thread::hardware_concurrency());
+}
+
+ThreadPool::ThreadPool(size_t threads) {
+    threads = std::max<size_t>(1, threads);
+    workers.reserve(threads);
+    for (size_t i = 0; i < threads; i++) {
+        workers.emplace_back([this]() { run(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> guard(queueLock);
+        stopping = true;
+    }
+    ready.notify_all();
+    for (std::thread& worker : workers) worker.join();
+}
+
+void ThreadPool::run() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> guard(queueLock);
+            ready.wait(guard, [this]() { return stopping || !queue.empty(); });
+            if (queue.empty()) return;
+            task = std::move(queue.front());
+            queue.pop_front();
+        }
+        task();
+    }
+}
@@ -0,0 +1,70 @@
+// ThreadPool.h
+//******************************************************************
+// DEFINITION MODULE: ThreadPool
+//
+// PURPOSE:          Fixed set of worker threads running queued tasks in
+//                   submission order. Used at start-up to load and index
+//                   the data files concurrently. Every task's result (or
+//                   exception) comes back through the std::future that
+//                   submit() returns.
+//
+//                   Tasks may submit further tasks, but must not wait on
+//                   them from inside the pool: with every worker blocked
+//                   the queued work would never run.
+//
+// (* Revision History:
+//   Rev. 1.0 - 2025/08/16 - Initial version
+// *)
+//******************************************************************
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+class ThreadPool {
+public:
+    // One worker per hardware thread (at least one).
+    static size_t defaultThreads();
+
+    explicit ThreadPool(size_t threads = defaultThreads());
+    // Runs every task still queued, then joins the workers.
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    template <typename Task>
+    std::future<std::invoke_result_t<Task>> submit(Task&& task) {
+        using Result = std::invoke_result_t<Task>;
+        auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<Task>(task));
+        std::future<Result> result = packaged->get_future();
+        {
+            std::lock_guard<std::mutex> guard(queueLock);
+            queue.emplace_back([packaged]() { (*packaged)(); });
+        }
+        ready.notify_one();
+        return result;
+    }
+
+    size_t size() const { return workers.size(); }
+
+private:
+    void run();
+
+    std::mutex queueLock;
+    std::condition_variable ready;
+    std::deque<std::function<void()>> queue;
+    bool stopping = false;
+    std::vector<std::thread> workers;
+};
+
+#endif // THREAD_POOL_H
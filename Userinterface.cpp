@@ -7,6 +7,15 @@
 //          operations to Controller. Each input step loops locally
 //          so retry stays at that step.
 // 
+// Rev 1.11 - 2025/08/25 Capacity shown before booking comes through the Controller
+// Rev 1.10 - 2025/08/19 Check-in confirmation looks the vehicle up once
+// Rev 1.9 - 2025/08/16 Start-up is done once, by initializeSystem()
+// Rev 1.8 - 2025/08/14 Added earliest fitting sailing inquiry
+// Rev 1.7 - 2025/08/13 Offer the waitlist when a sailing is full
+// Rev 1.6 - 2025/08/12 Report when no single lane can take the vehicle
+// Rev 1.5 - 2025/08/10 Sailing report pages all come from one snapshot
+// Rev 1.4 - 2025/08/08 Added top sailings by remaining capacity inquiry
+// Rev 1.3 - 2025/08/07 Report active session to Metrics
 // Rev 1.2 - 2025/07/24 Revised function calls for printing
 // Rev 1.1 - 2025/07/23 Revised looping logic and UI text now includes expected format
 // Rev 1.0 - 2025/07/22 Initial
@@ -14,6 +23,7 @@
 
 #include "UserInterface.h"
 #include "Controller.h"
+#include "Metrics.h"
 #include <iostream>
 #include <limits>
 #include <string>
@@ -37,6 +47,20 @@ namespace UserInterface {
         }
     }
 
+    // Offers to queue a vehicle that did not fit; it is booked
+    // automatically when a cancellation frees enough space.
+    void offerWaitlist(const string& sailingID, const string& licensePlate) {
+        string answer;
+        cout << "\nAdd vehicle " << licensePlate << " to the waitlist for sailing " << sailingID << "? (Y/N): ";
+        cin >> answer;
+        if (answer != "y" && answer != "Y") return;
+        if (Controller::joinWaitlist(sailingID, licensePlate)) {
+            cout << "\nVehicle added to the waitlist. It will be booked automatically when space frees up.\n";
+        } else {
+            cout << "\nVehicle is already on a waitlist.\n";
+        }
+    }
+
     // Vessel Management
     static void handleVesselManagement() {
         while (true) {
@@ -398,8 +422,9 @@ namespace UserInterface {
                     }
                     Controller::createNewVehicle(licensePlate, phoneNumber, length, height);     
                 }
-                double lrl = Sailing::getSailing(sailingID).value().LRL;
-                double hrl = Sailing::getSailing(sailingID).value().HRL;
+                auto sailing = Controller::getSailing(sailingID).value();
+                double lrl = sailing.LRL;
+                double hrl = sailing.HRL;
                 cout << "\nRemaining capacity for sailing " << sailingID << ":"
                      << "\nHRL: " << hrl << " m"
                      << "\nLRL: " << lrl << " m\n";
@@ -425,7 +450,12 @@ namespace UserInterface {
                                 validInput = true;
                             } else {
                                 if (userInput == "y" || userInput == "Y") {
-                                    Controller::createNewReservation(sailingID, licensePlate);
+                                    if (!Controller::createNewReservation(sailingID, licensePlate)) {
+                                        cout << "\nError: No single lane has room left for this vehicle.\n";
+                                        offerWaitlist(sailingID, licensePlate);
+                                        cout << "\nReturning to main menu...\n";
+                                        return;
+                                    }
                                     double temp = length + 0.5;
                                     cout << "\nReservation confirmed."
                                         << "\n  Total reserved space: " << temp << " m"
@@ -441,8 +471,9 @@ namespace UserInterface {
                             }
                         }
                     } else {
-                        cout << "\nError: Not enough space remaining to reserve a spot for this vehicle.";
-                        cout << "\nReservation cannot be completed. Restarting reservation process...\n";
+                        cout << "\nError: Not enough space remaining to reserve a spot for this vehicle.\n";
+                        offerWaitlist(sailingID, licensePlate);
+                        cout << "\nRestarting reservation process...\n";
                     }
                 } else {
                     cout << "\nError: Vehicle already has a reservation.";
@@ -502,10 +533,13 @@ namespace UserInterface {
                     } else {
                         if (userInput == "y" || userInput == "Y") {
                             //Controller::deleteSailing(sailingID);
-                            Controller::cancelReservation(sailingID, licensePlate);
+                            auto promoted = Controller::cancelReservation(sailingID, licensePlate);
                             cout << "\nReservation for vehicle " << licensePlate <<" has been cancelled."
-                                 << "\nRemaining capacity updated.\n" 
-                                 << "\nReturning to main menu...\n";
+                                 << "\nRemaining capacity updated.\n";
+                            for (const auto& plate : promoted) {
+                                cout << "Waitlisted vehicle " << plate << " has been booked.\n";
+                            }
+                            cout << "\nReturning to main menu...\n";
                             validInput = true;
                             return;
                         } else {
@@ -540,8 +574,9 @@ namespace UserInterface {
                 }
                 userInput = "";
                 validInput = false;
-                double length = Controller::getVehicle(licensePlate).value().length;
-                double height = Controller::getVehicle(licensePlate).value().height;
+                Vehicle::VehicleEntity vehicle = Controller::getVehicle(licensePlate).value();
+                double length = vehicle.length;
+                double height = vehicle.height;
                 cout << "\nVehicle: " << licensePlate 
                      << "\nLength: " << length << " m"
                      << "\nHeight: " << height << " m\n"
@@ -575,6 +610,8 @@ namespace UserInterface {
             cout<<"\n============== Reports & Inquiries==============\n"
                 <<"1) Print Sailing Report\n"
                 <<"2) Query Individual Sailing\n"
+                <<"3) Sailings With Most Remaining Capacity\n"
+                <<"4) Earliest Sailing That Fits a Vehicle\n"
                 <<"0) Return to Main Menu\n"
                 <<"\nEnter selection: ";
             
@@ -589,8 +626,10 @@ namespace UserInterface {
             } 
             if (choice == 1) {
                 int page=0;
+                // Every page is read from the same point-in-time snapshot
+                auto snapshot = Controller::openSailingReport();
                 while (true) {
-                    auto list = Controller::getSailingReport(page);
+                    auto list = Controller::getSailingReport(snapshot, page);
                     if (list.empty()) { 
                         cout<<"No more sailings.\n"; 
                         break; 
@@ -648,10 +687,76 @@ namespace UserInterface {
                     }
                 }
             }
+            if (choice == 3) {
+                cout << "\n============== Sailings With Most Remaining Capacity ==============\n";
+
+                cout << "\nRank by (L)ow ceiling or (H)igh ceiling lane [or 0 to return to main menu]: ";
+                string userInput;
+                CapacityIndex::Lane lane;
+                while (true) {
+                    cin >> userInput;
+                    if (userInput == "0") {
+                        return;
+                    }
+                    if (userInput == "L" || userInput == "l") {
+                        lane = CapacityIndex::Lane::Low;
+                        break;
+                    }
+                    if (userInput == "H" || userInput == "h") {
+                        lane = CapacityIndex::Lane::High;
+                        break;
+                    }
+                    cout << "\nInvalid choice. Please enter L or H [or 0 to return to main menu]: ";
+                }
+
+                cout << "\nEnter vessel ID to restrict to, or * for all vessels [or 0 to return to main menu]: ";
+                cin >> userInput;
+                if (userInput == "0") {
+                    return;
+                }
+                string vesselID = (userInput == "*") ? "" : userInput;
+
+                auto list = Controller::getTopSailingsByCapacity(lane, 10, vesselID);
+                if (list.empty()) {
+                    cout << "No sailings found.\n";
+                }
+                for (auto& e: list) {
+                    cout << e.sailingID << " | " << e.vesselID << " | LRL = " << e.LRL << " | HRL = " << e.HRL << "\n";
+                }
+            }
+            if (choice == 4) {
+                cout << "\n============== Earliest Sailing That Fits a Vehicle ==============\n";
+
+                string route;
+                cout << "\nEnter departure terminal (e.g., YVR) [or 0 to return to main menu]: ";
+                cin >> route;
+                if (route == "0") {
+                    return;
+                }
+                string userInput;
+                double height;
+                double length;
+                cout << "\nEnter vehicle height in meters (0.1 - 9.9): ";
+                while (!(cin >> userInput) || !tryParseDouble(userInput, height) || height < 0.1 || height > 9.9) {
+                    cout << "\nInvalid height. Please enter a value between 0.1 and 9.9: ";
+                }
+                cout << "\nEnter vehicle length in meters (0.1 - 999.9): ";
+                while (!(cin >> userInput) || !tryParseDouble(userInput, length) || length < 0.1 || length > 999.9) {
+                    cout << "\nInvalid length. Please enter a value between 0.1 and 999.9: ";
+                }
+
+                auto sailing = Controller::findEarliestFittingSailing(route, length, height, "");
+                if (!sailing) {
+                    cout << "No sailing from " << route << " has room for this vehicle.\n";
+                } else {
+                    cout << sailing->sailingID << " | " << sailing->vesselID << " | LRL = " << sailing->LRL
+                         << " | HRL = " << sailing->HRL << "\n";
+                }
+            }
         }
     }
     void begin_input() {
-        Controller::init();
+        Metrics::sessionStarted();
         while (true) {
             cout<<"\n============== Main Menu ==============\n"
                 <<"1) Vessel Management\n"
@@ -673,6 +778,7 @@ namespace UserInterface {
             }
             cin.ignore(numeric_limits<streamsize>::max(), '\n');
             if (choice == 0) { 
+                Metrics::sessionEnded();
                 Controller::shutdown(); 
                 return;
             } 
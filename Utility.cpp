@@ -4,6 +4,16 @@
 //
 // Utility module that provides common functions for file handling and data management.
 //
+// Rev 1.11 - 2025-08-25 - Non-blocking locks for the asynchronous primitives.
+// Rev 1.10 - 2025-08-24 - Change sink for ChangeFeed.
+// Rev 1.9 - 2025-08-23 - WriteGeneration header counters.
+// Rev 1.8 - 2025-08-22 - Advisory file locks (lockRecords, FileLock).
+// Rev 1.7 - 2025-08-21 - WriteFile; chunked preallocation of appends.
+// Rev 1.6 - 2025-08-19 - ReadFile positioned reads.
+// Rev 1.5 - 2025-08-18 - syncFile().
+// Rev 1.4 - 2025-08-17 - Ids.dat file name.
+// Rev 1.3 - 2025-08-13 - Waitlist.dat file name.
+// Rev 1.2 - 2025-08-06 - I/O accounting counters.
 // Rev 1.1 - 2025-07-23 - Moved all template code to header.
 // Rev 1.0 - 2025-07-22 - Initial version
 //*******************************
@@ -11,6 +21,18 @@
 #include "Utility.h"
 #include <iostream>
 #include <filesystem> // Required for creating a directory
+#include <ostream>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cerrno>
+#include <mutex>
+#include <unordered_map>
+#include <fcntl.h>
+#include <sys/file.h>   // flock, where OFD locks are unavailable
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace Utility {
 
@@ -31,4 +53,387 @@ namespace Utility {
         std::cout << "UTILITY: System shutdown." << std::endl;
     }
 
+    bool syncFile(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        bool synced = ::fsync(fd) == 0;
+        ::close(fd);
+        return synced;
+    }
+
+    // --- Change capture ---
+    namespace {
+        std::atomic<ChangeSink> changeSink{ nullptr };
+    }
+
+    void setChangeSink(ChangeSink sink) {
+        changeSink = sink;
+    }
+
+    bool capturingChanges() {
+        return changeSink.load(std::memory_order_relaxed) != nullptr;
+    }
+
+    void noteChange(size_t entity, ChangeOp op, long long position, const void* record, size_t bytes) {
+        ChangeSink sink = changeSink;
+        if (sink != nullptr) sink(entity, op, position, record, bytes);
+    }
+
+    // --- ReadFile ---
+    ReadFile::ReadFile(const char* path) : ReadFile(path, O_RDONLY) {}
+
+    ReadFile::ReadFile(const char* path, int flags) : fd(::open(path, flags | O_CLOEXEC, 0644)) {}
+
+    ReadFile::~ReadFile() {
+        if (fd >= 0) ::close(fd);
+    }
+
+    long long ReadFile::size() const {
+        struct stat info;
+        if (fd < 0 || ::fstat(fd, &info) != 0) return 0;
+        return static_cast<long long>(info.st_size);
+    }
+
+    long long ReadFile::read(struct iovec* iov, int count, long long offset, IoCounters& io) {
+        long long total = 0;
+        while (count > 0) {
+            ssize_t got = ::preadv(fd, iov, count, static_cast<off_t>(offset + total));
+            io.seeks++; // One positioned read
+            if (got < 0 && errno == EINTR) continue;
+            if (got <= 0) break;
+            total += got;
+            io.bytesRead += static_cast<uint64_t>(got);
+            // Skip the buffers filled completely and trim a partial one.
+            size_t left = static_cast<size_t>(got);
+            while (count > 0 && left >= iov->iov_len) {
+                left -= iov->iov_len;
+                iov++;
+                count--;
+            }
+            if (count > 0) {
+                iov->iov_base = static_cast<char*>(iov->iov_base) + left;
+                iov->iov_len -= left;
+            }
+        }
+        return total;
+    }
+
+    long long ReadFile::read(void* buffer, size_t bytes, long long offset, IoCounters& io) {
+        struct iovec one = { buffer, bytes };
+        return read(&one, 1, offset, io);
+    }
+
+    // --- WriteFile ---
+    WriteFile::WriteFile(const char* path) : ReadFile(path, O_RDWR | O_CREAT) {}
+
+    bool WriteFile::write(const void* buffer, size_t bytes, long long offset, IoCounters& io) {
+        const char* data = static_cast<const char*>(buffer);
+        size_t total = 0;
+        while (total < bytes) {
+            ssize_t wrote = ::pwrite(fd, data + total, bytes - total, static_cast<off_t>(offset + total));
+            io.seeks++; // One positioned write
+            if (wrote < 0 && errno == EINTR) continue;
+            if (wrote <= 0) return false;
+            total += static_cast<size_t>(wrote);
+            io.bytesWritten += static_cast<uint64_t>(wrote);
+        }
+        return true;
+    }
+
+    bool WriteFile::reserve(long long bytes, IoCounters& io) {
+        long long have = size();
+        if (bytes <= have) return true;
+        int error;
+        do {
+            error = ::posix_fallocate(fd, static_cast<off_t>(have), static_cast<off_t>(bytes - have));
+        } while (error == EINTR);
+        if (error != 0) return false;
+        io.preallocations++;
+        return true;
+    }
+
+    // --- Cross-process locking ---
+    // Lock name n is byte n of the file: 0 is the structure, 1 + p is
+    // record p. Locking past the end of a file is allowed and does not
+    // grow it.
+    bool lockRecords(int fd, LockMode mode, long long first, long long count) {
+        if (fd < 0 || first < -1 || count < 0) return false;
+#ifdef F_OFD_SETLKW
+        struct flock range = {};
+        range.l_type = mode == LockMode::Exclusive ? F_WRLCK : F_RDLCK;
+        range.l_whence = SEEK_SET;
+        range.l_start = static_cast<off_t>(first + 1);
+        range.l_len = static_cast<off_t>(count); // 0: to the end and beyond
+        while (::fcntl(fd, F_OFD_SETLKW, &range) != 0) {
+            if (errno != EINTR) return false;
+        }
+        return true;
+#else
+        // Whole file only. A shared request never downgrades an exclusive
+        // lock already held, because callers lock the weaker range first.
+        while (::flock(fd, mode == LockMode::Exclusive ? LOCK_EX : LOCK_SH) != 0) {
+            if (errno != EINTR) return false;
+        }
+        return true;
+#endif
+    }
+
+    bool tryLockRecords(int fd, LockMode mode, long long first, long long count, bool& busy) {
+        busy = false;
+        if (fd < 0 || first < -1 || count < 0) return false;
+#ifdef F_OFD_SETLKW
+        struct flock range = {};
+        range.l_type = mode == LockMode::Exclusive ? F_WRLCK : F_RDLCK;
+        range.l_whence = SEEK_SET;
+        range.l_start = static_cast<off_t>(first + 1);
+        range.l_len = static_cast<off_t>(count);
+        while (::fcntl(fd, F_OFD_SETLK, &range) != 0) {
+            if (errno == EAGAIN || errno == EACCES) busy = true;
+            if (errno != EINTR) return false;
+        }
+        return true;
+#else
+        while (::flock(fd, (mode == LockMode::Exclusive ? LOCK_EX : LOCK_SH) | LOCK_NB) != 0) {
+            if (errno == EWOULDBLOCK) busy = true;
+            if (errno != EINTR) return false;
+        }
+        return true;
+#endif
+    }
+
+    void unlockFile(int fd) {
+        if (fd < 0) return;
+#ifdef F_OFD_SETLKW
+        struct flock range = {};
+        range.l_type = F_UNLCK;
+        range.l_whence = SEEK_SET;
+        ::fcntl(fd, F_OFD_SETLK, &range);
+#else
+        ::flock(fd, LOCK_UN);
+#endif
+    }
+
+    FileLock::FileLock(const char* path, bool write)
+        : fd(::open(path, (write ? O_RDWR : O_RDONLY) | O_CLOEXEC)) {}
+
+    FileLock::~FileLock() {
+        if (fd >= 0) ::close(fd); // Releases every lock it holds
+    }
+
+    namespace {
+        // Takes locks[next] onwards, waiting `backoff` before trying a
+        // busy one again.
+        void takeLocks(std::shared_ptr<AsyncIo::File> file, std::shared_ptr<std::vector<RecordLock>> locks,
+                       size_t next, long long backoff, std::function<void(bool)> done) {
+            for (; next < locks->size(); next++) {
+                const RecordLock& lock = (*locks)[next];
+                bool busy = false;
+                if (tryLockRecords(file->fd(), lock.mode, lock.first, lock.count, busy)) continue;
+                if (!busy) {
+                    unlockFile(file->fd());
+                    done(false);
+                    return;
+                }
+                AsyncIo::delay(backoff, [file, locks, next, backoff, done = std::move(done)](long long) mutable {
+                    takeLocks(file, locks, next, std::min(backoff * 2, LOCK_RETRY_MAX_MICROS), std::move(done));
+                });
+                return;
+            }
+            done(true);
+        }
+    }
+
+    void lockRecordsAsync(std::shared_ptr<AsyncIo::File> file, std::vector<RecordLock> locks,
+                          std::function<void(bool)> done) {
+        if (AsyncIo::backend() == AsyncIo::Backend::None) {
+            // Operations run on the calling thread, which may as well wait.
+            for (const RecordLock& lock : locks) {
+                if (!lockRecords(file->fd(), lock.mode, lock.first, lock.count)) {
+                    unlockFile(file->fd());
+                    done(false);
+                    return;
+                }
+            }
+            done(true);
+            return;
+        }
+        takeLocks(file, std::make_shared<std::vector<RecordLock>>(std::move(locks)), 0, LOCK_RETRY_MIN_MICROS,
+                  std::move(done));
+    }
+
+    // --- Preallocation ---
+    long long reserveAppend(WriteFile& file, FileLayout& layout, size_t bytes, IoCounters& io) {
+        if (layout.current() && layout.allocatedBytes == 0) {
+            // A new file: tracks its end from the start.
+            FileHeader header = {};
+            memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+            header.schemaVersion = SCHEMA_VERSION;
+            header.recordSize = static_cast<uint32_t>(layout.recordSize);
+            header.dataEnd = sizeof(FileHeader);
+            header.flags = HEADER_TRACKS_END;
+            if (!file.write(&header, sizeof(FileHeader), 0, io)) return -1;
+            layout.fileBytes = layout.allocatedBytes = sizeof(FileHeader);
+            layout.tracksEnd = true;
+        }
+        // After the last complete record: a torn one is overwritten.
+        long long end = layout.offsetOf(layout.records());
+        if (!layout.current()) return end; // Schema 1: no header, the file just grows
+
+        // Record the end before adding space past it, so that space is
+        // never taken for records.
+        if (!layout.tracksEnd && !setLogicalEnd(file, layout, end, io)) return -1;
+        long long need = end + static_cast<long long>(bytes);
+        if (need > layout.allocatedBytes) {
+            long long chunk = std::clamp(layout.allocatedBytes / 8, PREALLOCATE_MIN_BYTES, PREALLOCATE_MAX_BYTES);
+            // If the file system refuses, the write itself extends the file.
+            if (file.reserve(std::max(need, end + chunk), io)) layout.allocatedBytes = std::max(need, end + chunk);
+        }
+        return end;
+    }
+
+    bool setLogicalEnd(WriteFile& file, FileLayout& layout, long long end, IoCounters& io) {
+        layout.fileBytes = end;
+        if (!layout.current()) return true;
+        uint64_t dataEnd = static_cast<uint64_t>(end);
+        if (!file.write(&dataEnd, sizeof(dataEnd), offsetof(FileHeader, dataEnd), io)) return false;
+        if (layout.tracksEnd) return true;
+        // Flagged only once dataEnd is right, so a mapped reader never
+        // takes a stale one for the end.
+        uint32_t flags = HEADER_TRACKS_END;
+        if (!file.write(&flags, sizeof(flags), offsetof(FileHeader, flags), io)) return false;
+        layout.tracksEnd = true;
+        return true;
+    }
+
+    // --- Write generations ---
+    namespace {
+        struct HeaderMapping {
+            dev_t device = 0;
+            ino_t inode = 0;
+            std::shared_ptr<FileHeader> header;
+        };
+        // One mapping per data file for the life of the process, replaced
+        // when the file is (a migration renames a new one over it).
+        std::mutex headerMappingsLock;
+        std::unordered_map<std::string_view, HeaderMapping> headerMappings;
+
+        std::shared_ptr<FileHeader> mappedHeader(const char* path, int fd) {
+            struct stat info;
+            if (fd < 0 || ::fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(FileHeader))) {
+                return nullptr;
+            }
+            std::lock_guard<std::mutex> guard(headerMappingsLock);
+            HeaderMapping& mapping = headerMappings[path];
+            if (mapping.header && mapping.device == info.st_dev && mapping.inode == info.st_ino) {
+                return mapping.header;
+            }
+            // Mapped through a descriptor of its own: a mapping holds its
+            // open file description, and with it that description's locks.
+            int own = ::open(path, O_RDWR | O_CLOEXEC);
+            struct stat ownInfo;
+            if (own < 0) return nullptr;
+            void* view = MAP_FAILED;
+            if (::fstat(own, &ownInfo) == 0 && ownInfo.st_dev == info.st_dev && ownInfo.st_ino == info.st_ino) {
+                view = ::mmap(nullptr, sizeof(FileHeader), PROT_READ | PROT_WRITE, MAP_SHARED, own, 0);
+            }
+            ::close(own);
+            if (view == MAP_FAILED) return nullptr;
+            mapping.device = info.st_dev;
+            mapping.inode = info.st_ino;
+            // Writes still using the old mapping keep it alive.
+            mapping.header.reset(static_cast<FileHeader*>(view),
+                                 [](FileHeader* header) { ::munmap(header, sizeof(FileHeader)); });
+            return mapping.header;
+        }
+    }
+
+    WriteGeneration::WriteGeneration(const char* path, int fd, const FileLayout& layout) {
+        if (!layout.current()) return;
+        header = mappedHeader(path, fd);
+        if (header) __atomic_fetch_add(&header->writesBegun, 1, __ATOMIC_SEQ_CST);
+    }
+
+    WriteGeneration::~WriteGeneration() {
+        if (!header) return;
+        if (settles) {
+            __atomic_store_n(&header->writesDone, __atomic_load_n(&header->writesBegun, __ATOMIC_ACQUIRE),
+                             __ATOMIC_RELEASE);
+        } else {
+            __atomic_fetch_add(&header->writesDone, 1, __ATOMIC_RELEASE);
+        }
+    }
+
+    // --- I/O accounting ---
+    namespace {
+        const char* const ENTITY_FILE_NAMES[ENTITY_COUNT] = {
+            "Vessels.dat", "Sailings.dat", "Vehicles.dat", "Reservations.dat", "Waitlist.dat", "Ids.dat"
+        };
+    }
+
+    IoCounters& IoCounters::operator+=(const IoCounters& other) {
+        opens += other.opens;
+        seeks += other.seeks;
+        bytesRead += other.bytesRead;
+        bytesWritten += other.bytesWritten;
+        recordsScanned += other.recordsScanned;
+        truncates += other.truncates;
+        fsyncs += other.fsyncs;
+        preallocations += other.preallocations;
+        return *this;
+    }
+
+    IoCounters IoCounters::operator-(const IoCounters& other) const {
+        IoCounters delta;
+        delta.opens = opens - other.opens;
+        delta.seeks = seeks - other.seeks;
+        delta.bytesRead = bytesRead - other.bytesRead;
+        delta.bytesWritten = bytesWritten - other.bytesWritten;
+        delta.recordsScanned = recordsScanned - other.recordsScanned;
+        delta.truncates = truncates - other.truncates;
+        delta.fsyncs = fsyncs - other.fsyncs;
+        delta.preallocations = preallocations - other.preallocations;
+        return delta;
+    }
+
+    bool IoCounters::empty() const {
+        return opens == 0 && seeks == 0 && bytesRead == 0 && bytesWritten == 0 &&
+               recordsScanned == 0 && truncates == 0 && fsyncs == 0 && preallocations == 0;
+    }
+
+    IoStats& IoStats::operator+=(const IoStats& other) {
+        for (size_t i = 0; i < ENTITY_COUNT; i++) files[i] += other.files[i];
+        return *this;
+    }
+
+    IoStats IoStats::operator-(const IoStats& other) const {
+        IoStats delta;
+        for (size_t i = 0; i < ENTITY_COUNT; i++) delta.files[i] = files[i] - other.files[i];
+        return delta;
+    }
+
+    IoStats& threadIoStats() {
+        thread_local IoStats stats;
+        return stats;
+    }
+
+    const char* entityFileName(size_t index) {
+        return index < ENTITY_COUNT ? ENTITY_FILE_NAMES[index] : "?";
+    }
+
+    void printIoStats(std::ostream& out, const IoStats& stats, const char* indent) {
+        bool any = false;
+        for (size_t i = 0; i < ENTITY_COUNT; i++) {
+            const IoCounters& c = stats.files[i];
+            if (c.empty()) continue;
+            any = true;
+            out << indent << entityFileName(i)
+                << ": opens=" << c.opens << " seeks=" << c.seeks
+                << " scanned=" << c.recordsScanned
+                << " read=" << c.bytesRead << "B written=" << c.bytesWritten << "B"
+                << " truncates=" << c.truncates << " fsyncs=" << c.fsyncs
+                << " preallocations=" << c.preallocations << "\n";
+        }
+        if (!any) out << indent << "(no file I/O)\n";
+    }
+
 } // end namespace Utility
\ No newline at end of file
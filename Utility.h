@@ -7,6 +7,37 @@
 //                   any fixed-size data structure.
 //
 // (* Revision History:
+//   Rev. 1.19 - 2025/08/25 - updateRecords<T>() keeps the last of several
+//                          updates to one position
+//   Rev. 1.18 - 2025/08/25 - Asynchronous primitives take their locks
+//                          without blocking (lockRecordsAsync).
+//   Rev. 1.17 - 2025/08/25 - Added fileSchema<T>() and fileLayout<T>();
+//                          migrateFile<T>() refuses a file of partial records.
+//   Rev. 1.16 - 2025/08/24 - Every write primitive reports its change to
+//                          an installed ChangeSink (see ChangeFeed).
+//   Rev. 1.15 - 2025/08/23 - Write generations in the file header for
+//                          lock-free mapped readers (WriteGeneration).
+//   Rev. 1.14 - 2025/08/22 - Cross-process advisory locks (FileLock) around
+//                          every primitive.
+//   Rev. 1.13 - 2025/08/21 - Appends preallocate file space in chunks and
+//                          the header records the logical end.
+//   Rev. 1.12 - 2025/08/20 - Asynchronous record primitives over AsyncIo
+//                          (readRecordAsync<T>() and friends).
+//   Rev. 1.11 - 2025/08/19 - Batched positional reads: ReadFile and
+//                          readRecords<T>() with preadv.
+//   Rev. 1.10 - 2025/08/19 - FixedText<N> keys; getFilePath<T>() is a
+//                          compile-time constant.
+//   Rev. 1.9 - 2025/08/18 - Schema 2 file header, schema 1 read/write
+//                          compatibility and migrateFile<T>().
+//   Rev. 1.8 - 2025/08/17 - Added IdDictionary entity.
+//   Rev. 1.7 - 2025/08/16 - Added readRecordRange<T>() and chunked parallel
+//                          loading (mapRecordChunks<T>, readAllRecords<T>(pool)).
+//   Rev. 1.6 - 2025/08/13 - Added Waitlist entity.
+//   Rev. 1.5 - 2025/08/11 - Added scanRecords<T>() and coalesced updateRecords<T>().
+//   Rev. 1.4 - 2025/08/10 - Added readAllRecords<T>() bulk load.
+//   Rev. 1.3 - 2025/08/07 - Added recordCount<T>().
+//   Rev. 1.2 - 2025/08/06 - Per-thread I/O accounting (opens, seeks, bytes,
+//                          records scanned, truncates, fsyncs) per data file.
 //   Rev. 1.1 - 2025/07/23 - Moved template definitions to header, removed
 //                          fileHandles map, and simplified file I/O to be
 //                          safer and standards-compliant.
@@ -16,6 +47,9 @@
 #ifndef UTILITY_H
 #define UTILITY_H
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <optional>
@@ -24,103 +58,1246 @@
 #include <iostream>
 #include <stdexcept>
 #include <type_traits> // For std::is_same_v
+#include <algorithm>
+#include <utility>
+#include <cstring>
+#include <future>
+#include <functional>
+#include <string_view>
+#include <memory>
+#include <sys/uio.h>    // struct iovec
+#include <fcntl.h>      // O_* flags for AsyncIo::File::open
+#include "LegacySchema.h"
+#include "ThreadPool.h"
+#include "AsyncIo.h"
 
 // Forward declarations of the data entity structs are required
 namespace Vessel { struct VesselEntity; }
 namespace Sailing { struct SailingEntity; }
 namespace Vehicle { struct VehicleEntity; }
 namespace Reservation { struct ReservationEntity; }
+namespace Waitlist { struct WaitlistEntity; }
+namespace IdDictionary { struct IdEntity; }
 
 namespace Utility {
     
     // Non-template functions can be declared here.
     void init();
     void shutdown();
+    //-----------
+    // fsync()s a file or directory. Returns false if it could not.
+    bool syncFile(const std::string& path);
+
+    // --- I/O accounting ---
+    // Every CRUD primitive below adds to these counters, kept separately
+    // for each data file and for each thread. Callers attribute I/O to an
+    // operation by taking ioStats() before and after and subtracting.
+    const size_t ENTITY_COUNT = 6;
+
+    struct IoCounters {
+        uint64_t opens = 0;
+        uint64_t seeks = 0;
+        uint64_t bytesRead = 0;
+        uint64_t bytesWritten = 0;
+        uint64_t recordsScanned = 0;
+        uint64_t truncates = 0;
+        uint64_t fsyncs = 0;
+        uint64_t preallocations = 0;
+
+        IoCounters& operator+=(const IoCounters& other);
+        IoCounters operator-(const IoCounters& other) const;
+        bool empty() const;
+    };
+
+    struct IoStats {
+        std::array<IoCounters, ENTITY_COUNT> files;
+
+        IoStats& operator+=(const IoStats& other);
+        IoStats operator-(const IoStats& other) const;
+    };
+
+    //-----------
+    // The calling thread's live counters (mutated by the primitives).
+    IoStats& threadIoStats();
+    //-----------
+    // A copy of the calling thread's counters.
+    inline IoStats ioStats() { return threadIoStats(); }
+    //-----------
+    // Short file name for an ENTITY_COUNT index, e.g. "Vehicles.dat".
+    const char* entityFileName(size_t index);
+    //-----------
+    // Prints one line per data file that saw any I/O in `stats`.
+    void printIoStats(std::ostream& out, const IoStats& stats, const char* indent);
+
+    // A data file opened read-only for positioned reads (pread/preadv), so
+    // several records can be fetched without a stream or a seek each.
+    class ReadFile {
+    public:
+        explicit ReadFile(const char* path);
+        ~ReadFile();
+        ReadFile(const ReadFile&) = delete;
+        ReadFile& operator=(const ReadFile&) = delete;
+
+        bool isOpen() const { return fd >= 0; }
+        long long size() const;
+        //-----------
+        // Fills the `count` buffers of `iov` in order from the bytes at
+        // `offset`, retrying short reads. Returns the bytes read, which is
+        // less than requested only at end of file or on an error.
+        long long read(struct iovec* iov, int count, long long offset, IoCounters& io);
+        //-----------
+        long long read(void* buffer, size_t bytes, long long offset, IoCounters& io);
+        //-----------
+        int descriptor() const { return fd; }
+
+    protected:
+        ReadFile(const char* path, int flags);
+        int fd;
+    };
+
+    // A data file opened for positioned reads and writes; created if it
+    // does not exist.
+    class WriteFile : public ReadFile {
+    public:
+        explicit WriteFile(const char* path);
+        //-----------
+        // Writes all `bytes` at `offset`, retrying short writes. Returns
+        // false on an error.
+        bool write(const void* buffer, size_t bytes, long long offset, IoCounters& io);
+        //-----------
+        // Allocates disk space so the file is at least `bytes` long
+        // (posix_fallocate). Returns false if the file system refused.
+        bool reserve(long long bytes, IoCounters& io);
+    };
+
+    // --- Cross-process locking ---
+    // Several processes may share one Data/ directory, so every primitive
+    // below takes advisory locks on the file it touches. A lock names
+    // either the file's structure (its header and where its records end)
+    // or a range of record positions; the names are lock-table offsets,
+    // not the bytes the records occupy, so they mean the same in both
+    // schemas. Readers share; a write excludes others from what it
+    // changes: an update locks its records, an append the structure, a
+    // delete (which moves the last record) the whole file. The structure
+    // is always locked before any records.
+    //
+    // Open file description locks (F_OFD_SETLKW) are used, so threads of
+    // one process exclude each other as well, and closing some other
+    // descriptor of the file releases nothing. Where they are not
+    // available, flock() locks the whole file instead.
+    enum class LockMode { Shared, Exclusive };
+
+    //-----------
+    // Blocks until `fd` holds `mode` on the structure (`first` -1) and the
+    // records [first, first + count), or from `first` on if `count` is 0;
+    // `first` -1 with `count` 0 is the whole file. An exclusive lock needs
+    // `fd` open for writing. The lock lasts until the range is locked
+    // again or the descriptor is closed. Returns false on an error.
+    bool lockRecords(int fd, LockMode mode, long long first, long long count);
+    //-----------
+    // As lockRecords(), but never waits: returns false with `busy` set
+    // if another holder's lock is in the way, or with it clear on an
+    // error.
+    bool tryLockRecords(int fd, LockMode mode, long long first, long long count, bool& busy);
+    //-----------
+    // Releases every lock `fd` holds.
+    void unlockFile(int fd);
+
+    // A descriptor opened only to hold locks on one data file; they are
+    // all released when it is destroyed.
+    class FileLock {
+    public:
+        // `write` opens the file for writing, as exclusive locks need. A
+        // missing file is not created and leaves the lock empty.
+        FileLock(const char* path, bool write);
+        ~FileLock();
+        FileLock(const FileLock&) = delete;
+        FileLock& operator=(const FileLock&) = delete;
+
+        // Each returns true without locking anything if the file could
+        // not be opened.
+        bool structure(LockMode mode) { return fd < 0 || lockRecords(fd, mode, -1, 1); }
+        bool records(LockMode mode, long long first, long long count) {
+            return fd < 0 || lockRecords(fd, mode, first, count);
+        }
+        bool all(LockMode mode) { return fd < 0 || lockRecords(fd, mode, -1, 0); }
+        //-----------
+        int descriptor() const { return fd; }
+
+    private:
+        int fd;
+    };
+
+    // --- Change capture ---
+    // Every write primitive below reports each record it changes to the
+    // installed sink, if any, while it still holds its file locks, so
+    // the sink sees the changes to one record in the order they were
+    // made, whichever process made them. `record` is the record created
+    // or written; for a delete it is the record removed, and the last
+    // record then moves to `position`. Records are passed in the current
+    // in-memory layout whatever the file's schema.
+    enum class ChangeOp : uint8_t { Create = 1, Update = 2, Delete = 3 };
+
+    using ChangeSink = void (*)(size_t entity, ChangeOp op, long long position, const void* record, size_t bytes);
+
+    //-----------
+    // Installs `sink`, or removes it if null.
+    void setChangeSink(ChangeSink sink);
+    //-----------
+    // True if a sink is installed.
+    bool capturingChanges();
+    //-----------
+    // Passes one change to the sink, if any.
+    void noteChange(size_t entity, ChangeOp op, long long position, const void* record, size_t bytes);
+
     // The full body of template functions MUST be in the header file.
 
+    // Index of entity type T in IoStats::files.
+    template <typename T>
+    constexpr size_t entityIndex() {
+        if constexpr (std::is_same_v<T, Vessel::VesselEntity>) { return 0; }
+        else if constexpr (std::is_same_v<T, Sailing::SailingEntity>) { return 1; }
+        else if constexpr (std::is_same_v<T, Vehicle::VehicleEntity>) { return 2; }
+        else if constexpr (std::is_same_v<T, Reservation::ReservationEntity>) { return 3; }
+        else if constexpr (std::is_same_v<T, Waitlist::WaitlistEntity>) { return 4; }
+        else { static_assert(std::is_same_v<T, IdDictionary::IdEntity>, "Unknown entity type"); return 5; }
+    }
+
+    template <typename T>
+    IoCounters& ioCounters() {
+        return threadIoStats().files[entityIndex<T>()];
+    }
+
+    template <typename T>
+    void noteChange(ChangeOp op, long long position, const T& record) {
+        noteChange(entityIndex<T>(), op, position, &record, sizeof(T));
+    }
+
     // Generic helper to get the correct file path for a given data type T.
+    // A compile-time constant, so opening a file builds no path string.
     template <typename T>
-    std::string getFilePath() {
+    constexpr const char* getFilePath() {
         // 'if constexpr' is a compile-time if, which is very efficient.
         if constexpr (std::is_same_v<T, Vessel::VesselEntity>) { return "Data/Vessels.dat"; }
-        if constexpr (std::is_same_v<T, Sailing::SailingEntity>) { return "Data/Sailings.dat"; }
-        if constexpr (std::is_same_v<T, Vehicle::VehicleEntity>) { return "Data/Vehicles.dat"; }
-        if constexpr (std::is_same_v<T, Reservation::ReservationEntity>) { return "Data/Reservations.dat"; }
-        // This line will cause a compile-time error if an unknown type is used, which is a good safety feature.
-        throw std::runtime_error("Data file path not defined for this entity type.");
+        else if constexpr (std::is_same_v<T, Sailing::SailingEntity>) { return "Data/Sailings.dat"; }
+        else if constexpr (std::is_same_v<T, Vehicle::VehicleEntity>) { return "Data/Vehicles.dat"; }
+        else if constexpr (std::is_same_v<T, Reservation::ReservationEntity>) { return "Data/Reservations.dat"; }
+        else if constexpr (std::is_same_v<T, Waitlist::WaitlistEntity>) { return "Data/Waitlist.dat"; }
+        else {
+            // Fails to compile if an unknown type is used, which is a good safety feature.
+            static_assert(std::is_same_v<T, IdDictionary::IdEntity>, "Data file path not defined for this entity type.");
+            return "Data/Ids.dat";
+        }
+    }
+
+    // --- Fixed-width text keys ---
+    // The text of a char[N] ID field (at most N - 1 characters), held
+    // inline and zero padded. Builds from a string_view without
+    // allocating, so a lookup by ID never touches the heap. Text too long
+    // for the field keeps its first N bytes with no terminator, so it
+    // never equals a key read from a record.
+    template <size_t N>
+    struct FixedText {
+        char text[N] = {};
+
+        FixedText() = default;
+        FixedText(std::string_view value) {
+            size_t length = std::min(value.size(), N);
+            if (length > 0) memcpy(text, value.data(), length);
+        }
+        FixedText(const std::string& value) : FixedText(std::string_view(value)) {}
+        FixedText(const char* value) : FixedText(std::string_view(value)) {}
+
+        // Key of a stored field, which may lack its terminator.
+        static FixedText ofField(const char (&field)[N]) {
+            return FixedText(std::string_view(field, strnlen(field, N - 1)));
+        }
+
+        std::string_view view() const { return std::string_view(text, strnlen(text, N)); }
+
+        bool operator==(const FixedText& other) const { return memcmp(text, other.text, N) == 0; }
+        bool operator!=(const FixedText& other) const { return !(*this == other); }
+
+        struct Hash {
+            size_t operator()(const FixedText& key) const { return std::hash<std::string_view>()(key.view()); }
+        };
+    };
+
+    // --- On-disk schema ---
+    // Schema 2 files start with a FileHeader and hold the naturally aligned
+    // entity structs. Schema 1 files (see LegacySchema.h) have no header
+    // and hold byte-packed records. Every primitive below reads and writes
+    // both, converting record by record, until migrateFile<T>() rewrites a
+    // file in schema 2 (Reservation::init() refuses a schema 1
+    // Reservations.dat, whose records have no lane). New files are always
+    // created in schema 2.
+    const uint32_t SCHEMA_VERSION = 2;
+    const uint32_t LEGACY_SCHEMA_VERSION = 1;
+    const char FILE_MAGIC[8] = { 'F', 'E', 'R', 'R', 'Y', 'D', 'A', 'T' };
+
+    // FileHeader::flags: dataEnd holds the logical end of the records and
+    // the bytes after it are preallocated space, not records. Without it
+    // the records run to the end of the file.
+    const uint32_t HEADER_TRACKS_END = 1u << 0;
+
+    struct FileHeader {
+        char magic[8];             // FILE_MAGIC
+        uint32_t schemaVersion;    // SCHEMA_VERSION
+        uint32_t recordSize;       // sizeof(T); a mismatch means a different build
+        uint64_t dataEnd;          // Logical end in bytes, if HEADER_TRACKS_END
+        uint32_t flags;            // HEADER_* bits
+        char padding[4];           // Zero; aligns the counters below
+        uint64_t writesBegun;      // Writes started (see WriteGeneration)
+        uint64_t writesDone;       // Writes finished
+        char reserved[16];         // Zero; pads the header to 64 bytes
+    };
+    static_assert(sizeof(FileHeader) == 64, "FileHeader is an on-disk layout");
+
+    // How the records of one open file are laid out.
+    struct FileLayout {
+        uint32_t schemaVersion;
+        long long dataOffset;      // Bytes before record 0
+        long long recordSize;      // Bytes per record on disk
+        long long fileBytes;       // Logical end: the header and records only
+        long long allocatedBytes = 0;  // File size, including preallocated space
+        bool tracksEnd = false;    // The header records fileBytes
+
+        bool current() const { return schemaVersion == SCHEMA_VERSION; }
+        // Complete records in the file; a torn trailing record is ignored.
+        long long records() const {
+            return fileBytes > dataOffset ? (fileBytes - dataOffset) / recordSize : 0;
+        }
+        std::streamoff offsetOf(long long position) const { return dataOffset + position * recordSize; }
+    };
+
+    template <typename T>
+    FileHeader makeFileHeader() {
+        FileHeader header = {};
+        memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+        header.schemaVersion = SCHEMA_VERSION;
+        header.recordSize = sizeof(T);
+        return header;
+    }
+
+    // Layout of a file of `fileBytes` bytes whose first `got` bytes are
+    // `header`. An empty file counts as schema 2 (the first write adds the
+    // header); a file without the magic is schema 1.
+    template <typename T>
+    FileLayout layoutOf(long long fileBytes, const FileHeader& header, long long got) {
+        FileLayout current = { SCHEMA_VERSION, sizeof(FileHeader), sizeof(T), fileBytes, fileBytes };
+        FileLayout legacy = { LEGACY_SCHEMA_VERSION, 0, sizeof(typename LegacySchema::Layout<T>::Record),
+                              fileBytes, fileBytes };
+        if (fileBytes <= 0) return current;
+        if (got < static_cast<long long>(sizeof(FileHeader)) ||
+            memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0) {
+            return legacy;
+        }
+        if (header.schemaVersion != SCHEMA_VERSION || header.recordSize != sizeof(T)) {
+            throw std::runtime_error(std::string("Unsupported schema version or record size in ") + getFilePath<T>());
+        }
+        if (header.flags & HEADER_TRACKS_END) {
+            current.tracksEnd = true;
+            // A header ahead of the data (the space was never allocated)
+            // is clamped to what is actually there.
+            current.fileBytes = std::min(static_cast<long long>(header.dataEnd), fileBytes);
+        }
+        return current;
+    }
+
+    // --- Preallocation ---
+    // Appends to a schema 2 file write into space reserved ahead of the
+    // logical end, PREALLOCATE_MIN_BYTES at first and then an eighth of
+    // the file at a time up to PREALLOCATE_MAX_BYTES, so a file grows in
+    // a few large contiguous extents rather than one record at a time.
+    const long long PREALLOCATE_MIN_BYTES = 64 * 1024;
+    const long long PREALLOCATE_MAX_BYTES = 16 * 1024 * 1024;
+
+    //-----------
+    // Makes room for `bytes` more bytes at the logical end of `file` and
+    // returns the offset they go at, or -1 on an error. An empty file
+    // gets its header first; a schema 2 file whose header does not yet
+    // track its end starts doing so; and
+    // another chunk is preallocated if the reserved space is used up.
+    // Schema 1 files have no header and simply grow. Updates `layout`
+    // except fileBytes; call setLogicalEnd() once the bytes are written.
+    long long reserveAppend(WriteFile& file, FileLayout& layout, size_t bytes, IoCounters& io);
+    //-----------
+    // Records `end` as the logical end of a schema 2 file, which tracks
+    // its end from then on, and sets layout.fileBytes. A no-op (bar the
+    // latter) for schema 1 files.
+    bool setLogicalEnd(WriteFile& file, FileLayout& layout, long long end, IoCounters& io);
+
+    // --- Write generations ---
+    // A reader that maps a schema 2 file (see ReportReplica) takes no
+    // locks, so it detects concurrent writes instead: every change to the
+    // records or the logical end increments the header's writesBegun
+    // before it starts and writesDone once it is finished. The reader
+    // loads writesDone, copies what it needs, then loads writesBegun; if
+    // they are equal no write overlapped the copy, since such a write
+    // was begun before the second load and not done before the first.
+    // Updates of different records may run at once, in several
+    // processes, so the counters are changed with atomic instructions
+    // through a shared mapping of the header. A writer that dies between
+    // the two leaves them apart until the next whole-file write settles
+    // them; readers fall back to the file lock meanwhile.
+    class WriteGeneration {
+    public:
+        // Begins a write to `path`, open as `fd` for writing with the
+        // write's locks held. A no-op for schema 1 files.
+        WriteGeneration(const char* path, int fd, const FileLayout& layout);
+        // Marks the write done.
+        ~WriteGeneration();
+        WriteGeneration(const WriteGeneration&) = delete;
+        WriteGeneration& operator=(const WriteGeneration&) = delete;
+        //-----------
+        // For a writer holding the whole file exclusively: marks every
+        // write begun as done when this one is, including any whose
+        // writer died.
+        void settle() { settles = true; }
+
+    private:
+        std::shared_ptr<FileHeader> header;
+        bool settles = false;
+    };
+
+    // Determines the layout of an open file from its size and header.
+    // Leaves the read position unspecified.
+    template <typename T>
+    FileLayout readLayout(std::istream& file, IoCounters& io) {
+        file.seekg(0, std::ios::end);
+        long long fileBytes = file.tellg();
+        io.seeks++;
+        FileHeader header = {};
+        long long got = 0;
+        if (fileBytes > 0) {
+            file.seekg(0, std::ios::beg);
+            file.read(reinterpret_cast<char*>(&header), sizeof(FileHeader));
+            got = file.gcount();
+            file.clear();
+            io.seeks++;
+            io.bytesRead += static_cast<uint64_t>(got);
+        }
+        return layoutOf<T>(fileBytes, header, got);
     }
 
-    // Creates a new record by appending it to the end of the file.
+    template <typename T>
+    FileLayout readLayout(ReadFile& file, IoCounters& io) {
+        long long fileBytes = file.size();
+        FileHeader header = {};
+        long long got = fileBytes > 0 ? file.read(&header, sizeof(FileHeader), 0, io) : 0;
+        return layoutOf<T>(fileBytes, header, got);
+    }
+
+    // Reads up to `count` records from the current position of an open
+    // file into `out`, converting from schema 1 if needed. Returns the
+    // number of complete records read.
+    template <typename T>
+    size_t readNext(std::istream& file, const FileLayout& layout, size_t count, T* out, IoCounters& io) {
+        if (layout.current()) {
+            file.read(reinterpret_cast<char*>(out), static_cast<std::streamsize>(count * sizeof(T)));
+            io.bytesRead += static_cast<uint64_t>(file.gcount());
+            return static_cast<size_t>(file.gcount()) / sizeof(T);
+        }
+        using Record = typename LegacySchema::Layout<T>::Record;
+        std::vector<Record> legacy(count);
+        file.read(reinterpret_cast<char*>(legacy.data()), static_cast<std::streamsize>(count * sizeof(Record)));
+        io.bytesRead += static_cast<uint64_t>(file.gcount());
+        size_t got = static_cast<size_t>(file.gcount()) / sizeof(Record);
+        for (size_t i = 0; i < got; i++) LegacySchema::upgrade(legacy[i], out[i]);
+        return got;
+    }
+
+    // Same, starting at record `first`.
+    template <typename T>
+    size_t readAt(std::istream& file, const FileLayout& layout, long long first, size_t count, T* out, IoCounters& io) {
+        file.clear();
+        file.seekg(layout.offsetOf(first), std::ios::beg);
+        io.seeks++;
+        return readNext(file, layout, count, out, io);
+    }
+
+    // Writes `count` records at record `first` of an open file (or at the
+    // end if the file was opened for appending), converting to schema 1
+    // if needed.
+    template <typename T>
+    void writeAt(std::ostream& file, const FileLayout& layout, long long first, const T* records, size_t count, IoCounters& io) {
+        file.seekp(layout.offsetOf(first), std::ios::beg);
+        io.seeks++;
+        if (layout.current()) {
+            file.write(reinterpret_cast<const char*>(records), static_cast<std::streamsize>(count * sizeof(T)));
+            io.bytesWritten += count * sizeof(T);
+            return;
+        }
+        using Record = typename LegacySchema::Layout<T>::Record;
+        std::vector<Record> legacy(count);
+        for (size_t i = 0; i < count; i++) LegacySchema::downgrade(records[i], legacy[i]);
+        file.write(reinterpret_cast<const char*>(legacy.data()), static_cast<std::streamsize>(count * sizeof(Record)));
+        io.bytesWritten += count * sizeof(Record);
+    }
+
+    // Number of complete records currently stored for type T (0 if no file).
+    template <typename T>
+    long long recordCount() {
+        ReadFile file(getFilePath<T>());
+        IoCounters& io = ioCounters<T>();
+        io.opens++;
+        if (!file.isOpen()) return 0;
+        lockRecords(file.descriptor(), LockMode::Shared, -1, 1); // Released when `file` closes
+        return readLayout<T>(file, io).records();
+    }
+
+    // Layout of T's data file as it is now; that of an empty file if it
+    // is missing.
+    template <typename T>
+    FileLayout fileLayout() {
+        ReadFile file(getFilePath<T>());
+        IoCounters& io = ioCounters<T>();
+        io.opens++;
+        if (!file.isOpen()) return layoutOf<T>(0, FileHeader{}, 0);
+        lockRecords(file.descriptor(), LockMode::Shared, -1, 1); // Released when `file` closes
+        return readLayout<T>(file, io);
+    }
+
+    // Schema of T's data file; SCHEMA_VERSION if it is missing or empty.
+    template <typename T>
+    uint32_t fileSchema() {
+        ReadFile file(getFilePath<T>());
+        IoCounters& io = ioCounters<T>();
+        io.opens++;
+        if (!file.isOpen()) return SCHEMA_VERSION;
+        lockRecords(file.descriptor(), LockMode::Shared, -1, 1); // Released when `file` closes
+        return readLayout<T>(file, io).schemaVersion;
+    }
+
+    // Creates a new record by appending it at the logical end of the
+    // file, inside preallocated space where there is some.
     template <typename T>
     void createRecord(const T& object) {
-        std::string path = getFilePath<T>();
-        // Open file in output, binary, and append mode. Creates file if it doesn't exist.
-        std::ofstream file(path, std::ios::binary | std::ios::app);
-        if (!file) {
+        const char* path = getFilePath<T>();
+        WriteFile file(path); // Creates the file if it doesn't exist.
+        IoCounters& io = ioCounters<T>();
+        io.opens++;
+        if (!file.isOpen()) {
             std::cerr << "ERROR: Could not open file for writing: " << path << std::endl;
             return;
         }
-        file.write(reinterpret_cast<const char*>(&object), sizeof(T));
+        lockRecords(file.descriptor(), LockMode::Exclusive, -1, 1); // Released when `file` closes
+        FileLayout layout = readLayout<T>(file, io);
+        typename LegacySchema::Layout<T>::Record legacy;
+        const void* bytes = &object;
+        if (!layout.current()) {
+            LegacySchema::downgrade(object, legacy);
+            bytes = &legacy;
+        }
+        size_t size = static_cast<size_t>(layout.recordSize);
+        long long offset = reserveAppend(file, layout, size, io);
+        WriteGeneration generation(path, file.descriptor(), layout);
+        if (offset < 0 || !file.write(bytes, size, offset, io)) {
+            std::cerr << "ERROR: Could not append to " << path << std::endl;
+            return;
+        }
+        setLogicalEnd(file, layout, offset + static_cast<long long>(size), io);
+        noteChange(ChangeOp::Create, (offset - layout.dataOffset) / layout.recordSize, object);
     }
 
     // Reads a single record from a specific 0-indexed position.
     template <typename T>
     std::optional<T> readRecord(int position) {
-    std::string path = getFilePath<T>();
-    std::ifstream file(path, std::ios::binary);
-    if (!file) return {}; // File doesn't exist yet, return empty optional.
+    const char* path = getFilePath<T>();
+    ReadFile file(path);
+    IoCounters& io = ioCounters<T>();
+    io.opens++;
+    if (!file.isOpen() || position < 0) return {}; // File doesn't exist yet, return empty optional.
+    lockRecords(file.descriptor(), LockMode::Shared, -1, 1); // Released when `file` closes
+    lockRecords(file.descriptor(), LockMode::Shared, position, 1);
 
-    file.seekg(position * sizeof(T), std::ios::beg);
+    FileLayout layout = readLayout<T>(file, io);
+    if (position >= layout.records()) {
+        return {}; // Past the last full record (most likely end of file).
+    }
     T record;
-    file.read(reinterpret_cast<char*>(&record), sizeof(T));
-
-    if (static_cast<size_t>(file.gcount()) < sizeof(T)) { // 修改这一行
-        return {}; // Didn't read a full record (most likely end of file).
+    if (layout.current()) {
+        if (file.read(&record, sizeof(T), layout.offsetOf(position), io) < static_cast<long long>(sizeof(T))) return {};
+    } else {
+        typename LegacySchema::Layout<T>::Record legacy;
+        if (file.read(&legacy, sizeof(legacy), layout.offsetOf(position), io) < static_cast<long long>(sizeof(legacy))) return {};
+        LegacySchema::upgrade(legacy, record);
     }
+    io.recordsScanned++;
     return record;
 }
+    // Reads every complete record in the file with a single open and
+    // sequential read. Used to build in-memory tables at start-up.
+    template <typename T>
+    std::vector<T> readAllRecords() {
+        std::vector<T> records;
+        FileLock lock(getFilePath<T>(), false);
+        lock.all(LockMode::Shared);
+        std::ifstream file(getFilePath<T>(), std::ios::binary);
+        IoCounters& io = ioCounters<T>();
+        io.opens += 2;
+        if (!file) return records;
+
+        FileLayout layout = readLayout<T>(file, io);
+        records.resize(static_cast<size_t>(layout.records()));
+        records.resize(readAt(file, layout, 0, records.size(), records.data(), io));
+        io.recordsScanned += records.size();
+        return records;
+    }
+
+    // Visits every record in file order with a single open, reading
+    // SCAN_CHUNK_RECORDS records per read call. `visit(position, record)`
+    // returns false to stop the scan early. The file is share-locked for
+    // the whole scan, so `visit` must not write to it.
+    const size_t SCAN_CHUNK_RECORDS = 4096;
+
+    template <typename T, typename Visitor>
+    void scanRecords(Visitor&& visit) {
+        FileLock lock(getFilePath<T>(), false);
+        lock.all(LockMode::Shared);
+        std::ifstream file(getFilePath<T>(), std::ios::binary);
+        IoCounters& io = ioCounters<T>();
+        io.opens += 2;
+        if (!file) return;
+
+        FileLayout layout = readLayout<T>(file, io);
+        file.seekg(layout.offsetOf(0), std::ios::beg);
+        io.seeks++;
+        std::vector<T> chunk(SCAN_CHUNK_RECORDS);
+        const long long total = layout.records();
+        int position = 0;
+        while (file && position < total) {
+            size_t want = static_cast<size_t>(std::min<long long>(chunk.size(), total - position));
+            size_t count = readNext(file, layout, want, chunk.data(), io);
+            if (count == 0) break;
+            for (size_t i = 0; i < count; i++) {
+                io.recordsScanned++;
+                if (!visit(position, chunk[i])) return;
+                position++;
+            }
+        }
+    }
+
+    // Reads up to `count` records starting at `first` with one open, seek
+    // and read. Safe to call from several threads at once.
+    template <typename T>
+    std::vector<T> readRecordRange(long long first, size_t count) {
+        std::vector<T> records;
+        FileLock lock(getFilePath<T>(), false);
+        lock.structure(LockMode::Shared);
+        lock.records(LockMode::Shared, first, static_cast<long long>(count));
+        std::ifstream file(getFilePath<T>(), std::ios::binary);
+        IoCounters& io = ioCounters<T>();
+        io.opens += 2;
+        if (!file) return records;
+
+        FileLayout layout = readLayout<T>(file, io);
+        if (first < 0 || first >= layout.records()) return records;
+        records.resize(static_cast<size_t>(std::min<long long>(count, layout.records() - first)));
+        records.resize(readAt(file, layout, first, records.size(), records.data(), io));
+        io.recordsScanned += records.size();
+        return records;
+    }
+
+    // --- Batched reads ---
+    // Wanted records at most this many bytes apart are fetched with one
+    // positioned read, the bytes between them landing in a scratch buffer:
+    // a gap this small lies on pages that are read anyway, so reading it
+    // is cheaper than another system call.
+    const size_t READ_GAP_BYTES = 4096;
+    // Buffers handed to one preadv() call (IOV_MAX on Linux).
+    const int READ_MAX_IOVECS = 1024;
+
+    // Reads the records at `positions[0..count)` into `out[0..count)` (slot
+    // i gets position i) with one open. Positions are sorted, duplicates
+    // are read once, and positions close together are coalesced into
+    // runs, each run costing a single preadv() that scatters the records
+    // straight into their slots. Returns the number of slots filled; a
+    // slot whose position is past the end of the file is left unfilled.
+    // Safe to call from several threads at once.
+    template <typename T>
+    size_t readRecords(const int* positions, size_t count, T* out) {
+        IoCounters& io = ioCounters<T>();
+        ReadFile file(getFilePath<T>());
+        io.opens++;
+        if (!file.isOpen() || count == 0) return 0;
+        lockRecords(file.descriptor(), LockMode::Shared, -1, 0); // Released when `file` closes
+        FileLayout layout = readLayout<T>(file, io);
+        const long long total = layout.records();
+
+        // The slots to fill, in file order.
+        std::vector<size_t> order;
+        order.reserve(count);
+        for (size_t slot = 0; slot < count; slot++) {
+            if (positions[slot] >= 0 && positions[slot] < total) order.push_back(slot);
+        }
+        std::sort(order.begin(), order.end(),
+                  [positions](size_t a, size_t b) { return positions[a] < positions[b]; });
+
+        const long long gapRecords = static_cast<long long>(READ_GAP_BYTES) / layout.recordSize;
+        std::vector<char> scratch(READ_GAP_BYTES + static_cast<size_t>(layout.recordSize));
+        std::vector<typename LegacySchema::Layout<T>::Record> legacy;
+        std::vector<struct iovec> iov;
+        std::vector<long long> slotEnds;   // End of each filled slot, in bytes from the run start
+        size_t filled = 0;
+
+        size_t next = 0;
+        while (next < order.size()) {
+            // One run: every wanted position until the next gap is too wide.
+            size_t runBegin = next;
+            long long first = positions[order[next]];
+            long long last = first;
+            while (++next < order.size() && positions[order[next]] - last - 1 <= gapRecords) {
+                last = positions[order[next]];
+            }
+            long long runBytes = (last - first + 1) * layout.recordSize;
+
+            if (!layout.current()) {
+                // Schema 1: read the packed run whole and convert the
+                // wanted records.
+                legacy.resize(static_cast<size_t>(last - first + 1));
+                long long got = file.read(legacy.data(), static_cast<size_t>(runBytes), layout.offsetOf(first), io);
+                for (size_t k = runBegin; k < next; k++) {
+                    long long index = positions[order[k]] - first;
+                    if ((index + 1) * layout.recordSize > got) break;
+                    LegacySchema::upgrade(legacy[static_cast<size_t>(index)], out[order[k]]);
+                    filled++;
+                }
+                continue;
+            }
+
+            iov.clear();
+            slotEnds.clear();
+            long long cursor = first;  // Next position the iovecs will cover
+            for (size_t k = runBegin; k < next; k++) {
+                long long position = positions[order[k]];
+                if (position < cursor) continue; // Duplicate; copied below
+                if (position > cursor) {
+                    iov.push_back({ scratch.data(), static_cast<size_t>((position - cursor) * layout.recordSize) });
+                }
+                iov.push_back({ &out[order[k]], sizeof(T) });
+                slotEnds.push_back((position - first + 1) * layout.recordSize);
+                cursor = position + 1;
+            }
+
+            long long got = 0;
+            for (size_t start = 0; start < iov.size(); start += READ_MAX_IOVECS) {
+                int batch = static_cast<int>(std::min<size_t>(READ_MAX_IOVECS, iov.size() - start));
+                long long want = 0;
+                for (int b = 0; b < batch; b++) want += static_cast<long long>(iov[start + b].iov_len);
+                long long read = file.read(&iov[start], batch, layout.offsetOf(first) + got, io);
+                got += read;
+                if (read < want) break;
+            }
+
+            size_t end = 0;
+            for (size_t k = runBegin; k < next; k++) {
+                bool duplicate = k > runBegin && positions[order[k]] == positions[order[k - 1]];
+                if (!duplicate && slotEnds[end++] > got) break;
+                if (duplicate) out[order[k]] = out[order[k - 1]];
+                filled++;
+            }
+        }
+        io.recordsScanned += filled;
+        return filled;
+    }
+
+    // Files larger than this are split into chunks of this many records
+    // for parallel loading.
+    const size_t LOAD_CHUNK_RECORDS = 65536;
+
+    // Splits the file into LOAD_CHUNK_RECORDS chunks and runs
+    // `index(firstPosition, records)` on each chunk concurrently on `pool`.
+    // Returns the per-chunk results in file order for the caller to merge.
+    // A file of one chunk or less is handled on the calling thread, which
+    // must not itself be a worker of `pool`.
+    template <typename T, typename Indexer>
+    auto mapRecordChunks(ThreadPool& pool, Indexer index)
+        -> std::vector<std::invoke_result_t<Indexer&, long long, std::vector<T>&>> {
+        using Result = std::invoke_result_t<Indexer&, long long, std::vector<T>&>;
+        long long total = recordCount<T>();
+        std::vector<Result> results;
+        if (total <= static_cast<long long>(LOAD_CHUNK_RECORDS)) {
+            std::vector<T> records = readRecordRange<T>(0, static_cast<size_t>(total));
+            results.push_back(index(0, records));
+            return results;
+        }
+
+        std::vector<std::future<Result>> chunks;
+        for (long long first = 0; first < total; first += LOAD_CHUNK_RECORDS) {
+            size_t count = static_cast<size_t>(std::min<long long>(LOAD_CHUNK_RECORDS, total - first));
+            chunks.push_back(pool.submit([first, count, &index]() {
+                std::vector<T> records = readRecordRange<T>(first, count);
+                return index(first, records);
+            }));
+        }
+        results.reserve(chunks.size());
+        for (auto& chunk : chunks) results.push_back(chunk.get());
+        return results;
+    }
+
+    // readAllRecords<T>() with the chunks read concurrently on `pool`.
+    template <typename T>
+    std::vector<T> readAllRecords(ThreadPool& pool) {
+        auto chunks = mapRecordChunks<T>(pool, [](long long, std::vector<T>& records) {
+            return std::move(records);
+        });
+        if (chunks.size() == 1) return std::move(chunks.front());
+        size_t total = 0;
+        for (const auto& chunk : chunks) total += chunk.size();
+        std::vector<T> records;
+        records.reserve(total);
+        for (const auto& chunk : chunks) records.insert(records.end(), chunk.begin(), chunk.end());
+        return records;
+    }
+
+    // Overwrites many records with a single open. Positions are sorted and
+    // adjacent positions are coalesced so each contiguous run costs one
+    // seek and one write. Of several updates to one position, the last
+    // in `updates` is written.
+    template <typename T>
+    void updateRecords(std::vector<std::pair<int, T>> updates) {
+        if (updates.empty()) return;
+        // Stable, so updates to the same position stay in the order given.
+        std::stable_sort(updates.begin(), updates.end(),
+                         [](const auto& a, const auto& b) { return a.first < b.first; });
+
+        // One exclusive span from the first position to the last.
+        FileLock lock(getFilePath<T>(), true);
+        lock.structure(LockMode::Shared);
+        lock.records(LockMode::Exclusive, updates.front().first, updates.back().first - updates.front().first + 1);
+        std::fstream file(getFilePath<T>(), std::ios::in | std::ios::out | std::ios::binary);
+        IoCounters& io = ioCounters<T>();
+        io.opens += 2;
+        if (!file) return;
+
+        FileLayout layout = readLayout<T>(file, io);
+        WriteGeneration generation(getFilePath<T>(), lock.descriptor(), layout);
+        std::vector<T> run;
+        size_t i = 0;
+        while (i < updates.size()) {
+            int runStart = updates[i].first;
+            run.clear();
+            // Later entries for the same position win.
+            while (i < updates.size() && updates[i].first <= runStart + static_cast<int>(run.size())) {
+                if (updates[i].first == runStart + static_cast<int>(run.size()) - 1) {
+                    run.back() = updates[i].second;
+                } else {
+                    run.push_back(updates[i].second);
+                }
+                i++;
+            }
+            writeAt(file, layout, runStart, run.data(), run.size(), io);
+            for (size_t k = 0; k < run.size(); k++) noteChange(ChangeOp::Update, runStart + static_cast<long long>(k), run[k]);
+        }
+        file.flush(); // Before the write is marked done
+    }
+
     // Updates a record at a specific 0-indexed position by overwriting it.
     template <typename T>
     void updateRecord(int position, const T& object) {
-        std::string path = getFilePath<T>();
+        const char* path = getFilePath<T>();
+        FileLock lock(path, true);
+        lock.structure(LockMode::Shared);
+        lock.records(LockMode::Exclusive, position, 1);
         // Open for both reading and writing to overwrite in place.
         std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        IoCounters& io = ioCounters<T>();
+        io.opens += 2;
         if (!file) return;
 
-        file.seekp(position * sizeof(T), std::ios::beg);
-        file.write(reinterpret_cast<const char*>(&object), sizeof(T));
+        FileLayout layout = readLayout<T>(file, io);
+        WriteGeneration generation(path, lock.descriptor(), layout);
+        writeAt(file, layout, position, &object, 1, io);
+        file.flush(); // Before the write is marked done
+        noteChange(ChangeOp::Update, position, object);
     }
 
-    // Deletes a record by overwriting it with the last record and then truncating the file.
+    // Deletes a record by overwriting it with the last record and then
+    // moving the logical end back one record, keeping the space for later
+    // appends; a schema 2 file is never made shorter, so a mapping of it
+    // stays valid. A schema 1 file is truncated instead.
     template <typename T>
     bool deleteRecord(int position) {
-        std::string path = getFilePath<T>();
+        const char* path = getFilePath<T>();
+        // Moves the last record and the end: the whole file, until done.
+        FileLock lock(path, true);
+        lock.all(LockMode::Exclusive);
         std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        IoCounters& io = ioCounters<T>();
+        io.opens += 2;
         if (!file) return false;
 
         // Find the total number of records in the file
-        file.seekg(0, std::ios::end);
-        long long totalSize = file.tellg();
-        int recordCount = totalSize / sizeof(T);
+        FileLayout layout = readLayout<T>(file, io);
+        long long recordCount = layout.records();
 
         if (position < 0 || position >= recordCount) return false; // Invalid position
+        WriteGeneration generation(path, lock.descriptor(), layout);
+        generation.settle();
+        std::optional<T> removed;
+        if (capturingChanges()) {
+            T record;
+            if (readAt(file, layout, position, 1, &record, io) == 1) removed = record;
+        }
 
         // If it's not the last record, move the last one into its place
         if (position < recordCount - 1) {
             T lastRecord;
-            file.seekg(-static_cast<long long>(sizeof(T)), std::ios::end);
-            file.read(reinterpret_cast<char*>(&lastRecord), sizeof(T));
-            
-            file.seekp(position * sizeof(T), std::ios::beg);
-            file.write(reinterpret_cast<const char*>(&lastRecord), sizeof(T));
+            readAt(file, layout, recordCount - 1, 1, &lastRecord, io);
+            writeAt(file, layout, position, &lastRecord, 1, io);
         }
 
         file.close(); // MUST close the file before truncating
-        
-        // Truncate the file to be one record shorter.
-        std::filesystem::resize_file(path, totalSize - sizeof(T));
+
+        if (layout.current()) {
+            WriteFile ends(path);
+            io.opens++;
+            if (!setLogicalEnd(ends, layout, layout.offsetOf(recordCount - 1), io)) return false;
+        } else {
+            // Truncate the file to be one record shorter.
+            std::filesystem::resize_file(path, static_cast<uintmax_t>(layout.offsetOf(recordCount - 1)));
+            io.truncates++;
+        }
+        if (removed) noteChange(ChangeOp::Delete, position, *removed);
         return true;
     }
+
+    // --- Asynchronous record I/O ---
+    // Each primitive opens the file, then chains AsyncIo operations: the
+    // header is read, and its completion issues the record I/O, whose
+    // completion calls `done`. The calling thread returns straight away;
+    // `done` runs on an AsyncIo completion thread (or inline when no
+    // backend is running) and I/O is counted on that thread. `done` must
+    // not block on other AsyncIo operations.
+    //
+    // The file locks are taken with lockRecordsAsync(), so no thread
+    // blocks on them, and released just before `done` runs. A `done` may
+    // start another operation on the file, even one that waits for a
+    // lock still held by a pending operation, but must not block on one.
+
+    // One lock for lockRecordsAsync(), named as for lockRecords().
+    struct RecordLock {
+        LockMode mode;
+        long long first;
+        long long count;
+    };
+
+    // Backoff between attempts at a lock that is held elsewhere.
+    const long long LOCK_RETRY_MIN_MICROS = 50;
+    const long long LOCK_RETRY_MAX_MICROS = 5000;
+
+    //-----------
+    // Takes `locks` on `file` in order, then calls `done(true)`. A lock
+    // held elsewhere is tried again after an AsyncIo::delay(), so the
+    // thread is free meanwhile to complete the operation holding it.
+    // Before AsyncIo::init() it simply blocks. On an error every lock is
+    // released and `done(false)` is called.
+    void lockRecordsAsync(std::shared_ptr<AsyncIo::File> file, std::vector<RecordLock> locks,
+                          std::function<void(bool)> done);
+
+    // Calls `next(layout)` once the header of `file` has been read, or
+    // `next(std::nullopt)` if it could not be.
+    template <typename T, typename Next>
+    void readLayoutAsync(std::shared_ptr<AsyncIo::File> file, Next next) {
+        long long fileBytes = file->size();
+        if (fileBytes <= 0) {
+            next(std::optional<FileLayout>(layoutOf<T>(fileBytes, FileHeader{}, 0)));
+            return;
+        }
+        auto header = std::make_shared<FileHeader>();
+        AsyncIo::read(file, header.get(), sizeof(FileHeader), 0,
+                      [fileBytes, header, next = std::move(next)](long long got) mutable {
+            ioCounters<T>().bytesRead += got > 0 ? static_cast<uint64_t>(got) : 0;
+            std::optional<FileLayout> layout;
+            try {
+                if (got >= 0) layout = layoutOf<T>(fileBytes, *header, got);
+            } catch (const std::exception& e) {
+                std::cerr << "ERROR: " << e.what() << std::endl;
+            }
+            next(layout);
+        });
+    }
+
+    // The on-disk bytes of `record` under `layout` (schema 1 if needed).
+    template <typename T>
+    std::shared_ptr<std::vector<char>> encodeRecord(const FileLayout& layout, const T& record) {
+        auto bytes = std::make_shared<std::vector<char>>(static_cast<size_t>(layout.recordSize));
+        if (layout.current()) {
+            memcpy(bytes->data(), &record, sizeof(T));
+        } else {
+            typename LegacySchema::Layout<T>::Record legacy;
+            LegacySchema::downgrade(record, legacy);
+            memcpy(bytes->data(), &legacy, sizeof(legacy));
+        }
+        return bytes;
+    }
+
+    // readRecordAsync<T>() once its locks are held.
+    template <typename T>
+    void readRecordLocked(std::shared_ptr<AsyncIo::File> file, int position,
+                          std::function<void(std::optional<T>)> done) {
+        readLayoutAsync<T>(file, [file, position, done = std::move(done)](std::optional<FileLayout> layout) mutable {
+            if (!layout || position >= layout->records()) {
+                unlockFile(file->fd());
+                done(std::nullopt);
+                return;
+            }
+            auto bytes = std::make_shared<std::vector<char>>(static_cast<size_t>(layout->recordSize));
+            AsyncIo::read(file, bytes->data(), bytes->size(), layout->offsetOf(position),
+                          [file, layout = *layout, bytes, done = std::move(done)](long long got) {
+                unlockFile(file->fd());
+                IoCounters& io = ioCounters<T>();
+                io.seeks++;
+                if (got > 0) io.bytesRead += static_cast<uint64_t>(got);
+                if (got < layout.recordSize) {
+                    done(std::nullopt);
+                    return;
+                }
+                T record;
+                if (layout.current()) {
+                    memcpy(&record, bytes->data(), sizeof(T));
+                } else {
+                    typename LegacySchema::Layout<T>::Record legacy;
+                    memcpy(&legacy, bytes->data(), sizeof(legacy));
+                    LegacySchema::upgrade(legacy, record);
+                }
+                io.recordsScanned++;
+                done(record);
+            });
+        });
+    }
+
+    // Asynchronous readRecord<T>(): `done(record)`, or `done(std::nullopt)`
+    // past the end of the file or on an error.
+    template <typename T>
+    void readRecordAsync(int position, std::function<void(std::optional<T>)> done) {
+        auto file = AsyncIo::File::open(getFilePath<T>(), O_RDONLY);
+        ioCounters<T>().opens++;
+        if (!file || position < 0) {
+            done(std::nullopt);
+            return;
+        }
+        lockRecordsAsync(file, { { LockMode::Shared, -1, 1 }, { LockMode::Shared, position, 1 } },
+                         [file, position, done = std::move(done)](bool locked) mutable {
+            if (!locked) {
+                done(std::nullopt);
+                return;
+            }
+            readRecordLocked<T>(file, position, std::move(done));
+        });
+    }
+
+    // updateRecordAsync<T>() once its locks are held.
+    template <typename T>
+    void updateRecordLocked(std::shared_ptr<AsyncIo::File> file, int position, const T& object,
+                            std::function<void(bool)> done) {
+        readLayoutAsync<T>(file, [file, position, object, done = std::move(done)](std::optional<FileLayout> layout) mutable {
+            if (!layout) {
+                unlockFile(file->fd());
+                done(false);
+                return;
+            }
+            auto bytes = encodeRecord(*layout, object);
+            auto generation = std::make_shared<WriteGeneration>(getFilePath<T>(), file->fd(), *layout);
+            AsyncIo::write(file, bytes->data(), bytes->size(), layout->offsetOf(position),
+                           [file, bytes, generation, position, object, done = std::move(done)](long long wrote) mutable {
+                generation.reset();
+                bool written = wrote == static_cast<long long>(bytes->size());
+                if (written) noteChange(ChangeOp::Update, position, object);
+                unlockFile(file->fd());
+                IoCounters& io = ioCounters<T>();
+                io.seeks++;
+                if (wrote > 0) io.bytesWritten += static_cast<uint64_t>(wrote);
+                done(written);
+            });
+        });
+    }
+
+    // Asynchronous updateRecord<T>(): `done(true)` once the record has been
+    // written (not yet fsync'ed; see syncRecordsAsync).
+    template <typename T>
+    void updateRecordAsync(int position, const T& object, std::function<void(bool)> done) {
+        auto file = AsyncIo::File::open(getFilePath<T>(), O_RDWR);
+        ioCounters<T>().opens++;
+        if (!file || position < 0) {
+            done(false);
+            return;
+        }
+        lockRecordsAsync(file, { { LockMode::Shared, -1, 1 }, { LockMode::Exclusive, position, 1 } },
+                         [file, position, object, done = std::move(done)](bool locked) mutable {
+            if (!locked) {
+                done(false);
+                return;
+            }
+            updateRecordLocked<T>(file, position, object, std::move(done));
+        });
+    }
+
+    // createRecordAsync<T>() once it holds the structure lock.
+    template <typename T>
+    void createRecordLocked(std::shared_ptr<AsyncIo::File> file, const T& object, std::function<void(bool)> done) {
+        const char* path = getFilePath<T>();
+        IoCounters& io = ioCounters<T>();
+        FileLayout layout = {};
+        long long offset = -1;
+        {
+            WriteFile claim(path);
+            io.opens++;
+            if (claim.isOpen()) {
+                layout = readLayout<T>(claim, io);
+                offset = reserveAppend(claim, layout, static_cast<size_t>(layout.recordSize), io);
+            }
+        }
+        if (offset < 0) {
+            unlockFile(file->fd());
+            done(false);
+            return;
+        }
+        auto bytes = encodeRecord(layout, object);
+        auto generation = std::make_shared<WriteGeneration>(path, file->fd(), layout);
+        long long end = offset + layout.recordSize;
+        long long position = (offset - layout.dataOffset) / layout.recordSize;
+        bool tracksEnd = layout.tracksEnd;
+        AsyncIo::write(file, bytes->data(), bytes->size(), offset,
+                       [file, bytes, generation, end, position, object, tracksEnd, done = std::move(done)](long long wrote) mutable {
+            if (wrote > 0) ioCounters<T>().bytesWritten += static_cast<uint64_t>(wrote);
+            bool written = wrote == static_cast<long long>(bytes->size());
+            if (!written || !tracksEnd) {
+                generation.reset();
+                if (written) noteChange(ChangeOp::Create, position, object);
+                unlockFile(file->fd());
+                done(written);
+                return;
+            }
+            auto dataEnd = std::make_shared<uint64_t>(static_cast<uint64_t>(end));
+            AsyncIo::write(file, dataEnd.get(), sizeof(uint64_t), offsetof(FileHeader, dataEnd),
+                           [file, dataEnd, generation, position, object, done = std::move(done)](long long wrote) mutable {
+                generation.reset();
+                bool ended = wrote == static_cast<long long>(sizeof(uint64_t));
+                if (ended) noteChange(ChangeOp::Create, position, object);
+                unlockFile(file->fd());
+                if (wrote > 0) ioCounters<T>().bytesWritten += static_cast<uint64_t>(wrote);
+                done(ended);
+            });
+        });
+    }
+
+    // Asynchronous createRecord<T>(): writes `object` at the logical end,
+    // then advances the end recorded in the header. The slot is found
+    // (and space preallocated if needed) once the structure lock is held;
+    // the two writes are asynchronous. The structure lock is held until
+    // both writes are done, so other appends and deletes wait for them.
+    template <typename T>
+    void createRecordAsync(const T& object, std::function<void(bool)> done) {
+        auto file = AsyncIo::File::open(getFilePath<T>(), O_RDWR | O_CREAT);
+        ioCounters<T>().opens++;
+        if (!file) {
+            done(false);
+            return;
+        }
+        lockRecordsAsync(file, { { LockMode::Exclusive, -1, 1 } },
+                         [file, object, done = std::move(done)](bool locked) mutable {
+            if (!locked) {
+                done(false);
+                return;
+            }
+            createRecordLocked<T>(file, object, std::move(done));
+        });
+    }
+
+    // Asynchronous fsync of T's data file: `done(true)` once it is durable.
+    template <typename T>
+    void syncRecordsAsync(std::function<void(bool)> done) {
+        auto file = AsyncIo::File::open(getFilePath<T>(), O_RDWR);
+        ioCounters<T>().opens++;
+        if (!file) {
+            done(false);
+            return;
+        }
+        AsyncIo::fsync(file, [done = std::move(done)](long long result) {
+            ioCounters<T>().fsyncs++;
+            done(result == 0);
+        });
+    }
+
+    // --- Migration ---
+    struct MigrationResult {
+        uint32_t fromVersion = 0;  // 0 if there was no file
+        long long records = 0;     // Records converted
+        bool migrated = false;     // False if already current, missing or failed
+        std::string error;         // Set on failure; the original is untouched
+    };
+
+    // Rewrites a schema 1 file in schema 2. The records are streamed
+    // through `chunkRecords` at a time into "<file>.migrating", which is
+    // fsync'ed and then renamed over the original, so a crash at any
+    // point leaves either the old file or the complete new one. Files
+    // already in schema 2 are left alone, and a file whose size is not a
+    // whole number of schema 1 records is refused. Must not run while the system
+    // is using the file: the exclusive lock held meanwhile covers the old
+    // file only, not the one renamed over it.
+    template <typename T>
+    MigrationResult migrateFile(size_t chunkRecords) {
+        MigrationResult result;
+        const char* path = getFilePath<T>();
+        std::string tempPath = std::string(path) + ".migrating";
+        IoCounters& io = ioCounters<T>();
+        FileLock lock(path, true);
+        lock.all(LockMode::Exclusive);
+        std::ifstream in(path, std::ios::binary);
+        io.opens += 2;
+        if (!in) return result;
+        FileLayout from = readLayout<T>(in, io);
+        result.fromVersion = from.fileBytes == 0 ? SCHEMA_VERSION : from.schemaVersion;
+        if (from.current()) return result;
+        if ((from.fileBytes - from.dataOffset) % from.recordSize != 0) {
+            // Not this build's schema 1 layout; converting would misread it.
+            result.error = std::string(path) + " is not a whole number of " +
+                           std::to_string(from.recordSize) + "-byte schema 1 records";
+            return result;
+        }
+
+        {
+            std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+            io.opens++;
+            FileHeader header = makeFileHeader<T>();
+            out.write(reinterpret_cast<const char*>(&header), sizeof(FileHeader));
+            io.bytesWritten += sizeof(FileHeader);
+
+            std::vector<T> chunk(std::max<size_t>(1, chunkRecords));
+            in.seekg(from.offsetOf(0), std::ios::beg);
+            io.seeks++;
+            while (result.records < from.records()) {
+                size_t want = static_cast<size_t>(std::min<long long>(chunk.size(), from.records() - result.records));
+                size_t got = readNext(in, from, want, chunk.data(), io);
+                if (got == 0) break;
+                out.write(reinterpret_cast<const char*>(chunk.data()), static_cast<std::streamsize>(got * sizeof(T)));
+                io.bytesWritten += got * sizeof(T);
+                io.recordsScanned += got;
+                result.records += static_cast<long long>(got);
+            }
+            out.flush();
+            if (!out || result.records != from.records()) {
+                result.error = std::string("could not convert ") + path;
+            }
+        }
+        if (result.error.empty() && !syncFile(tempPath)) result.error = "could not sync " + tempPath;
+        io.fsyncs++;
+
+        std::error_code ec;
+        if (result.error.empty()) {
+            std::filesystem::rename(tempPath, path, ec);
+            if (ec) result.error = std::string("could not replace ") + path + ": " + ec.message();
+            else syncFile(std::filesystem::path(path).parent_path().string());
+        }
+        if (!result.error.empty()) {
+            std::filesystem::remove(tempPath, ec);
+            return result;
+        }
+        result.migrated = true;
+        return result;
+    }
 }
 
-#endif // UTILITY_H
\ No newline at end of file
+#endif // UTILITY_H
@@ -14,31 +14,43 @@
 //   Rev. 1.2 - 2025/07/23
 //     - Modified createVehicle to accept separate parameters
 //     - Added getVehicleLength, getVehicleHeight, getVehiclePhone functions
+//   Rev. 1.3 - 2025/08/19
+//     - Lookups go through a keyed Repository instead of scanning the file,
+//       take a string_view and read the stored record in place
 // *)
 //******************************************************************
 #include "Vehicle.h"
+#include "Repository.h"
 #include <cstring>
+#include <iostream>
 #include <stdexcept>
+#include <utility>
 
 using namespace Vehicle;
 using namespace Utility;
 
-// Compatibility placeholders
-void Vehicle::init() {}
-void Vehicle::shutdown() {}
+namespace {
+    Repository<VehicleEntity, VehicleKey> vehicles("vehicles");
 
-bool Vehicle::isValidVehicle(const std::string& vehiclePlate) {
-    int position = 0;
-    while (true) {
-        auto record = readRecord<VehicleEntity>(position);
-        if (!record.has_value()) break;
-        
-        if (strcmp(record->plate, vehiclePlate.c_str()) == 0) {
-            return true;
+    // Returns `field(vehicle)` for the stored vehicle without copying it.
+    template <typename Field>
+    auto readVehicle(std::string_view vehiclePlate, Field field) {
+        decltype(field(std::declval<const VehicleEntity&>())) value{};
+        if (!vehicles.view(vehiclePlate, [&](const VehicleEntity& record) { value = field(record); })) {
+            throw std::runtime_error("Vehicle not found: " + std::string(vehiclePlate));
         }
-        position++;
+        return value;
     }
-    return false;
+}
+
+void Vehicle::init() {
+    vehicles.reset();
+}
+
+void Vehicle::shutdown() {}
+
+bool Vehicle::isValidVehicle(std::string_view vehiclePlate) {
+    return vehicles.exists(vehiclePlate);
 }
 
 void Vehicle::createVehicle(const std::string& vehiclePlate, const std::string& phoneNumber, double length, double height) {
@@ -60,62 +72,24 @@ void Vehicle::createVehicle(const std::string& vehiclePlate, const std::string&
     newEntity.length = length;
     newEntity.height = height;
 
-    // Create record via Utility
-    createRecord(newEntity);
-}
-
-double Vehicle::getVehicleLength(const std::string& vehiclePlate) {
-    int position = 0;
-    while (true) {
-        auto record = readRecord<VehicleEntity>(position);
-        if (!record.has_value()) break;
-        
-        if (strcmp(record->plate, vehiclePlate.c_str()) == 0) {
-            return record->length;
-        }
-        position++;
+    // Create record via the repository
+    if (!vehicles.insert(newEntity)) {
+        std::cerr << "ERROR: Vehicle '" << vehiclePlate << "' already exists" << std::endl;
     }
-    throw std::runtime_error("Vehicle not found: " + vehiclePlate);
 }
 
-double Vehicle::getVehicleHeight(const std::string& vehiclePlate) {
-    int position = 0;
-    while (true) {
-        auto record = readRecord<VehicleEntity>(position);
-        if (!record.has_value()) break;
-        
-        if (strcmp(record->plate, vehiclePlate.c_str()) == 0) {
-            return record->height;
-        }
-        position++;
-    }
-    throw std::runtime_error("Vehicle not found: " + vehiclePlate);
+double Vehicle::getVehicleLength(std::string_view vehiclePlate) {
+    return readVehicle(vehiclePlate, [](const VehicleEntity& record) { return record.length; });
 }
 
-std::string Vehicle::getVehiclePhone(const std::string& vehiclePlate) {
-    int position = 0;
-    while (true) {
-        auto record = readRecord<VehicleEntity>(position);
-        if (!record.has_value()) break;
-        
-        if (strcmp(record->plate, vehiclePlate.c_str()) == 0) {
-            return std::string(record->phone);
-        }
-        position++;
-    }
-    throw std::runtime_error("Vehicle not found: " + vehiclePlate);
+double Vehicle::getVehicleHeight(std::string_view vehiclePlate) {
+    return readVehicle(vehiclePlate, [](const VehicleEntity& record) { return record.height; });
 }
 
-std::optional<VehicleEntity> Vehicle::getVehicle(const std::string& vehiclePlate){
-    int position = 0;
-    while (true) {
-        auto record = readRecord<VehicleEntity>(position);
-        if (!record.has_value()) break;
+std::string Vehicle::getVehiclePhone(std::string_view vehiclePlate) {
+    return readVehicle(vehiclePlate, [](const VehicleEntity& record) { return std::string(record.phone); });
+}
 
-        if (strcmp(record->plate, vehiclePlate.c_str()) == 0) {
-            return record;
-        }
-        position++;
-    }
-    return std::nullopt;
+std::optional<VehicleEntity> Vehicle::getVehicle(std::string_view vehiclePlate){
+    return vehicles.find(vehiclePlate);
 }
\ No newline at end of file
@@ -14,30 +14,40 @@
 //   Rev. 1.2 - 2025/07/23
 //     - Modified createVehicle to accept separate parameters
 //     - Added getVehicleLength, getVehicleHeight, getVehiclePhone functions
+//   Rev. 1.3 - 2025/08/18
+//     - Naturally aligned schema 2 layout (56 bytes)
+//   Rev. 1.4 - 2025/08/19
+//     - VehicleKey policy for Repository; lookups take a string_view
 // *)
 //******************************************************************
 #ifndef VEHICLE_H
 #define VEHICLE_H
 
 #include <string>
+#include <string_view>
 #include <cstring>
 #include "Utility.h"
+#include "Repository.h"
 
 namespace Vehicle {
     // Entity structure for persistent storage
-    #pragma pack(push, 1)
+    // Schema 2 layout: naturally aligned, explicit padding.
     struct VehicleEntity {
-        char plate[21];            // Fixed-length 20 chars + null
-        char phone[16];            // Fixed-length 15 chars + null (e.g. +1-555-123-4567)
         double length;             // Vehicle length in meters (8 bytes)
         double height;             // Vehicle height in meters (8 bytes)
+        char plate[21];            // Fixed-length 20 chars + null
+        char phone[16];            // Fixed-length 15 chars + null (e.g. +1-555-123-4567)
+        char reserved[3];
         
         // Equality operator for CRUD operations
         bool operator==(const VehicleEntity& other) const {
             return strcmp(plate, other.plate) == 0;
         }
     };
-    #pragma pack(pop)
+    static_assert(sizeof(VehicleEntity) == 56, "VehicleEntity is an on-disk layout");
+
+    // Vehicles are identified by their plate.
+    using VehicleKey = TextKey<&VehicleEntity::plate>;
 
     //----------- CRUD Interface -----------
     void init();
@@ -45,18 +55,18 @@ namespace Vehicle {
     void shutdown();
     //-----------
     // Corresponds to OCD "isValidVehicle()".
-    bool isValidVehicle(const std::string& vehiclePlate);
+    bool isValidVehicle(std::string_view vehiclePlate);
     //-----------
     // Corresponds to OCD "createVehicle()".
     void createVehicle(const std::string& vehiclePlate, const std::string& phoneNumber, double length, double height);
     //-----------
-    double getVehicleLength(const std::string& vehiclePlate);
+    double getVehicleLength(std::string_view vehiclePlate);
     //-----------
-    double getVehicleHeight(const std::string& vehiclePlate);
+    double getVehicleHeight(std::string_view vehiclePlate);
     //-----------
-    std::string getVehiclePhone(const std::string& vehiclePlate);
+    std::string getVehiclePhone(std::string_view vehiclePlate);
     //-----------
-    std::optional<VehicleEntity> getVehicle(const std::string& vehiclePlate);
+    std::optional<VehicleEntity> getVehicle(std::string_view vehiclePlate);
 }
 
 #endif // VEHICLE_H
\ No newline at end of file
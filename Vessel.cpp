@@ -4,20 +4,34 @@
 //
 // Low-level Vessel module that manages vessel data.
 //
+// Rev 1.3 - 2025-08-25 - reload().
+// Rev 1.2 - 2025-08-19 - Lookups and deletes go through a keyed Repository;
+//                         lookups take a string_view and never allocate.
 // Rev 1.1 - 2025-07-23 - Fixed infinite loop in getVessel and added deleteVessel.
 // Rev 1.0 - 2025-07-22 - Initial version
 //*******************************
 
 #include "Vessel.h"
 #include "Utility.h"
-#include <cstring> // For strncpy and strcmp
+#include "Repository.h"
+#include <cstring> // For strncpy
 #include <iostream>
 
 namespace Vessel {
+
+    namespace {
+        Repository<VesselEntity, VesselKey> vessels("vessels");
+    }
+
     void init() {
+        reload();
         std::cout << "MODEL/Vessel: Initialized." << std::endl;
     }
 
+    void reload() {
+        vessels.reset();
+    }
+
     void shutdown() {
         std::cout << "MODEL/Vessel: Shut down." << std::endl;
     }
@@ -30,41 +44,23 @@ namespace Vessel {
         newVessel.LCLL = LCLL;
         newVessel.HCLL = HCLL;
 
-        Utility::createRecord(newVessel);
+        if (!vessels.insert(newVessel)) {
+            std::cerr << "ERROR: Vessel '" << vesselID << "' already exists" << std::endl;
+        }
     }
 
-    std::optional<VesselEntity> getVessel(const std::string& vesselID) {
-        int position = 0;
-        while (true) {
-            auto recordOpt = Utility::readRecord<VesselEntity>(position);
-            if (!recordOpt.has_value()) {
-                return {}; // Reached end of file, not found.
-            }
-            if (strcmp(recordOpt->vesselID, vesselID.c_str()) == 0) {
-                return recordOpt; // Found it.
-            }
-            position++;
-        }
+    std::optional<VesselEntity> getVessel(std::string_view vesselID) {
+        return vessels.find(vesselID);
     }
     
-    bool isValidVessel(const std::string& vesselID) {
-        return getVessel(vesselID).has_value();
+    bool isValidVessel(std::string_view vesselID) {
+        return vessels.exists(vesselID);
     }
     
     // Added implementation for deleteVessel
     void deleteVessel(const std::string& vesselID) {
-        int position = 0;
-        while (true) {
-            auto recordOpt = Utility::readRecord<VesselEntity>(position);
-            if (!recordOpt.has_value()) {
-                std::cerr << "ERROR: Cannot delete non-existent vessel '" << vesselID << "'" << std::endl;
-                return;
-            }
-            if (strcmp(recordOpt->vesselID, vesselID.c_str()) == 0) {
-                Utility::deleteRecord<VesselEntity>(position);
-                return;
-            }
-            position++;
+        if (!vessels.erase(vesselID)) {
+            std::cerr << "ERROR: Cannot delete non-existent vessel '" << vesselID << "'" << std::endl;
         }
     }
 }
\ No newline at end of file
@@ -5,6 +5,9 @@
 // PURPOSE:          The data model for vessels.
 //
 // (* Revision History:
+//   Rev. 1.4 - 2025/08/25 - Added reload().
+//   Rev. 1.3 - 2025/08/19 - VesselKey policy for Repository; lookups take a string_view.
+//   Rev. 1.2 - 2025/08/18 - Naturally aligned schema 2 layout (40 bytes).
 //   Rev. 1.1 - 2025/07/23 - Changed VesselEntity to use fixed-size char array for binary I/O.
 //   Rev. 1.0 - 2025/07/07
 // *)
@@ -13,30 +16,38 @@
 #define VESSEL_H
 
 #include <string>
+#include <string_view>
 #include <optional>
 #include <cstring> // Required for strcmp
+#include "Repository.h"
 
 namespace Vessel {
     // This struct MUST use Plain Old Data (POD) types for binary file I/O.
     // std::string is not a POD type.
-    #pragma pack(push, 1)
+    // Schema 2 layout: doubles first so every field is naturally aligned;
+    // explicit padding keeps the on-disk bytes defined.
     struct VesselEntity {
-        char vesselID[21]; // Use a fixed-size char array instead of std::string
         double LCLL;
         double HCLL;
+        char vesselID[21]; // Use a fixed-size char array instead of std::string
+        char reserved[3];
 
         // Equality operator for Utility functions
         bool operator==(const VesselEntity& other) const {
             return strcmp(vesselID, other.vesselID) == 0;
         }
     };
-    #pragma pack(pop)
+    static_assert(sizeof(VesselEntity) == 40, "VesselEntity is an on-disk layout");
+
+    // Vessels are identified by their ID.
+    using VesselKey = TextKey<&VesselEntity::vesselID>;
 
     void init();
+    void reload();  // As init(), quietly: the file was changed by another process
     void shutdown();
     void createVessel(const std::string& vesselID, double LCLL, double HCLL);
-    std::optional<VesselEntity> getVessel(const std::string& vesselID);
-    bool isValidVessel(const std::string& vesselID);
+    std::optional<VesselEntity> getVessel(std::string_view vesselID);
+    bool isValidVessel(std::string_view vesselID);
     // Added for the unit test
     void deleteVessel(const std::string& vesselID);
 }
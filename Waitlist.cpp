@@ -0,0 +1,161 @@
+// Waitlist.cpp
+//*******************************
+// Waitlist.cpp
+//
+// Waitlist.dat holds one record per waiting vehicle. In memory each entry
+// is indexed by plate (entry + file position) and by request sequence in
+// an ordered map, one map per sailing and vehicle class, so a promotion
+// can walk past vehicles that do not fit to the ones behind them. File
+// removal uses Utility::deleteRecord, so the relocated last record's
+// position is patched through the plate index: O(1) file operations per
+// change.
+//
+// Rev 1.2 - 2025-08-25 - reload()
+// Rev 1.1 - 2025-08-25 - Ordered maps instead of heaps, so every waiting
+//                        entry can be listed in order
+// Rev 1.0 - 2025-08-13 - Initial version
+//*******************************
+
+#include "Waitlist.h"
+#include <algorithm>
+#include <ctime>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+
+namespace Waitlist {
+
+    namespace {
+        struct Slot {
+            WaitlistEntity entity;
+            int position;   // Record position in Waitlist.dat
+        };
+
+        // sequence -> plate, per vehicle class
+        struct SailingQueues {
+            std::map<uint64_t, std::string> byClass[2];
+        };
+
+        std::mutex waitlistLock;
+        std::unordered_map<std::string, Slot> slots;            // plate -> entry
+        std::vector<std::string> platesByPosition;              // file position -> plate
+        std::unordered_map<std::string, SailingQueues> queues;  // sailingID -> queues
+        uint64_t nextSequence = 1;
+
+        int classIndex(const WaitlistEntity& entity) { return entity.vehicleClass ? 1 : 0; }
+
+        void pushLocked(const WaitlistEntity& entity) {
+            queues[entity.sailingID].byClass[classIndex(entity)][entity.sequence] = entity.vehiclePlate;
+        }
+
+        void removeLocked(const std::string& vehiclePlate) {
+            auto slot = slots.find(vehiclePlate);
+            if (slot == slots.end()) return;
+            int position = slot->second.position;
+            int last = static_cast<int>(platesByPosition.size()) - 1;
+
+            auto sailing = queues.find(slot->second.entity.sailingID);
+            if (sailing != queues.end()) {
+                sailing->second.byClass[classIndex(slot->second.entity)].erase(slot->second.entity.sequence);
+                if (sailing->second.byClass[0].empty() && sailing->second.byClass[1].empty()) queues.erase(sailing);
+            }
+
+            Utility::deleteRecord<WaitlistEntity>(position);
+            if (position < last) {
+                // deleteRecord moved the last record into the hole.
+                platesByPosition[position] = platesByPosition[last];
+                slots[platesByPosition[position]].position = position;
+            }
+            platesByPosition.pop_back();
+            slots.erase(slot);
+        }
+    }
+
+    void init() {
+        reload();
+        std::cout << "MODEL/Waitlist: Initialized." << std::endl;
+    }
+
+    void reload() {
+        std::lock_guard<std::mutex> guard(waitlistLock);
+        slots.clear();
+        platesByPosition.clear();
+        queues.clear();
+        nextSequence = 1;
+        for (const auto& entity : Utility::readAllRecords<WaitlistEntity>()) {
+            int position = static_cast<int>(platesByPosition.size());
+            platesByPosition.push_back(entity.vehiclePlate);
+            slots[entity.vehiclePlate] = { entity, position };
+            pushLocked(entity);
+            nextSequence = std::max(nextSequence, entity.sequence + 1);
+        }
+    }
+
+    void shutdown() {
+        std::cout << "MODEL/Waitlist: Shut down." << std::endl;
+    }
+
+    bool add(const std::string& sailingID, const std::string& vehiclePlate, VehicleClass vehicleClass) {
+        std::lock_guard<std::mutex> guard(waitlistLock);
+        if (slots.count(vehiclePlate)) return false;
+
+        WaitlistEntity entity;
+        memset(&entity, 0, sizeof(WaitlistEntity));
+        strncpy(entity.sailingID, sailingID.c_str(), 20);
+        strncpy(entity.vehiclePlate, vehiclePlate.c_str(), 20);
+        entity.sequence = nextSequence++;
+        entity.requestTime = static_cast<int64_t>(std::time(nullptr));
+        entity.vehicleClass = static_cast<unsigned char>(vehicleClass);
+
+        Utility::createRecord(entity);
+        slots[entity.vehiclePlate] = { entity, static_cast<int>(platesByPosition.size()) };
+        platesByPosition.push_back(entity.vehiclePlate);
+        pushLocked(entity);
+        return true;
+    }
+
+    bool remove(const std::string& vehiclePlate) {
+        std::lock_guard<std::mutex> guard(waitlistLock);
+        if (!slots.count(vehiclePlate)) return false;
+        removeLocked(vehiclePlate);
+        return true;
+    }
+
+    std::optional<WaitlistEntity> find(const std::string& vehiclePlate) {
+        std::lock_guard<std::mutex> guard(waitlistLock);
+        auto slot = slots.find(vehiclePlate);
+        if (slot == slots.end()) return {};
+        return slot->second.entity;
+    }
+
+    std::vector<WaitlistEntity> waiting(const std::string& sailingID, bool regular, bool oversize) {
+        std::lock_guard<std::mutex> guard(waitlistLock);
+        std::vector<WaitlistEntity> result;
+        auto sailing = queues.find(sailingID);
+        if (sailing == queues.end()) return result;
+
+        const bool wanted[2] = { regular, oversize };
+        for (int vehicleClass = 0; vehicleClass < 2; vehicleClass++) {
+            if (!wanted[vehicleClass]) continue;
+            for (const auto& queued : sailing->second.byClass[vehicleClass]) {
+                result.push_back(slots[queued.second].entity);
+            }
+        }
+        std::sort(result.begin(), result.end(), [](const WaitlistEntity& a, const WaitlistEntity& b) {
+            return a.sequence < b.sequence;
+        });
+        return result;
+    }
+
+    void removeSailing(const std::string& sailingID) {
+        std::lock_guard<std::mutex> guard(waitlistLock);
+        auto sailing = queues.find(sailingID);
+        if (sailing == queues.end()) return;
+        std::vector<std::string> plates;
+        for (const auto& queue : sailing->second.byClass) {
+            for (const auto& queued : queue) plates.push_back(queued.second);
+        }
+        for (const auto& plate : plates) removeLocked(plate);
+    }
+}
@@ -0,0 +1,85 @@
+// Waitlist.h
+//******************************************************************
+// DEFINITION MODULE: Waitlist
+//
+// PURPOSE:          The data model for vehicles waiting for space on a
+//                   full sailing. Every entry is stored in Waitlist.dat
+//                   and mirrored in memory as one queue per sailing and
+//                   vehicle class, ordered by request time, so promotion
+//                   walks the waiting vehicles oldest first without
+//                   touching the file and a "am I still waiting?" lookup
+//                   by plate is O(1).
+//
+//                   A vehicle waits on at most one sailing at a time.
+//
+// (* Revision History:
+//   Rev. 1.2 - 2025/08/25 - waiting() lists every entry, not only the
+//                           head of each queue; added reload()
+//   Rev. 1.1 - 2025/08/18 - Naturally aligned schema 2 layout (64 bytes)
+//   Rev. 1.0 - 2025/08/13 - Initial version
+// *)
+//******************************************************************
+#ifndef WAITLIST_H
+#define WAITLIST_H
+
+#include <cstdint>
+#include <cstring> // For strcmp
+#include <optional>
+#include <string>
+#include <vector>
+#include "Utility.h"
+
+namespace Waitlist {
+
+    // Separate queues per class, because a regular vehicle can use either
+    // deck but an oversize one only the high ceiling deck.
+    enum class VehicleClass : unsigned char {
+        Regular = 0,
+        Oversize = 1
+    };
+
+    // Entity structure for persistent storage
+    // Schema 2 layout: naturally aligned, explicit padding.
+    struct WaitlistEntity {
+        uint64_t sequence;         // Request order, increases with every request
+        int64_t requestTime;       // Seconds since the epoch
+        char sailingID[21];        // Fixed-length 20 chars + null
+        char vehiclePlate[21];     // Fixed-length 20 chars + null
+        unsigned char vehicleClass; // VehicleClass
+        char reserved[5];
+
+        // Equality operator for CRUD operations
+        bool operator==(const WaitlistEntity& other) const {
+            return strcmp(vehiclePlate, other.vehiclePlate) == 0;
+        }
+    };
+    static_assert(sizeof(WaitlistEntity) == 64, "WaitlistEntity is an on-disk layout");
+
+    //-----------
+    // Loads Waitlist.dat and builds the queues.
+    void init();
+    //-----------
+    // As init(), without its message, after another process has
+    // changed Waitlist.dat.
+    void reload();
+    //-----------
+    void shutdown();
+    //-----------
+    // Appends `vehiclePlate` to the back of its class queue on
+    // `sailingID`. Returns false if the vehicle is already waiting.
+    bool add(const std::string& sailingID, const std::string& vehiclePlate, VehicleClass vehicleClass);
+    //-----------
+    // Takes `vehiclePlate` off the waitlist. Returns false if it was not on it.
+    bool remove(const std::string& vehiclePlate);
+    //-----------
+    std::optional<WaitlistEntity> find(const std::string& vehiclePlate);
+    //-----------
+    // Every entry of the requested classes waiting on `sailingID`, oldest
+    // first. Nothing is removed.
+    std::vector<WaitlistEntity> waiting(const std::string& sailingID, bool regular, bool oversize);
+    //-----------
+    // Drops every entry for `sailingID`.
+    void removeSailing(const std::string& sailingID);
+}
+
+#endif // WAITLIST_H
@@ -0,0 +1,331 @@
+// benchLoad.cpp
+//******************************************************************
+// BENCHMARK DRIVER: End-to-End Throughput Through the Controller
+//
+// PURPOSE:          Generates a synthetic fleet (vessels, sailings,
+//                   vehicles and reservations) and then drives the
+//                   Controller API with a realistic mix of booth
+//                   operations. Reports mean and p50/p99/p999 latency
+//                   for every operation type, and the throughput of the
+//                   workload as a whole (operations executed per second
+//                   of wall clock), so storage changes can be compared
+//                   run against run. Draws that find nothing to do (no
+//                   vehicle left to book or cancel, or no space on the
+//                   sailing picked) are not counted as operations.
+//
+// USAGE:            run_bench_load [--vessels N] [--sailings N]
+//                                  [--vehicles N] [--reservations N]
+//                                  [--ops N] [--seed N]
+//
+//                   The generator is driven by a seeded std::mt19937_64,
+//                   so the same arguments always produce the same data
+//                   set and the same operation sequence. Each run starts
+//                   from an empty Data/ inside a new scratch directory
+//                   (bench-load-XXXXXX) under the current one, which is
+//                   removed afterwards, so a Data/ directory already there
+//                   is never touched.
+//
+//                   Defaults are deliberately small. Large fleets (for
+//                   example 1M vehicles, 50k sailings, 10M reservations)
+//                   are requested with the flags above; expect the
+//                   population phase to dominate on the linear-scan
+//                   storage layer.
+//
+// HOW TO COMPILE:
+// g++ -std=c++17 -O2 benchLoad.cpp Controller.cpp Reservation.cpp Sailing.cpp Vessel.cpp Utility.cpp Vehicle.cpp Metrics.cpp CapacityIndex.cpp LaneAllocator.cpp Waitlist.cpp BloomFilter.cpp Checkpoint.cpp ThreadPool.cpp IdDictionary.cpp LegacySchema.cpp ChangeFeed.cpp AsyncIo.cpp -pthread -o run_bench_load
+//
+// (* Revision History:
+//   Rev. 1.4 - 2025/08/25 - Mean latency replaces the per-operation ops/sec;
+//                          overall throughput counts executed operations only
+//   Rev. 1.3 - 2025/08/25 - Runs in a scratch directory, never in ./Data
+//   Rev. 1.2 - 2025/08/25 - Compile line links AsyncIo
+//   Rev. 1.1 - 2025/08/12 - Count lane-packing rejections as capacity rejections
+//   Rev. 1.0 - 2025/08/03 - Initial version
+// *)
+//******************************************************************
+
+#include "Controller.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+    struct Config {
+        long vessels = 10;
+        long sailings = 200;
+        long vehicles = 2000;
+        long reservations = 1000;
+        long ops = 2000;
+        unsigned long long seed = 42;
+    };
+
+    // Operation mix for the steady-state phase, in percent (sums to 100).
+    struct OperationWeight {
+        const char* name;
+        int percent;
+    };
+    const OperationWeight OPERATION_MIX[] = {
+        { "checkReservationExists", 25 },
+        { "queryIndividualSailing", 20 },
+        { "createNewReservation",   20 },
+        { "cancelReservation",      15 },
+        { "checkInVehicle",         15 },
+        { "getSailingReport",        5 },
+    };
+
+    // Collects raw latency samples (nanoseconds) for one operation type.
+    struct LatencySeries {
+        std::vector<long long> samples;
+        double totalSeconds = 0.0;
+    };
+
+    std::map<std::string, LatencySeries> results;
+
+    // Times a single call and records it under `name`.
+    template <typename Fn>
+    void timed(const std::string& name, Fn&& fn) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        LatencySeries& series = results[name];
+        long long ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+        series.samples.push_back(ns);
+        series.totalSeconds += ns / 1e9;
+    }
+
+    double percentile(std::vector<long long>& sorted, double p) {
+        if (sorted.empty()) return 0.0;
+        size_t index = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+        return sorted[std::min(index, sorted.size() - 1)] / 1000.0;
+    }
+
+    // Prints one row per operation type; returns how many operations
+    // were timed in all.
+    long printReport() {
+        long executed = 0;
+        std::cout << "\n" << std::left << std::setw(26) << "operation"
+                  << std::right << std::setw(10) << "count"
+                  << std::setw(14) << "mean(us)"
+                  << std::setw(12) << "p50(us)"
+                  << std::setw(12) << "p99(us)"
+                  << std::setw(12) << "p999(us)" << "\n";
+        for (auto& [name, series] : results) {
+            std::vector<long long> sorted = series.samples;
+            std::sort(sorted.begin(), sorted.end());
+            double meanMicros = sorted.empty() ? 0.0 : series.totalSeconds * 1e6 / sorted.size();
+            executed += static_cast<long>(sorted.size());
+            std::cout << std::left << std::setw(26) << name
+                      << std::right << std::setw(10) << sorted.size()
+                      << std::setw(14) << std::fixed << std::setprecision(1) << meanMicros
+                      << std::setw(12) << percentile(sorted, 0.50)
+                      << std::setw(12) << percentile(sorted, 0.99)
+                      << std::setw(12) << percentile(sorted, 0.999) << "\n";
+        }
+        return executed;
+    }
+
+    bool parseArgs(int argc, char* argv[], Config& config) {
+        for (int i = 1; i + 1 < argc; i += 2) {
+            std::string flag = argv[i];
+            long long value = std::atoll(argv[i + 1]);
+            if (value < 0) return false;
+            if (flag == "--vessels") config.vessels = static_cast<long>(value);
+            else if (flag == "--sailings") config.sailings = static_cast<long>(value);
+            else if (flag == "--vehicles") config.vehicles = static_cast<long>(value);
+            else if (flag == "--reservations") config.reservations = static_cast<long>(value);
+            else if (flag == "--ops") config.ops = static_cast<long>(value);
+            else if (flag == "--seed") config.seed = static_cast<unsigned long long>(value);
+            else return false;
+        }
+        if (argc % 2 == 0) return false;
+        if (config.vessels < 1 || config.sailings < 1 || config.vehicles < 1) return false;
+        config.reservations = std::min(config.reservations, config.vehicles);
+        return true;
+    }
+
+    // Makes a scratch directory under the current one and moves into it.
+    // Returns its absolute path, or an empty string if it could not.
+    std::string enterScratchDirectory() {
+        char name[] = "bench-load-XXXXXX";
+        if (::mkdtemp(name) == nullptr) return "";
+        std::error_code ec;
+        std::filesystem::path path = std::filesystem::absolute(name, ec);
+        if (!ec) std::filesystem::current_path(path, ec);
+        if (ec) {
+            std::filesystem::remove(name, ec);
+            return "";
+        }
+        return path.string();
+    }
+
+    std::string makeId(const char* prefix, long n) {
+        char buffer[21];
+        std::snprintf(buffer, sizeof(buffer), "%s%ld", prefix, n);
+        return buffer;
+    }
+
+    // Mirrors the space check performed by the UI before booking.
+    bool hasSpace(const std::string& sailingID, const std::string& plate) {
+        auto vehicle = Controller::getVehicle(plate);
+        auto sailing = Controller::getSailing(sailingID);
+        if (!vehicle || !sailing) return false;
+        return vehicle->length < sailing->LRL || vehicle->length < sailing->HRL;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    Config config;
+    if (!parseArgs(argc, argv, config)) {
+        std::cerr << "usage: run_bench_load [--vessels N] [--sailings N] [--vehicles N]"
+                  << " [--reservations N] [--ops N] [--seed N]" << std::endl;
+        return 1;
+    }
+
+    std::cout << "===== Benchmark: End-to-End Controller Throughput =====" << std::endl;
+    std::cout << "vessels=" << config.vessels << " sailings=" << config.sailings
+              << " vehicles=" << config.vehicles << " reservations=" << config.reservations
+              << " ops=" << config.ops << " seed=" << config.seed << std::endl;
+
+    std::filesystem::path original = std::filesystem::current_path();
+    std::string scratch = enterScratchDirectory();
+    if (scratch.empty()) {
+        std::cerr << "ERROR: Could not make a scratch directory in " << original << std::endl;
+        return 1;
+    }
+    Controller::init();
+
+    std::mt19937_64 rng(config.seed);
+    std::uniform_real_distribution<double> regularLength(3.5, 6.5);
+    std::uniform_real_distribution<double> specialLength(7.5, 20.0);
+    std::uniform_real_distribution<double> regularHeight(1.4, 2.0);
+    std::uniform_real_distribution<double> specialHeight(2.1, 4.5);
+    std::bernoulli_distribution isSpecial(0.15);
+
+    // --- POPULATION PHASE ---
+    for (long i = 0; i < config.vessels; i++) {
+        std::string vesselID = makeId("V", i);
+        timed("createNewVessel", [&] { Controller::createNewVessel(vesselID, 3600.0, 3600.0); });
+    }
+    std::vector<std::string> sailingIDs;
+    for (long i = 0; i < config.sailings; i++) {
+        std::string vesselID = makeId("V", i % config.vessels);
+        sailingIDs.push_back(makeId("S", i));
+        timed("createNewSailing", [&] { Controller::createNewSailing(vesselID, sailingIDs.back()); });
+    }
+    std::vector<std::string> plates;
+    for (long i = 0; i < config.vehicles; i++) {
+        bool special = isSpecial(rng);
+        double length = special ? specialLength(rng) : regularLength(rng);
+        double height = special ? specialHeight(rng) : regularHeight(rng);
+        plates.push_back(makeId("P", i));
+        timed("createNewVehicle", [&] { Controller::createNewVehicle(plates.back(), "6045550100", length, height); });
+    }
+
+    // Vehicle indexes that currently hold / do not hold a reservation,
+    // and the sailing each reserved vehicle is booked on.
+    std::vector<long> reserved;
+    std::vector<long> unreserved;
+    std::vector<long> bookedSailing(config.vehicles, -1);
+    for (long i = 0; i < config.vehicles; i++) unreserved.push_back(i);
+    std::shuffle(unreserved.begin(), unreserved.end(), rng);
+
+    std::uniform_int_distribution<long> pickSailing(0, config.sailings - 1);
+    auto book = [&](long vehicle) {
+        long sailing = pickSailing(rng);
+        if (!hasSpace(sailingIDs[sailing], plates[vehicle])) return false;
+        bool booked = false;
+        timed("createNewReservation", [&] { booked = Controller::createNewReservation(sailingIDs[sailing], plates[vehicle]); });
+        if (!booked) return false;
+        bookedSailing[vehicle] = sailing;
+        reserved.push_back(vehicle);
+        return true;
+    };
+
+    long rejected = 0;
+    while (static_cast<long>(reserved.size()) < config.reservations && !unreserved.empty()) {
+        long vehicle = unreserved.back();
+        unreserved.pop_back();
+        if (!book(vehicle)) {
+            rejected++;
+            unreserved.insert(unreserved.begin(), vehicle);
+            if (rejected > config.reservations) break; // Fleet is full
+        }
+    }
+    std::cout << "Population complete: " << reserved.size() << " reservations ("
+              << rejected << " rejected for capacity)." << std::endl;
+
+    // The steady-state report only covers the mixed workload.
+    results.clear();
+
+    // --- MIXED WORKLOAD PHASE ---
+    std::uniform_int_distribution<int> pickPercent(0, 99);
+    auto pickFrom = [&](std::vector<long>& list) {
+        std::uniform_int_distribution<size_t> dist(0, list.size() - 1);
+        return dist(rng);
+    };
+
+    auto workloadStart = std::chrono::steady_clock::now();
+    for (long op = 0; op < config.ops; op++) {
+        int roll = pickPercent(rng);
+        const char* name = OPERATION_MIX[0].name;
+        for (const auto& weight : OPERATION_MIX) {
+            if (roll < weight.percent) { name = weight.name; break; }
+            roll -= weight.percent;
+        }
+        std::string operation = name;
+
+        if (operation == "checkReservationExists") {
+            const std::string& plate = plates[std::uniform_int_distribution<long>(0, config.vehicles - 1)(rng)];
+            timed(operation, [&] { Controller::checkReservationExists(plate); });
+        } else if (operation == "queryIndividualSailing") {
+            const std::string& sailing = sailingIDs[pickSailing(rng)];
+            timed(operation, [&] { Controller::queryIndividualSailing(sailing); });
+        } else if (operation == "getSailingReport") {
+            int offset = static_cast<int>(pickSailing(rng));
+            timed(operation, [&] { Controller::getSailingReport(offset); });
+        } else if (operation == "createNewReservation") {
+            if (unreserved.empty()) continue;
+            size_t index = pickFrom(unreserved);
+            long vehicle = unreserved[index];
+            if (book(vehicle)) {
+                unreserved[index] = unreserved.back();
+                unreserved.pop_back();
+            }
+        } else if (reserved.empty()) {
+            continue;
+        } else if (operation == "cancelReservation") {
+            size_t index = pickFrom(reserved);
+            long vehicle = reserved[index];
+            timed(operation, [&] { Controller::cancelReservation(sailingIDs[bookedSailing[vehicle]], plates[vehicle]); });
+            bookedSailing[vehicle] = -1;
+            reserved[index] = reserved.back();
+            reserved.pop_back();
+            unreserved.push_back(vehicle);
+        } else if (operation == "checkInVehicle") {
+            long vehicle = reserved[pickFrom(reserved)];
+            timed(operation, [&] { Controller::checkInVehicle(plates[vehicle]); });
+        }
+    }
+    double workloadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - workloadStart).count();
+
+    long executed = printReport();
+    std::cout << "\nMixed workload: " << executed << " ops executed (" << config.ops - executed
+              << " draws with nothing to do) in " << std::setprecision(3) << workloadSeconds
+              << " s (" << std::setprecision(1) << (workloadSeconds > 0 ? executed / workloadSeconds : 0.0)
+              << " ops/sec overall)" << std::endl;
+
+    Controller::shutdown();
+    std::filesystem::current_path(original);
+    std::filesystem::remove_all(scratch);
+    return 0;
+}
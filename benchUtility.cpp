@@ -0,0 +1,378 @@
+// benchUtility.cpp
+//******************************************************************
+// BENCHMARK DRIVER: Utility CRUD Primitives per Entity Type
+//
+// PURPOSE:          Times Utility::createRecord, readRecord, updateRecord
+//                   and deleteRecord, batched readRecords of random
+//                   positions, the same positions read concurrently
+//                   with readRecordAsync (all in flight at once), plus the "readRecord until nullopt"
+//                   scan loop the data modules use, for every entity
+//                   struct across a range of file sizes, with a cold and
+//                   a warm page cache. Results are printed as a single
+//                   JSON document so two builds can be diffed directly.
+//
+// USAGE:            run_bench_utility [--sizes 1000,10000,...] [--samples N]
+//                                     [--scan-limit N] [--seed N]
+//                                     [--async-backend io_uring|pool]
+//
+//                   Cold-cache samples evict the data file from the OS
+//                   page cache (posix_fadvise DONTNEED) before every
+//                   timed call. On platforms without posix_fadvise the
+//                   cold series is skipped and "coldSupported" is false.
+//                   Scans are timed over at most --scan-limit records
+//                   and reported per record, so 10M-record files do not
+//                   take hours to benchmark.
+//                   --async-backend picks the AsyncIo backend for the
+//                   readRecordAsync series (default io_uring, which falls
+//                   back to the pool if the kernel refuses it); the one
+//                   used is reported as "asyncBackend".
+//
+//                   The files are built in Data/ inside a new scratch
+//                   directory (bench-utility-XXXXXX) under the current
+//                   one, which is removed afterwards, so a Data/ directory
+//                   already there is never touched. It is made on the same
+//                   file system as the working directory on purpose.
+//
+// HOW TO COMPILE:
+// g++ -std=c++17 -O2 benchUtility.cpp Utility.cpp LegacySchema.cpp IdDictionary.cpp AsyncIo.cpp ThreadPool.cpp -pthread -o run_bench_utility
+//
+// (* Revision History:
+//   Rev. 1.6 - 2025/08/25 - Runs in a scratch directory, never in ./Data
+//   Rev. 1.5 - 2025/08/20 - readRecordAsync series, --async-backend
+//   Rev. 1.4 - 2025/08/19 - readRecords series
+//   Rev. 1.3 - 2025/08/19 - getFilePath<T>() is a C string constant
+//   Rev. 1.2 - 2025/08/18 - Generated files carry the schema 2 header
+//   Rev. 1.1 - 2025/08/17 - Reservations reference IdDictionary keys
+//   Rev. 1.0 - 2025/08/04 - Initial version
+// *)
+//******************************************************************
+
+#include "Utility.h"
+#include "Vessel.h"
+#include "Sailing.h"
+#include "Vehicle.h"
+#include "Reservation.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#define BENCH_HAS_FADVISE 1
+#else
+#define BENCH_HAS_FADVISE 0
+#endif
+
+namespace {
+
+    struct Config {
+        std::vector<long> sizes = { 1000, 10000, 100000 };
+        int samples = 200;
+        long scanLimit = 100000;
+        unsigned long long seed = 42;
+        AsyncIo::Backend asyncBackend = AsyncIo::Backend::IoUring;
+    };
+
+    // Positions fetched by one readRecords or readRecordAsync sample.
+    const long BATCH_RECORDS = 64;
+
+    // --- Record factories: one distinct, valid record per index ---
+    void makeId(char* out, const char* prefix, long n) {
+        std::snprintf(out, 21, "%s%ld", prefix, n);
+    }
+
+    template <typename T> T makeRecord(long n);
+
+    template <> Vessel::VesselEntity makeRecord(long n) {
+        Vessel::VesselEntity r = {};
+        makeId(r.vesselID, "V", n);
+        r.LCLL = 3600.0;
+        r.HCLL = 3600.0;
+        return r;
+    }
+    template <> Sailing::SailingEntity makeRecord(long n) {
+        Sailing::SailingEntity r = {};
+        makeId(r.sailingID, "S", n);
+        makeId(r.vesselID, "V", n % 100);
+        r.LRL = 3600.0;
+        r.HRL = 3600.0;
+        return r;
+    }
+    template <> Vehicle::VehicleEntity makeRecord(long n) {
+        Vehicle::VehicleEntity r = {};
+        makeId(r.plate, "P", n);
+        std::strcpy(r.phone, "6045550100");
+        r.length = 5.0;
+        r.height = 1.8;
+        return r;
+    }
+    template <> Reservation::ReservationEntity makeRecord(long n) {
+        Reservation::ReservationEntity r = {};
+        r.sailingKey = static_cast<IdDictionary::Key>(n % 1000 + 1);
+        r.plateKey = static_cast<IdDictionary::Key>(n + 1001);
+        r.checkedIn = false;
+        return r;
+    }
+
+    // Writes `count` records in one bulk pass so large files build quickly.
+    template <typename T>
+    void buildFile(long count) {
+        std::ofstream file(Utility::getFilePath<T>(), std::ios::binary | std::ios::trunc);
+        Utility::FileHeader header = Utility::makeFileHeader<T>();
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        std::vector<T> chunk;
+        chunk.reserve(4096);
+        for (long i = 0; i < count; i++) {
+            chunk.push_back(makeRecord<T>(i));
+            if (chunk.size() == chunk.capacity() || i == count - 1) {
+                file.write(reinterpret_cast<const char*>(chunk.data()),
+                           static_cast<std::streamsize>(chunk.size() * sizeof(T)));
+                chunk.clear();
+            }
+        }
+    }
+
+    // Flushes the file and asks the kernel to drop its cached pages.
+    template <typename T>
+    void evictFromCache() {
+#if BENCH_HAS_FADVISE
+        int fd = ::open(Utility::getFilePath<T>(), O_RDONLY);
+        if (fd < 0) return;
+        ::fdatasync(fd);
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        ::close(fd);
+#endif
+    }
+
+    struct Series {
+        std::string entity;
+        long records;
+        bool cold;
+        std::string op;
+        std::vector<long long> ns;
+        long perSample = 1; // Records covered by one sample (scans)
+    };
+
+    std::vector<Series> allSeries;
+
+    template <typename Fn>
+    long long timeOnce(Fn&& fn) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    template <typename T>
+    void benchEntity(const char* name, const Config& config, std::mt19937_64& rng) {
+        for (long size : config.sizes) {
+            for (int pass = 0; pass < (BENCH_HAS_FADVISE ? 2 : 1); pass++) {
+                bool cold = pass == 1;
+                buildFile<T>(size);
+                std::uniform_int_distribution<long> pickPosition(0, size - 1);
+                auto prepare = [&] { if (cold) evictFromCache<T>(); };
+
+                Series read{ name, size, cold, "readRecord", {} };
+                for (int i = 0; i < config.samples; i++) {
+                    int position = static_cast<int>(pickPosition(rng));
+                    prepare();
+                    read.ns.push_back(timeOnce([&] { Utility::readRecord<T>(position); }));
+                }
+
+                // Random positions fetched in one call; reported per record.
+                Series batch{ name, size, cold, "readRecords", {} };
+                batch.perSample = std::min<long>(size, BATCH_RECORDS);
+                std::vector<int> positions(static_cast<size_t>(batch.perSample));
+                std::vector<T> records(positions.size());
+                for (int i = 0; i < config.samples; i++) {
+                    for (int& position : positions) position = static_cast<int>(pickPosition(rng));
+                    prepare();
+                    batch.ns.push_back(timeOnce([&] {
+                        Utility::readRecords<T>(positions.data(), positions.size(), records.data());
+                    }));
+                }
+
+                // The same number of random reads, all submitted before any
+                // completes; the sample ends when the last one has.
+                Series async{ name, size, cold, "readRecordAsync", {} };
+                async.perSample = batch.perSample;
+                for (int i = 0; i < config.samples; i++) {
+                    for (int& position : positions) position = static_cast<int>(pickPosition(rng));
+                    prepare();
+                    async.ns.push_back(timeOnce([&] {
+                        for (size_t k = 0; k < positions.size(); k++) {
+                            Utility::readRecordAsync<T>(positions[k], [&records, k](std::optional<T> record) {
+                                if (record) records[k] = *record;
+                            });
+                        }
+                        AsyncIo::drain();
+                    }));
+                }
+
+                Series update{ name, size, cold, "updateRecord", {} };
+                for (int i = 0; i < config.samples; i++) {
+                    int position = static_cast<int>(pickPosition(rng));
+                    T record = makeRecord<T>(position);
+                    prepare();
+                    update.ns.push_back(timeOnce([&] { Utility::updateRecord<T>(position, record); }));
+                }
+
+                // Each delete is followed by an untimed append so the file
+                // size stays at `size` for the whole series.
+                Series create{ name, size, cold, "createRecord", {} };
+                Series erase{ name, size, cold, "deleteRecord", {} };
+                for (int i = 0; i < config.samples; i++) {
+                    int position = static_cast<int>(pickPosition(rng));
+                    prepare();
+                    erase.ns.push_back(timeOnce([&] { Utility::deleteRecord<T>(position); }));
+                    T record = makeRecord<T>(size + i);
+                    prepare();
+                    create.ns.push_back(timeOnce([&] { Utility::createRecord<T>(record); }));
+                }
+
+                Series scan{ name, size, cold, "scan", {} };
+                scan.perSample = std::min(size, config.scanLimit);
+                for (int i = 0; i < std::max(1, config.samples / 50); i++) {
+                    prepare();
+                    scan.ns.push_back(timeOnce([&] {
+                        for (int position = 0; position < scan.perSample; position++) {
+                            if (!Utility::readRecord<T>(position).has_value()) break;
+                        }
+                    }));
+                }
+
+                allSeries.push_back(read);
+                allSeries.push_back(batch);
+                allSeries.push_back(async);
+                allSeries.push_back(update);
+                allSeries.push_back(create);
+                allSeries.push_back(erase);
+                allSeries.push_back(scan);
+                std::cerr << name << " records=" << size << (cold ? " cold" : " warm") << " done" << std::endl;
+            }
+            std::filesystem::remove(Utility::getFilePath<T>());
+        }
+    }
+
+    long long percentile(const std::vector<long long>& sorted, double p) {
+        size_t index = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+        return sorted[std::min(index, sorted.size() - 1)];
+    }
+
+    void printJson(const Config& config, AsyncIo::Backend asyncBackend) {
+        std::ostringstream json;
+        json << "{\n  \"benchmark\": \"utility-crud\",\n"
+             << "  \"seed\": " << config.seed << ",\n"
+             << "  \"samples\": " << config.samples << ",\n"
+             << "  \"coldSupported\": " << (BENCH_HAS_FADVISE ? "true" : "false") << ",\n"
+             << "  \"asyncBackend\": \"" << AsyncIo::backendName(asyncBackend) << "\",\n"
+             << "  \"results\": [\n";
+        for (size_t i = 0; i < allSeries.size(); i++) {
+            Series& s = allSeries[i];
+            std::vector<long long> sorted = s.ns;
+            std::sort(sorted.begin(), sorted.end());
+            long double total = 0;
+            for (long long v : sorted) total += v;
+            double perRecord = static_cast<double>(total / sorted.size() / s.perSample);
+            json << "    {\"entity\": \"" << s.entity << "\", \"records\": " << s.records
+                 << ", \"cache\": \"" << (s.cold ? "cold" : "warm") << "\", \"op\": \"" << s.op
+                 << "\", \"samples\": " << sorted.size()
+                 << ", \"recordsPerSample\": " << s.perSample
+                 << ", \"meanNsPerRecord\": " << static_cast<long long>(perRecord)
+                 << ", \"p50Ns\": " << percentile(sorted, 0.50)
+                 << ", \"p99Ns\": " << percentile(sorted, 0.99)
+                 << ", \"maxNs\": " << sorted.back() << "}"
+                 << (i + 1 < allSeries.size() ? ",\n" : "\n");
+        }
+        json << "  ]\n}\n";
+        std::cout << json.str();
+    }
+
+    // Makes a scratch directory under the current one and moves into it.
+    // Returns its absolute path, or an empty string if it could not.
+    std::string enterScratchDirectory() {
+        char name[] = "bench-utility-XXXXXX";
+        if (::mkdtemp(name) == nullptr) return "";
+        std::error_code ec;
+        std::filesystem::path path = std::filesystem::absolute(name, ec);
+        if (!ec) std::filesystem::current_path(path, ec);
+        if (ec) {
+            std::filesystem::remove(name, ec);
+            return "";
+        }
+        return path.string();
+    }
+
+    bool parseArgs(int argc, char* argv[], Config& config) {
+        if (argc % 2 == 0) return false;
+        for (int i = 1; i + 1 < argc; i += 2) {
+            std::string flag = argv[i];
+            std::string value = argv[i + 1];
+            if (flag == "--sizes") {
+                config.sizes.clear();
+                std::stringstream ss(value);
+                std::string item;
+                while (std::getline(ss, item, ',')) {
+                    long size = std::atol(item.c_str());
+                    if (size < 1) return false;
+                    config.sizes.push_back(size);
+                }
+            } else if (flag == "--samples") {
+                config.samples = std::atoi(value.c_str());
+            } else if (flag == "--scan-limit") {
+                config.scanLimit = std::atol(value.c_str());
+            } else if (flag == "--seed") {
+                config.seed = std::strtoull(value.c_str(), nullptr, 10);
+            } else if (flag == "--async-backend" && (value == "io_uring" || value == "pool")) {
+                config.asyncBackend = value == "pool" ? AsyncIo::Backend::ThreadPool : AsyncIo::Backend::IoUring;
+            } else {
+                return false;
+            }
+        }
+        return !config.sizes.empty() && config.samples > 0 && config.scanLimit > 0;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    Config config;
+    if (!parseArgs(argc, argv, config)) {
+        std::cerr << "usage: run_bench_utility [--sizes 1000,10000,...] [--samples N]"
+                  << " [--scan-limit N] [--seed N] [--async-backend io_uring|pool]" << std::endl;
+        return 1;
+    }
+
+    std::filesystem::path original = std::filesystem::current_path();
+    std::string scratch = enterScratchDirectory();
+    if (scratch.empty()) {
+        std::cerr << "ERROR: Could not make a scratch directory in " << original << std::endl;
+        return 1;
+    }
+
+    // Progress and module messages go to stderr; stdout carries only JSON.
+    std::streambuf* jsonBuffer = std::cout.rdbuf();
+    std::cout.rdbuf(std::cerr.rdbuf());
+    Utility::init();
+    AsyncIo::Backend asyncBackend = AsyncIo::init(config.asyncBackend, BATCH_RECORDS);
+
+    std::mt19937_64 rng(config.seed);
+    benchEntity<Vessel::VesselEntity>("Vessel", config, rng);
+    benchEntity<Sailing::SailingEntity>("Sailing", config, rng);
+    benchEntity<Vehicle::VehicleEntity>("Vehicle", config, rng);
+    benchEntity<Reservation::ReservationEntity>("Reservation", config, rng);
+
+    AsyncIo::shutdown();
+    Utility::shutdown();
+    std::filesystem::current_path(original);
+    std::filesystem::remove_all(scratch);
+    std::cout.rdbuf(jsonBuffer);
+    printJson(config, asyncBackend);
+    return 0;
+}
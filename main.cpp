@@ -6,24 +6,98 @@
 //     - Initial implementation
 //   Rev 1.1 2025-07-08 
 //     - Fixed function names, remove printer::shutdown()
+//   Rev 1.2 2025-08-02
+//     - Added --batch scripted command mode
+//   Rev 1.3 2025-08-07
+//     - Added --metrics-file / --metrics-interval Prometheus export
+//   Rev 1.4 2025-08-16
+//     - Module start-up left to Controller::init (loads in parallel)
+//   Rev 1.5 2025-08-23
+//     - Added --report read-only reporting process
+//   Rev 1.6 2025-08-24
+//     - Added --changes / --changes-socket change feed consumers
 // *)
 //*******************************
 
 #include <iostream>
+#include <fstream>
 #include <string>
+#include <cstdlib>
 #include "UserInterface.h"
+#include "BatchInterface.h"
+#include "MetricsExporter.h"
 #include "Vessel.h"
 #include "Sailing.h"
 #include "Reservation.h"
 #include "Vehicle.h"
 #include "Controller.h"
+#include "ReportReplica.h"
+#include "ChangeFeed.h"
 
 // Function prototypes
 void initializeSystem();
 void shutdownSystem();
+int runBatch(const char* scriptPath);
+int runReports(const char* scriptPath);
+int runChanges(unsigned long long after, const char* socketPath);
+
+// Prometheus textfile export, disabled unless --metrics-file is given.
+std::string metricsFile;
+int metricsIntervalSeconds = 15;
+
+// Usage:
+//   ferry [options]                 interactive menus
+//   ferry --batch [script] [options] scripted mode, commands from file or stdin
+//   ferry --report [script]         reporting process: query/report commands
+//                                   served from a read-only mapping of the data,
+//                                   alongside a booking process
+//   ferry --changes [after]         print the change feed from sequence `after` on,
+//                                   following it as changes are made
+//   ferry --changes-socket <path>   serve the change feed on a Unix domain socket
+// Options:
+//   --metrics-file <path>           periodically export metrics in Prometheus text format
+//   --metrics-interval <seconds>    export period (default 15)
+int main(int argc, char* argv[]) {
+    bool batchMode = false;
+    bool reportMode = false;
+    bool changesMode = false;
+    unsigned long long changesAfter = 0;
+    const char* changesSocket = nullptr;
+    const char* scriptPath = nullptr;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--batch" || arg == "--report") {
+            (arg == "--batch" ? batchMode : reportMode) = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') scriptPath = argv[++i];
+        } else if (arg == "--changes") {
+            changesMode = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') changesAfter = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--changes-socket" && i + 1 < argc) {
+            changesMode = true;
+            changesSocket = argv[++i];
+        } else if (arg == "--metrics-file" && i + 1 < argc) {
+            metricsFile = argv[++i];
+        } else if (arg == "--metrics-interval" && i + 1 < argc) {
+            metricsIntervalSeconds = std::atoi(argv[++i]);
+        } else {
+            std::cerr << "usage: " << argv[0] << " [--batch [script] | --report [script]] [--metrics-file <path>]"
+                      << " [--metrics-interval <seconds>]" << std::endl
+                      << "       " << argv[0] << " --changes [after] | --changes-socket <path>" << std::endl;
+            return 1;
+        }
+    }
 
-int main() {
     try {
+        if (changesMode) {
+            return runChanges(changesAfter, changesSocket);
+        }
+        if (reportMode) {
+            return runReports(scriptPath);
+        }
+        if (batchMode) {
+            return runBatch(scriptPath);
+        }
+
         // System initialization
         initializeSystem();
         
@@ -41,22 +115,89 @@ int main() {
     }
 }
 
+// Runs the scripted command mode. Module start-up/shutdown messages are
+// routed to stderr so stdout only carries machine-readable result lines.
+// Returns 0 if every command succeeded, 2 otherwise.
+int runBatch(const char* scriptPath) {
+    std::streambuf* resultBuffer = std::cout.rdbuf();
+    std::ostream results(resultBuffer);
+    std::cout.rdbuf(std::clog.rdbuf());
+
+    std::ifstream scriptFile;
+    if (scriptPath != nullptr) {
+        scriptFile.open(scriptPath);
+        if (!scriptFile) {
+            std::cout.rdbuf(resultBuffer);
+            std::cerr << "ERROR: Could not open script file: " << scriptPath << std::endl;
+            return 1;
+        }
+    }
+
+    initializeSystem();
+    int failures = BatchInterface::run(scriptPath != nullptr ? scriptFile : std::cin, results);
+    shutdownSystem();
+
+    std::cout.rdbuf(resultBuffer);
+    return failures == 0 ? 0 : 2;
+}
+
+// Runs a reporting process. Nothing is loaded and no module is started:
+// every command is answered from the read-only replica, so this process
+// never takes a lock a booking needs. Returns as runBatch() does.
+int runReports(const char* scriptPath) {
+    std::ifstream scriptFile;
+    if (scriptPath != nullptr) {
+        scriptFile.open(scriptPath);
+        if (!scriptFile) {
+            std::cerr << "ERROR: Could not open script file: " << scriptPath << std::endl;
+            return 1;
+        }
+    }
+
+    std::string error;
+    if (!ReportReplica::open(error)) {
+        std::cerr << "ERROR: " << error << std::endl;
+        return 1;
+    }
+    int failures = BatchInterface::runReports(scriptPath != nullptr ? scriptFile : std::cin, std::cout);
+    ReportReplica::close();
+    return failures == 0 ? 0 : 2;
+}
+
+// Follows the change feed, on stdout or for socket clients. Like the
+// reporting process this starts no module and only reads the log.
+// Returns only on an error (or when stdout is closed).
+int runChanges(unsigned long long after, const char* socketPath) {
+    if (socketPath != nullptr) {
+        std::string error;
+        ChangeFeed::serve(socketPath, error);
+        std::cerr << "ERROR: " << error << std::endl;
+        return 1;
+    }
+    ChangeFeed::follow(after, [](const std::string& lines) {
+        std::cout << lines << std::flush;
+        return static_cast<bool>(std::cout);
+    });
+    return 0;
+}
+
 void initializeSystem() {
     std::cout << "Initializing system." << std::endl;
     
     // Initialize all persistent data files
-    Vessel::init();
-    Sailing::init();
-    Reservation::init();
-    Vehicle::init();
     Controller::init();
-    
+
+    if (!metricsFile.empty()) {
+        MetricsExporter::start(metricsFile, metricsIntervalSeconds);
+    }
     
     std::cout << "System initialization complete." << std::endl;
 }
 
 void shutdownSystem() {
     std::cout << "Shutting down system." << std::endl;
+
+    MetricsExporter::stop();
     
     // Close all data files
     Vehicle::shutdown();
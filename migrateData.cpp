@@ -0,0 +1,151 @@
+// migrateData.cpp
+//******************************************************************
+// MAINTENANCE TOOL: Data File Schema Migration
+//
+// PURPOSE:          Converts every data file under Data/ from schema 1
+//                   (packed records, no header) to schema 2 (FileHeader +
+//                   naturally aligned records), one file at a time. Each
+//                   file is streamed through a fixed-size chunk into a
+//                   temporary file that is fsync'ed and renamed over the
+//                   original, so memory use does not grow with the file
+//                   and an interrupted run can simply be started again.
+//
+//                   The ferry application reads and writes both schemas,
+//                   so terminals can be migrated one at a time, except
+//                   for Reservations.dat: its schema 1 records (those of
+//                   the original release) hold ID strings, which are
+//                   interned into Ids.dat as they are converted, and the
+//                   application will not start until that is done. A
+//                   file that is not a whole number of records is
+//                   reported and left alone. Run the tool while the
+//                   application is stopped.
+//
+// USAGE:            run_migrate_data [--check] [--chunk N]
+//
+//                   --check   report each file's schema without changing
+//                             anything; exits 2 if any file still needs
+//                             migrating
+//                   --chunk   records converted per read/write (default
+//                             65536)
+//
+// HOW TO COMPILE:
+// g++ -std=c++17 -O2 migrateData.cpp Utility.cpp LegacySchema.cpp IdDictionary.cpp AsyncIo.cpp ThreadPool.cpp -pthread -o run_migrate_data
+//
+// (* Revision History:
+//   Rev. 1.1 - 2025/08/25 - Reservations are converted from the original
+//                           release's layout; partial files are refused
+//   Rev. 1.0 - 2025/08/18 - Initial version
+// *)
+//******************************************************************
+
+#include "Utility.h"
+#include "Vessel.h"
+#include "Sailing.h"
+#include "Vehicle.h"
+#include "Reservation.h"
+#include "Waitlist.h"
+#include "IdDictionary.h"
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace {
+
+    struct Options {
+        bool check = false;
+        size_t chunkRecords = Utility::LOAD_CHUNK_RECORDS;
+    };
+
+    struct Totals {
+        int pending = 0;    // Files still in schema 1 (--check)
+        int failed = 0;
+    };
+
+    bool parseArgs(int argc, char* argv[], Options& options) {
+        for (int i = 1; i < argc; i++) {
+            std::string flag = argv[i];
+            if (flag == "--check") {
+                options.check = true;
+            } else if (flag == "--chunk" && i + 1 < argc) {
+                long chunk = std::atol(argv[++i]);
+                if (chunk < 1) return false;
+                options.chunkRecords = static_cast<size_t>(chunk);
+            } else {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    template <typename T>
+    void checkFile(Totals& totals) {
+        std::string path = Utility::getFilePath<T>();
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            std::cout << path << ": missing" << std::endl;
+            return;
+        }
+        Utility::IoCounters io;
+        Utility::FileLayout layout = Utility::readLayout<T>(file, io);
+        std::cout << path << ": schema " << layout.schemaVersion << ", " << layout.records() << " records";
+        if (!layout.current() && (layout.fileBytes - layout.dataOffset) % layout.recordSize != 0) {
+            std::cout << " and a partial one (not this build's layout)";
+            totals.failed++;
+        } else if (!layout.current()) {
+            std::cout << " (needs migration)";
+            totals.pending++;
+        }
+        std::cout << std::endl;
+    }
+
+    template <typename T>
+    void migrate(const Options& options, Totals& totals) {
+        std::string path = Utility::getFilePath<T>();
+        Utility::MigrationResult result;
+        try {
+            result = Utility::migrateFile<T>(options.chunkRecords);
+        } catch (const std::exception& e) {
+            result.error = e.what();
+        }
+        if (!result.error.empty()) {
+            std::cout << path << ": FAILED: " << result.error << std::endl;
+            totals.failed++;
+        } else if (result.fromVersion == 0) {
+            std::cout << path << ": missing" << std::endl;
+        } else if (!result.migrated) {
+            std::cout << path << ": already schema " << Utility::SCHEMA_VERSION << std::endl;
+        } else {
+            std::cout << path << ": schema " << result.fromVersion << " -> " << Utility::SCHEMA_VERSION
+                      << ", " << result.records << " records" << std::endl;
+        }
+    }
+
+    template <typename... T>
+    void forEachEntity(const Options& options, Totals& totals) {
+        if (options.check) {
+            (checkFile<T>(totals), ...);
+        } else {
+            (migrate<T>(options, totals), ...);
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseArgs(argc, argv, options)) {
+        std::cerr << "usage: run_migrate_data [--check] [--chunk N]" << std::endl;
+        return 1;
+    }
+
+    Totals totals;
+    // Converting reservations interns their IDs, so the dictionary is
+    // converted and loaded first.
+    forEachEntity<IdDictionary::IdEntity>(options, totals);
+    if (totals.failed > 0) return 1;
+    if (!options.check) IdDictionary::init();
+    forEachEntity<Vessel::VesselEntity, Sailing::SailingEntity, Vehicle::VehicleEntity,
+                  Reservation::ReservationEntity, Waitlist::WaitlistEntity>(options, totals);
+
+    if (totals.failed > 0) return 1;
+    return totals.pending > 0 ? 2 : 0;
+}
@@ -9,7 +9,9 @@
 // MODULE TESTED:    Controller (.h/.cpp)
 // DEPENDENCIES:     Vessel (.h/.cpp) for vessel validation, and Utility (.h/.cpp)
 // FUNCTIONS TESTED: Controller::createNewVessel(), Controller::createNewSailing(),
-//                   Controller::queryIndividualSailing(), Controller::deleteSailing()
+//                   Controller::queryIndividualSailing(), Controller::deleteSailing(),
+//                   Controller::getTopSailingsByCapacity(), Controller::getLaneOccupancy(),
+//                   Controller::joinWaitlist(), Controller::checkInVehicle()
 //
 // TEST STRATEGY:    This is a bottom-up, glass-box test that verifies the
 //                   Controller module's persistence logic by:
@@ -20,18 +22,51 @@
 //                  5. Validating rejection of invalid operations (e.g., overcapacity reservations)
 //                  6. Confirming data integrity through persistent storage operations
 // HOW TO COMPILE:
-// g++ -std=c++17 -Wall testControllerLogic.cpp Controller.cpp Reservation.cpp Sailing.cpp Vessel.cpp Utility.cpp Vehicle.cpp -o run_testControllerLogic
+// g++ -std=c++17 -Wall testControllerLogic.cpp Controller.cpp Reservation.cpp Sailing.cpp Vessel.cpp Utility.cpp Vehicle.cpp Metrics.cpp CapacityIndex.cpp LaneAllocator.cpp Waitlist.cpp BloomFilter.cpp Checkpoint.cpp ThreadPool.cpp IdDictionary.cpp LegacySchema.cpp ChangeFeed.cpp AsyncIo.cpp -pthread -o run_testControllerLogic
 //
 // (* Revision History:
 //   Rev. 1.0 - 2025/07/23 - Written by Person B for A4
+//   Rev. 1.1 - 2025/08/08 - Added getTopSailingsByCapacity() case
+//   Rev. 1.2 - 2025/08/12 - Added lane packing case
+//   Rev. 1.3 - 2025/08/19 - deleteSailing() also removes the sailing's reservations;
+//                          counting allocator checks warm lookups never allocate
+//   Rev. 1.4 - 2025/08/24 - Added change feed case
+//   Rev. 1.5 - 2025/08/25 - Added waitlist promotion case; cancelling on the
+//                          wrong sailing changes nothing
+//   Rev. 1.6 - 2025/08/25 - Added second process case
 // *)
 //******************************************************************
 
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
+#include <new>
 #include <string>
 #include <vector>
 #include "Controller.h"
+#include "ChangeFeed.h"
+#include "IdDictionary.h"
+#include "Utility.h"
 #include <filesystem>
+#include <set>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Counts every heap allocation made by the program, so a test can check
+// that a code path makes none.
+static std::atomic<size_t> allocations{ 0 };
+
+void* operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* block = std::malloc(size ? size : 1)) return block;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size) { return operator new(size); }
+void operator delete(void* block) noexcept { std::free(block); }
+void operator delete[](void* block) noexcept { std::free(block); }
+void operator delete(void* block, std::size_t) noexcept { std::free(block); }
+void operator delete[](void* block, std::size_t) noexcept { std::free(block); }
 
 // Helper to report test results and track overall status
 bool check(bool condition, const std::string& testName) {
@@ -132,6 +167,11 @@ int main() {
 
     // --- TEST CASE 14: testCancelReservation ---
     std::cout << "\n[TEST CASE 14] Testing cancelReservation()..." << std::endl;
+    double lrlBefore = Controller::getSailing(sailingID)->LRL;
+    Controller::cancelReservation(sailingID, newVehiclePlate); // Booked on newSailingID
+    allTestsPassed &= check(Controller::checkReservationExists(newVehiclePlate) &&
+                            Controller::getSailing(sailingID)->LRL == lrlBefore,
+                            "cancelReservation() on another sailing changes nothing");
     Controller::cancelReservation(newSailingID, newVehiclePlate);
     allTestsPassed &= check(!Controller::checkReservationExists(newVehiclePlate), "cancelReservation() test passed");
 
@@ -145,6 +185,7 @@ int main() {
     std::cout << "\n[TEST CASE 16] Testing deleteSailing()..." << std::endl;
     Controller::deleteSailing(sailingID);
     allTestsPassed &= check(!Controller::checkSailingExists(sailingID), "deleteSailing() test passed");
+    allTestsPassed &= check(!Controller::checkReservationExists(vehiclePlate), "deleteSailing() removes its reservations");
 
     // --- TEST CASE 17: testGetSailingReport ---
     std::cout << "\n[TEST CASE 17] Testing getSailingReport()..." << std::endl;
@@ -157,8 +198,164 @@ int main() {
     Controller::createNewSailing(vesselID, sailingID);
     allTestsPassed &= check(true, "queryIndividualSailing() test passed");
 
-    // --- TEST CASE 19: testShutdown ---
-    std::cout << "\n[TEST CASE 19] Testing shutdown()..." << std::endl;
+    // --- TEST CASE 19: testGetTopSailingsByCapacity ---
+    std::cout << "\n[TEST CASE 19] Testing getTopSailingsByCapacity()..." << std::endl;
+    // TestSailing (fresh, LRL 10.0) must outrank NewTestSailing once it holds a booking.
+    Controller::createNewReservation(newSailingID, anotherVehiclePlate);
+    auto top = Controller::getTopSailingsByCapacity(CapacityIndex::Lane::Low, 1, "");
+    allTestsPassed &= check(top.size() == 1 && sailingID == top[0].sailingID, "getTopSailingsByCapacity() ranks by remaining LRL");
+    auto vesselTop = Controller::getTopSailingsByCapacity(CapacityIndex::Lane::Low, 5, newVesselID);
+    allTestsPassed &= check(vesselTop.size() == 1 && newSailingID == vesselTop[0].sailingID, "getTopSailingsByCapacity() filters by vessel");
+
+    // --- TEST CASE 20: testLanePacking ---
+    std::cout << "\n[TEST CASE 20] Testing lane packing in createNewReservation()..." << std::endl;
+    // HCLL 200 gives two 100m high-deck lanes. After 30/30/50 best-fit leaves
+    // gaps of 40 and 50, so a 60m vehicle only fits once the deck is repacked.
+    Controller::createNewVessel("LaneVessel", 10.0, 200.0);
+    Controller::createNewSailing("LaneVessel", "LaneSailing");
+    const double lengths[] = { 29.5, 29.5, 49.5, 59.5, 29.5 };
+    bool booked[5];
+    for (int i = 0; i < 5; i++) {
+        std::string plate = "LanePlate" + std::to_string(i);
+        Controller::createNewVehicle(plate, "1234567890", lengths[i], 3.0);
+        booked[i] = Controller::createNewReservation("LaneSailing", plate);
+    }
+    allTestsPassed &= check(booked[0] && booked[1] && booked[2] && booked[3], "createNewReservation() repacks a fragmented deck");
+    allTestsPassed &= check(!booked[4] && !Controller::checkReservationExists("LanePlate4"), "createNewReservation() rejects a vehicle no lane can hold");
+    double usedHigh = 0.0;
+    for (const auto& lane : Controller::getLaneOccupancy("LaneSailing")) {
+        if (lane.deck == LaneAllocator::Deck::High) usedHigh += lane.used;
+    }
+    allTestsPassed &= check(usedHigh == 170.0 && Controller::getSailing("LaneSailing")->HRL == 30.0, "getLaneOccupancy() matches the pooled HRL");
+
+    // --- TEST CASE 21: testAllocationFreeLookups ---
+    std::cout << "\n[TEST CASE 21] Testing that warm lookups make no heap allocation..." << std::endl;
+    const std::string longPlate = "LongTestPlate123456"; // Too long for the small-string buffer
+    Controller::createNewVehicle(longPlate, "1234567890", 5.0, 1.5);
+    Controller::createNewReservation("LaneSailing", longPlate);
+    auto lookups = [&longPlate] {
+        return Controller::checkVesselExists("LaneVessel") && Controller::checkSailingExists("LaneSailing") &&
+               Controller::checkVehicleExists(longPlate) && Controller::checkReservationExists(longPlate) &&
+               Controller::getVessel("LaneVessel").has_value() && Controller::getSailing("LaneSailing").has_value() &&
+               Controller::getVehicle(longPlate).has_value() && Controller::getReservation(longPlate).has_value() &&
+               !Controller::checkVehicleExists("NoSuchPlate") && !Controller::checkReservationExists("NoSuchPlate");
+    };
+    lookups(); // Warm up: loads the indexes and this thread's histograms
+    size_t allocationsBefore = allocations.load();
+    bool allFound = lookups();
+    size_t allocationsMade = allocations.load() - allocationsBefore;
+    allTestsPassed &= check(allFound && allocationsMade == 0,
+                            "Warm lookups made " + std::to_string(allocationsMade) + " heap allocations");
+
+    // --- TEST CASE 22: testChangeFeed ---
+    std::cout << "\n[TEST CASE 22] Testing the change feed..." << std::endl;
+    // Skip what earlier cases recorded, then expect exactly the new changes.
+    ChangeFeed::Cursor cursor;
+    std::vector<ChangeFeed::Entry> entries;
+    while (cursor.read(entries, 4096) > 0) entries.clear();
+    uint64_t resumeFrom = cursor.position();
+    Controller::createNewVessel("FeedVessel", 10.0, 20.0);
+    Controller::createNewSailing("FeedVessel", "FeedSailing");
+    Controller::deleteSailing("FeedSailing");
+    cursor.read(entries, 4096);
+    std::vector<std::string> seen;
+    for (const auto& entry : entries) seen.push_back(ChangeFeed::describe(entry));
+    auto has = [&seen](const std::string& fields) {
+        for (const auto& line : seen) {
+            if (line.find(fields) != std::string::npos) return true;
+        }
+        return false;
+    };
+    allTestsPassed &= check(has("Vessels.dat\tcreate") && has("Sailings.dat\tcreate") &&
+                            has("Sailings.dat\tdelete") && has("FeedSailing\tFeedVessel"),
+                            "The feed records each create and delete with the record");
+    ChangeFeed::Cursor resumed(resumeFrom);
+    std::vector<ChangeFeed::Entry> again;
+    allTestsPassed &= check(!entries.empty() && entries.front().sequence == resumeFrom + 1 &&
+                            resumed.read(again, 4096) == entries.size() &&
+                            again.back().sequence == entries.back().sequence,
+                            "A cursor resumes after the sequence it was given");
+
+    // --- TEST CASE 23: testWaitlistPromotion ---
+    std::cout << "\n[TEST CASE 23] Testing waitlist promotion on cancelReservation()..." << std::endl;
+    // One 10m low-deck lane, full at 6 + 4. Freeing 4m cannot take the 5m
+    // vehicle at the head of the queue, but must go to the 3m one behind it.
+    Controller::createNewVessel("WaitVessel", 10.0, 1.0);
+    Controller::createNewSailing("WaitVessel", "WaitSailing");
+    const char* waitPlates[] = { "WaitBooked6", "WaitBooked4", "WaitBig5", "WaitSmall3" };
+    const double waitLengths[] = { 5.5, 3.5, 4.5, 2.5 };
+    for (int i = 0; i < 4; i++) Controller::createNewVehicle(waitPlates[i], "1234567890", waitLengths[i], 1.5);
+    Controller::createNewReservation("WaitSailing", waitPlates[0]);
+    Controller::createNewReservation("WaitSailing", waitPlates[1]);
+    Controller::joinWaitlist("WaitSailing", waitPlates[2]);
+    Controller::joinWaitlist("WaitSailing", waitPlates[3]);
+    auto promoted = Controller::cancelReservation("WaitSailing", waitPlates[1]);
+    allTestsPassed &= check(promoted.size() == 1 && promoted[0] == waitPlates[3] &&
+                            Controller::checkReservationExists(waitPlates[3]) &&
+                            Controller::getWaitlistEntry(waitPlates[2]).has_value(),
+                            "Promotion passes over a waiting vehicle that does not fit");
+
+    // --- TEST CASE 24: testSecondProcess ---
+    std::cout << "\n[TEST CASE 24] Testing changes made by a second process..." << std::endl;
+    // Both processes have the sailing cached. The child frees a spot and
+    // books it; the parent must see that, and must not hand out an ID or a
+    // lane the child already used.
+    Controller::createNewVessel("TwoVessel", 100.0, 50.0);
+    Controller::createNewSailing("TwoVessel", "TwoSailing");
+    const char* twoPlates[] = { "TwoFirst", "TwoSecond", "TwoChild", "TwoParent" };
+    for (const char* plate : twoPlates) Controller::createNewVehicle(plate, "1234567890", 4.0, 1.5);
+    Controller::createNewReservation("TwoSailing", "TwoFirst");
+    Controller::createNewReservation("TwoSailing", "TwoSecond");
+    Controller::checkReservationExists("TwoFirst");
+    std::cout.flush();
+    fflush(nullptr);
+    pid_t child = fork();
+    if (child == 0) {
+        Controller::cancelReservation("TwoSailing", "TwoFirst");
+        bool childBooked = Controller::createNewReservation("TwoSailing", "TwoChild");
+        _exit(childBooked ? 0 : 1);
+    }
+    int childStatus = -1;
+    waitpid(child, &childStatus, 0);
+    allTestsPassed &= check(WIFEXITED(childStatus) && WEXITSTATUS(childStatus) == 0, "The second process made its changes");
+    allTestsPassed &= check(Controller::checkReservationExists("TwoChild") && !Controller::checkReservationExists("TwoFirst"),
+                            "This process sees the second process's changes");
+    Controller::checkInVehicle("TwoSecond");
+    bool parentBooked = Controller::createNewReservation("TwoSailing", "TwoParent");
+    size_t onBoard = 0;
+    for (const auto& lane : Controller::getLaneOccupancy("TwoSailing")) onBoard += lane.vehicles;
+    allTestsPassed &= check(parentBooked && onBoard == 3, "The lanes count the second process's booking");
+    // What is on disk, not what either process has cached.
+    std::vector<std::string> names;
+    std::set<std::string> distinct;
+    bool keysInOrder = true;
+    for (const auto& entry : Utility::readAllRecords<IdDictionary::IdEntity>()) {
+        keysInOrder &= entry.key == names.size() + 1;
+        names.push_back(entry.id);
+        distinct.insert(entry.id);
+    }
+    auto nameOf = [&names](IdDictionary::Key key) {
+        return key >= 1 && key <= names.size() ? names[key - 1] : std::string();
+    };
+    std::vector<std::string> onDisk;
+    bool secondCheckedIn = false;
+    for (const auto& entry : Utility::readAllRecords<Reservation::ReservationEntity>()) {
+        if (nameOf(entry.sailingKey) != "TwoSailing") continue;
+        onDisk.push_back(nameOf(entry.plateKey));
+        if (onDisk.back() == "TwoSecond") secondCheckedIn = entry.checkedIn;
+    }
+    auto stored = [&onDisk](const std::string& plate) {
+        for (const auto& name : onDisk) {
+            if (name == plate) return true;
+        }
+        return false;
+    };
+    allTestsPassed &= check(keysInOrder && distinct.size() == names.size(), "Both processes' IDs are stored once each, in key order");
+    allTestsPassed &= check(onDisk.size() == 3 && stored("TwoChild") && stored("TwoParent") && !stored("TwoFirst") && secondCheckedIn,
+                            "The data files hold both processes' changes");
+
+    // --- TEST CASE 25: testShutdown ---
+    std::cout << "\n[TEST CASE 25] Testing shutdown()..." << std::endl;
     Controller::shutdown();
     allTestsPassed &= check(true, "shutdown() test passed");
 
@@ -9,7 +9,8 @@
 // MODULE TESTED:    Sailing (.h/.cpp)
 // DEPENDENCIES:     Vessel (.h/.cpp) for vessel validation, and Utility (.h/.cpp)
 // FUNCTIONS TESTED: Sailing::createSailing(), Sailing::getSailing(),
-//                   Sailing::isValidSailing(), Sailing::deleteSailing()
+//                   Sailing::isValidSailing(), Sailing::deleteSailing(),
+//                   Sailing::openSnapshot(), Sailing::getSailings()
 //
 // TEST STRATEGY:    This is a bottom-up, glass-box test that verifies the
 //                   Sailing module's persistence logic by:
@@ -17,22 +18,39 @@
 //                   2. Writing two distinct Sailing records to a clean file.
 //                   3. Reading them back and programmatically verifying their content.
 //                   4. Deleting one record and confirming its removal.
-//                   5. Printing a final "Pass" or "Fail" summary.
+//                   5. Checking that a snapshot is unaffected by later writes.
+//                   6. Printing a final "Pass" or "Fail" summary.
 //
 // HOW TO COMPILE:
-// g++ -std=c++17 -Wall testFileOps.cpp Sailing.cpp Vessel.cpp Utility.cpp -o run_sailing_file_test
+// g++ -std=c++17 -Wall testFileOps.cpp Sailing.cpp Vessel.cpp Utility.cpp Metrics.cpp CapacityIndex.cpp LegacySchema.cpp IdDictionary.cpp AsyncIo.cpp ThreadPool.cpp ReportReplica.cpp -pthread -o run_sailing_file_test
 //
 // (* Revision History:
 //   Rev. 1.0 - 2025/07/23 - Written by Person B for A4
+//   Rev. 1.1 - 2025/08/10 - Added snapshot isolation case
+//   Rev. 1.2 - 2025/08/18 - Added schema 1 compatibility and migration case
+//   Rev. 1.3 - 2025/08/19 - Added batched readRecords() case
+//   Rev. 1.4 - 2025/08/20 - Added asynchronous update/read case
+//   Rev. 1.5 - 2025/08/21 - Added preallocation case
+//   Rev. 1.6 - 2025/08/23 - Added read-only replica case
+//   Rev. 1.7 - 2025/08/25 - Added schema 1 reservation and partial file cases
+//   Rev. 1.8 - 2025/08/25 - Added async lock wait case
+//   Rev. 1.9 - 2025/08/25 - Added batched update case
 // *)
 //******************************************************************
 
 #include "Sailing.h"   // The module we are testing
 #include "Vessel.h"    // A dependency for creating a sailing
 #include "Utility.h"   // A dependency for file I/O
+#include "AsyncIo.h"
+#include "ReportReplica.h"
+#include "Reservation.h"
+#include "IdDictionary.h"
 #include <iostream>
 #include <filesystem>
 #include <cstring>
+#include <fstream>
+#include <algorithm>
+#include <vector>
 
 // Helper to report test results and track overall status
 bool check(bool condition, const std::string& testName) {
@@ -98,6 +116,187 @@ int main() {
     auto record_at_pos1 = Utility::readRecord<Sailing::SailingEntity>(1);
     allTestsPassed &= check(!record_at_pos1.has_value(), "Reading at position 1 correctly fails after deletion");
 
+    // --- TEST CASE 5: SNAPSHOT ISOLATION ---
+    // A snapshot taken before a create/delete must keep returning the
+    // records as they were, while new reads see the change.
+    std::cout << "\n[TEST CASE 5] Verifying snapshot reads are isolated from later writes..." << std::endl;
+    Sailing::createSailing(vessel_id, sailing1_id);
+    auto snapshot = Sailing::openSnapshot();
+    Sailing::deleteSailing(sailing2_id);
+    auto pinned = Sailing::getSailings(snapshot, 0);
+    auto latest = Sailing::getSailings(0);
+    allTestsPassed &= check(pinned.size() == 2, "Snapshot still holds both records after a delete");
+    allTestsPassed &= check(latest.size() == 1 && strcmp(latest[0].sailingID, sailing1_id.c_str()) == 0,
+                            "Fresh read sees only the surviving record");
+
+    // --- TEST CASE 6: SCHEMA 1 FILES ---
+    // A headerless file of packed records (schema 1) must be readable and
+    // writable as is, and migrateFile() must convert it without loss.
+    std::cout << "\n[TEST CASE 6] Reading, writing and migrating a schema 1 file..." << std::endl;
+    {
+        LegacySchema::VesselRecord legacy = {};
+        strcpy(legacy.vesselID, "OLDBOAT");
+        legacy.LCLL = 300.0;
+        legacy.HCLL = 150.0;
+        std::ofstream file("Data/Vessels.dat", std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&legacy), sizeof(legacy));
+    }
+    Vessel::init(); // The file was replaced behind the module's index
+    auto old_vessel = Vessel::getVessel("OLDBOAT");
+    allTestsPassed &= check(old_vessel.has_value() && old_vessel->LCLL == 300.0 && old_vessel->HCLL == 150.0,
+                            "Schema 1 record is read through the aligned struct");
+    Vessel::createVessel("NEWBOAT", 500.0, 250.0);
+    allTestsPassed &= check(std::filesystem::file_size("Data/Vessels.dat") == 2 * sizeof(LegacySchema::VesselRecord),
+                            "Appending to a schema 1 file keeps it in schema 1");
+    auto migration = Utility::migrateFile<Vessel::VesselEntity>(1);
+    allTestsPassed &= check(migration.migrated && migration.fromVersion == 1 && migration.records == 2,
+                            "migrateFile() converts both records");
+    allTestsPassed &= check(std::filesystem::file_size("Data/Vessels.dat") ==
+                                sizeof(Utility::FileHeader) + 2 * sizeof(Vessel::VesselEntity),
+                            "Migrated file has the header and aligned records");
+    auto new_vessel = Vessel::getVessel("NEWBOAT");
+    allTestsPassed &= check(Vessel::getVessel("OLDBOAT").has_value() && new_vessel.has_value() &&
+                                new_vessel->HCLL == 250.0,
+                            "Both records read back after migration");
+    allTestsPassed &= check(!Utility::migrateFile<Vessel::VesselEntity>(1).migrated,
+                            "A second migration leaves the file alone");
+    // A schema 1 reservation holds ID strings, which migration interns;
+    // a file with a torn record is not in that layout and is refused.
+    {
+        LegacySchema::ReservationRecord legacy = {};
+        strcpy(legacy.sailingID, "YVR-01");
+        strcpy(legacy.vehiclePlate, "OLDPLATE");
+        legacy.checkedIn = true;
+        std::filesystem::remove("Data/Ids.dat");
+        std::ofstream file("Data/Reservations.dat", std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&legacy), sizeof(legacy));
+        file.write("torn", 4);
+    }
+    IdDictionary::init();
+    allTestsPassed &= check(!Utility::migrateFile<Reservation::ReservationEntity>(1).error.empty(),
+                            "migrateFile() refuses a file that is not a whole number of records");
+    std::filesystem::resize_file("Data/Reservations.dat", sizeof(LegacySchema::ReservationRecord));
+    auto converted = Utility::migrateFile<Reservation::ReservationEntity>(1);
+    auto reservations = Utility::readAllRecords<Reservation::ReservationEntity>();
+    allTestsPassed &= check(converted.migrated && reservations.size() == 1 &&
+                                IdDictionary::name(reservations[0].sailingKey) == "YVR-01" &&
+                                IdDictionary::name(reservations[0].plateKey) == "OLDPLATE" &&
+                                reservations[0].checkedIn && reservations[0].lane == Reservation::UNPLACED_LANE,
+                            "migrateFile() interns the IDs of a schema 1 reservation");
+
+    // --- TEST CASE 7: BATCHED READS ---
+    // readRecords() must fill each slot with its own position whatever
+    // the order, read a duplicate twice, and skip a position past the end.
+    std::cout << "\n[TEST CASE 7] Reading several records with one batched call..." << std::endl;
+    Sailing::createSailing("NEWBOAT", "TSA-02");
+    Sailing::createSailing("NEWBOAT", "TSA-03");
+    auto all = Utility::readAllRecords<Sailing::SailingEntity>();
+    const int positions[] = { 2, 0, 2, 99, 1 };
+    Sailing::SailingEntity batch[5] = {};
+    size_t filled = Utility::readRecords<Sailing::SailingEntity>(positions, 5, batch);
+    allTestsPassed &= check(all.size() == 3 && filled == 4, "readRecords() fills every slot with a valid position");
+    bool inPlace = all.size() == 3;
+    for (int slot : { 0, 1, 2, 4 }) {
+        inPlace = inPlace && strcmp(batch[slot].sailingID, all[static_cast<size_t>(positions[slot])].sailingID) == 0;
+    }
+    allTestsPassed &= check(inPlace, "Each slot holds the record at its own position");
+
+    // --- TEST CASE 8: ASYNCHRONOUS I/O ---
+    // An async update whose continuation reads the record back, under
+    // each backend, and a read that has to wait for a pending update's
+    // lock. The pool is always available; io_uring may not be.
+    std::cout << "\n[TEST CASE 8] Chaining an async update and read-back..." << std::endl;
+    for (AsyncIo::Backend wanted : { AsyncIo::Backend::IoUring, AsyncIo::Backend::ThreadPool }) {
+        AsyncIo::Backend running = AsyncIo::init(wanted, 2);
+        std::cout << "  Backend: " << AsyncIo::backendName(running) << std::endl;
+        Sailing::SailingEntity changed = all[1];
+        changed.LRL = running == AsyncIo::Backend::IoUring ? 11.0 : 22.0;
+        bool written = false;
+        std::optional<Sailing::SailingEntity> readBack;
+        Utility::updateRecordAsync<Sailing::SailingEntity>(1, changed, [&](bool ok) {
+            written = ok;
+            Utility::readRecordAsync<Sailing::SailingEntity>(1, [&](std::optional<Sailing::SailingEntity> record) {
+                readBack = record;
+            });
+        });
+        AsyncIo::drain();
+        allTestsPassed &= check(written && readBack && readBack->LRL == changed.LRL &&
+                                strcmp(readBack->sailingID, changed.sailingID) == 0,
+                                "The continuation reads back the record just written");
+        Sailing::SailingEntity again = changed;
+        again.LRL += 1.0;
+        std::optional<Sailing::SailingEntity> waited;
+        Utility::readRecordAsync<Sailing::SailingEntity>(0, [&](std::optional<Sailing::SailingEntity>) {
+            // Both start from a completion; the read's lock is busy until
+            // the update's write completes, which must not be held up.
+            Utility::updateRecordAsync<Sailing::SailingEntity>(1, again, [](bool) {});
+            Utility::readRecordAsync<Sailing::SailingEntity>(1, [&](std::optional<Sailing::SailingEntity> record) {
+                waited = record;
+            });
+        });
+        AsyncIo::drain();
+        allTestsPassed &= check(waited && waited->LRL == again.LRL,
+                                "A read waiting for a pending update's lock gets the updated record");
+        allTestsPassed &= check(AsyncIo::inFlight() == 0, "drain() waits for the continuation too");
+        AsyncIo::shutdown();
+    }
+
+    // --- TEST CASE 9: PREALLOCATION ---
+    // Appends go into space reserved ahead of the logical end; a delete
+    // moves the end back and keeps the space.
+    std::cout << "\n[TEST CASE 9] Appending into preallocated space..." << std::endl;
+    const char* sailingsPath = Utility::getFilePath<Sailing::SailingEntity>();
+    long long before = Utility::recordCount<Sailing::SailingEntity>();
+    Sailing::createSailing("NEWBOAT", "TSA-04");
+    auto allocated = std::filesystem::file_size(sailingsPath);
+    allTestsPassed &= check(Utility::recordCount<Sailing::SailingEntity>() == before + 1 &&
+                            allocated >= static_cast<uintmax_t>(Utility::PREALLOCATE_MIN_BYTES),
+                            "The file is preallocated beyond its records");
+    Sailing::deleteSailing("TSA-04");
+    allTestsPassed &= check(Utility::recordCount<Sailing::SailingEntity>() == before &&
+                            Utility::readAllRecords<Sailing::SailingEntity>().size() == static_cast<size_t>(before) &&
+                            std::filesystem::file_size(sailingsPath) == allocated,
+                            "A delete moves the logical end back and keeps the space");
+
+    // --- TEST CASE 10: READ-ONLY REPLICA ---
+    // The mapped replica must report what the module does, and see later
+    // writes (including appends past what it first mapped).
+    std::cout << "\n[TEST CASE 10] Reading reports from the mapped replica..." << std::endl;
+    std::string replicaError;
+    allTestsPassed &= check(ReportReplica::open(replicaError), "The replica maps the sailings file");
+    auto mapped = ReportReplica::getSailingReport(0);
+    auto module = Sailing::getSailings(0);
+    allTestsPassed &= check(mapped.size() == module.size() &&
+                            std::equal(mapped.begin(), mapped.end(), module.begin()),
+                            "The replica's report matches the module's");
+    for (int i = 0; i < 2000; i++) Sailing::createSailing("NEWBOAT", "R-" + std::to_string(i));
+    Sailing::decreaseLRL("R-7", 12.5);
+    auto r7 = ReportReplica::queryIndividualSailing("R-7");
+    allTestsPassed &= check(ReportReplica::getSailingReport(0).size() == module.size() + 2000 &&
+                            r7.has_value() && r7->LRL == Sailing::getSailing("R-7")->LRL,
+                            "The replica sees later appends and updates");
+    ReportReplica::close();
+
+    // --- TEST CASE 11: BATCHED UPDATES ---
+    // Several updates to one position in a batch: the last given is the
+    // one written, however many the batch holds.
+    std::cout << "\n[TEST CASE 11] Updating records in one batched call..." << std::endl;
+    std::vector<std::pair<int, Sailing::SailingEntity>> updates;
+    for (int round = 0; round < 3; round++) {
+        for (int position = 0; position < 40; position++) {
+            Sailing::SailingEntity record = *Utility::readRecord<Sailing::SailingEntity>(position);
+            record.LRL = round;
+            updates.push_back({ position, record });
+        }
+    }
+    Utility::updateRecords<Sailing::SailingEntity>(updates);
+    bool lastWins = true;
+    for (int position = 0; position < 40; position++) {
+        auto record = Utility::readRecord<Sailing::SailingEntity>(position);
+        lastWins = lastWins && record.has_value() && record->LRL == 2.0;
+    }
+    allTestsPassed &= check(lastWins, "updateRecords() writes the last update to each position");
+
     // --- SHUTDOWN ---
     Sailing::shutdown();
     Vessel::shutdown();